@@ -0,0 +1,373 @@
+#!/usr/bin/env python3
+#
+# offline tuning of the position loop of the rio component (pgain, ff1gain, deadband)
+#
+# runs the loop of update_freq() (generators/linuxcnc_component/rio_loop.h, built with gcc
+# and loaded with ctypes) against a plant model with the transport delay of the timing model (timing.py),
+# with --component the generated rio.c itself (rio.update-freq and rio.readwrite, built against
+# the HAL, RTAPI and libftdi mocks of tests/mock):
+#   stepper: the step frequency of joint_stepper (integer divider), feedback in whole steps
+#   pwmdir:  dc motor with encoder, velocity = kv * pwm value, first order (tau), feedback in counts
+# the test move goes forward and back with the velocity, acceleration and jerk limits,
+# the gains with the smallest following error are printed as HAL snippet
+#
+#   python3 autotune.py configs/TangNano9K/config.json --joint 0
+#   python3 autotune.py CONFIG --joint 2 --plant pwmdir --kv 0.8 --tau 0.02 --umax 100000
+#   python3 autotune.py configs/TangNano9K/config.json --joint 0 --component
+#
+
+import argparse
+import contextlib
+import ctypes
+import io
+import json
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+import projectLoader
+
+# rio.c: max_freq = PRU_BASEFREQ / 2
+PRU_BASEFREQ = 100000000
+
+# plant substeps per servo period
+SUBSTEPS = 20
+
+# tune_start(scale, maxaccel, pgain, ff1gain, deadband, period) and tune_step(command, counts, period) -> frequency:
+# the loop of update_freq() for one joint, the counts are the feedback of the last rio_readwrite()
+LOOP_SOURCE = """
+#include <math.h>
+#include <stdint.h>
+#include "rio_loop.h"
+
+#define PRU_BASEFREQ %d
+
+// the types of rio.c (data_t: freq, prev_cmd and cmd_d are float)
+static double scale, max_freq, dv;
+static float freq, prev_cmd, cmd_d;
+static float pgain, ff1gain, deadband;
+
+int tune_start(double pos_scale, double maxaccel, double pgain_, double ff1gain_, double deadband_, long period)
+{
+    double dt = period * 0.000000001;
+    double max_ac;
+    scale = pos_scale;
+    // rio.c: maxvel is no hal parameter (0), only the limit of the gateware
+    max_freq = PRU_BASEFREQ / 2.0;
+    max_ac = max_freq * (1.0 / dt);
+    if (maxaccel > 0.0 && maxaccel * fabs(scale) <= max_ac) {
+        max_ac = maxaccel * fabs(scale);
+    }
+    dv = max_ac * dt;
+    pgain = pgain_;
+    ff1gain = ff1gain_;
+    deadband = deadband_;
+    freq = 0.0;
+    prev_cmd = 0.0;
+    return 0;
+}
+
+double tune_step(double command, int32_t counts, long period)
+{
+    // rio_readwrite(): relative feedback, float pin
+    double feedback = (float)((counts + 0.5) / scale);
+    cmd_d = (command - prev_cmd) * (1.0 / (period * 0.000000001));
+    prev_cmd = command;
+    freq = loop_limit(loop_position(command, feedback, cmd_d, pgain, ff1gain, deadband) * scale, freq, max_freq, dv);
+    return freq;
+}
+"""
+
+# the same interface on the generated rio.c (one joint, the transfer answers the counts as jointFeedback)
+COMPONENT_SOURCE = """
+#include "rio.c"
+
+#define TUNE_JOINT %d
+
+static hal_float_t *tune_cmd, *tune_freq;
+
+static void tune_float(const char *name, double value)
+{
+    *(hal_float_t *)mock_hal_find(name) = value;
+}
+
+int tune_start(double pos_scale, double maxaccel, double pgain, double ff1gain, double deadband, long period)
+{
+    char name[HAL_NAME_LEN + 1];
+    int n;
+    if (tune_cmd == NULL) {
+        layout_check = 0;
+        if (rtapi_app_main() < 0) {
+            return -1;
+        }
+        snprintf(name, sizeof(name), "rio.joint.%%d.pos-cmd", TUNE_JOINT);
+        tune_cmd = mock_hal_find(name);
+        snprintf(name, sizeof(name), "rio.joint.%%d.freq-cmd", TUNE_JOINT);
+        tune_freq = mock_hal_find(name);
+    }
+    *(hal_bit_t *)mock_hal_find("rio.SPI-enable") = 1;
+    *(hal_bit_t *)mock_hal_find("rio.SPI-status") = 1;
+    for (n = 0; n < JOINTS; n++) {
+        snprintf(name, sizeof(name), "rio.joint.%%d.enable", n);
+        *(hal_bit_t *)mock_hal_find(name) = 1;
+    }
+    snprintf(name, sizeof(name), "rio.joint.%%d.scale", TUNE_JOINT);
+    tune_float(name, pos_scale);
+    snprintf(name, sizeof(name), "rio.joint.%%d.fb-scale", TUNE_JOINT);
+    tune_float(name, pos_scale);
+    snprintf(name, sizeof(name), "rio.joint.%%d.maxaccel", TUNE_JOINT);
+    tune_float(name, maxaccel);
+    snprintf(name, sizeof(name), "rio.joint.%%d.pgain", TUNE_JOINT);
+    tune_float(name, pgain);
+    snprintf(name, sizeof(name), "rio.joint.%%d.ff1gain", TUNE_JOINT);
+    tune_float(name, ff1gain);
+    snprintf(name, sizeof(name), "rio.joint.%%d.deadband", TUNE_JOINT);
+    tune_float(name, deadband);
+    *tune_cmd = 0.0;
+    data->freq[TUNE_JOINT] = 0.0;
+    data->prev_cmd[TUNE_JOINT] = 0.0;
+    accum[TUNE_JOINT] = 0;
+    old_count[TUNE_JOINT] = 0;
+    return 0;
+}
+
+double tune_step(double command, int32_t counts, long period)
+{
+    rxData_t answer = {0};
+    answer.header = PRU_DATA;
+    answer.jointFeedback[TUNE_JOINT] = counts;
+    memcpy(mock_answer, answer.rxBuffer, SPIBUFSIZE);
+    mock_log_len = 0;
+    mock_mosi_len = 0;
+    mock_queue_len = 0;
+    mock_queue_pos = 0;
+    mock_rtapi_time += period;
+    // the answer of the last period, then the command of this one
+    mock_hal_call("rio.readwrite", period);
+    *tune_cmd = command;
+    mock_hal_call("rio.update-freq", period);
+    return *tune_freq;
+}
+"""
+
+
+def _load(path):
+    lib = ctypes.CDLL(path)
+    lib.tune_start.restype = ctypes.c_int
+    lib.tune_start.argtypes = [ctypes.c_double] * 5 + [ctypes.c_long]
+    lib.tune_step.restype = ctypes.c_double
+    lib.tune_step.argtypes = [ctypes.c_double, ctypes.c_int32, ctypes.c_long]
+    return lib
+
+
+def build_loop(path=None):
+    """rio_loop.h as shared library"""
+    if path is None:
+        path = os.path.join(tempfile.mkdtemp(), "rio_loop.so")
+    include = os.path.join(os.path.dirname(os.path.abspath(__file__)), "generators", "linuxcnc_component")
+    subprocess.run(
+        ["gcc", "-O2", "-shared", "-fPIC", "-I", include, "-x", "c", "-", "-o", path, "-lm"],
+        input=LOOP_SOURCE % PRU_BASEFREQ,
+        text=True,
+        check=True,
+    )
+    return _load(path)
+
+
+def build_component(config, joint=0, path=None):
+    """the generated rio.c of the config as shared library (MPSSE transport on the libftdi mock)"""
+    workdir = tempfile.mkdtemp()
+    if path is None:
+        path = os.path.join(workdir, "rio_component.so")
+    with open(config) as ifile:
+        jdata = json.load(ifile)
+    jdata["transport"] = "MPSSE"
+    jdata.pop("fpga_load", None)
+    with open(os.path.join(workdir, "config.json"), "w") as ofile:
+        ofile.write(json.dumps(jdata))
+    with contextlib.redirect_stdout(io.StringIO()):
+        project = projectLoader.load(os.path.join(workdir, "config.json"))
+        project["LINUXCNC_PATH"] = workdir
+        os.makedirs(os.path.join(workdir, "Components"))
+        project["generators"]["linuxcnc_component"].generate(project)
+    mock = os.path.join(os.path.dirname(os.path.abspath(__file__)), "tests", "mock")
+    subprocess.run(
+        ["gcc", "-O2", "-shared", "-fPIC", "-I", mock, "-I", os.path.join(workdir, "Components"), "-x", "c", "-", "-o", path, "-lm"],
+        input=COMPONENT_SOURCE % joint,
+        text=True,
+        check=True,
+    )
+    return _load(path)
+
+
+def trajectory(distance, vmax, amax, jmax, period, hold=0.2):
+    """positions per servo period: forward and back, trapezoidal velocity smoothed to the jerk limit"""
+    ramp = vmax / amax
+    if distance < vmax * ramp:
+        vmax = math.sqrt(distance * amax)
+        ramp = vmax / amax
+    cruise = distance / vmax - ramp
+    # the box filter of the velocity limits the jerk to amax / window
+    window = max(int(round(amax / jmax / period)), 1)
+    velocities = []
+    for direction in (1.0, -1.0):
+        move = int(math.ceil((2.0 * ramp + cruise) / period))
+        for num in range(move):
+            t = num * period
+            v = min(amax * t, vmax, amax * (2.0 * ramp + cruise - t))
+            velocities.append(direction * max(v, 0.0))
+        velocities += [0.0] * int(hold / period)
+    smooth = []
+    total = 0.0
+    for num, v in enumerate(velocities):
+        total += v
+        if num >= window:
+            total -= velocities[num - window]
+        smooth.append(total / window)
+    positions = []
+    position = 0.0
+    for v in smooth + [0.0] * window:
+        position += v * period
+        positions.append(position)
+    return positions
+
+
+def simulate(lib, joint, gains, positions, period, transfer, plant):
+    """following error (max, at the end) of the loop of update_freq() against the plant"""
+    pgain, ff1gain, deadband = gains
+    scale = joint["scale"]
+    osc = joint["clock"]
+    period_ns = int(round(period * 1000000000.0))
+    if lib.tune_start(scale, joint["maxaccel"], pgain, ff1gain, deadband, period_ns) < 0:
+        raise RuntimeError("rio component: rtapi_app_main() failed")
+
+    freq = 0.0
+    steps = 0.0
+    velocity = 0.0
+    active = 0.0
+    counts = 0
+    max_error = 0.0
+    # the command of a period is applied after the transfer, the feedback is sampled at the transfer
+    delay = min(int(round(transfer / period * SUBSTEPS)), SUBSTEPS - 1)
+    dt = period / SUBSTEPS
+    for command in positions:
+        # following error at the sample time of the command
+        max_error = max(max_error, abs(command - steps / scale))
+        freq = lib.tune_step(command, counts, period_ns)
+        for sub in range(SUBSTEPS):
+            if sub == delay:
+                counts = math.floor(steps)
+                if plant["type"] == "stepper":
+                    # joint_stepper: the divider (rio.c: PRU_OSC / freq / 2) toggles every divider + 1 clocks
+                    divider = int(osc / abs(freq) / 2) if abs(freq) >= 1.0 else 0
+                    active = math.copysign(osc / (2.0 * (divider + 1)), freq) if divider else 0.0
+                else:
+                    active = max(min(freq, plant["umax"]), -plant["umax"])
+            if plant["type"] == "stepper":
+                velocity = active
+            else:
+                velocity += (plant["kv"] * active - velocity) * dt / plant["tau"]
+            steps += velocity * dt
+    return max_error, abs(positions[-1] - steps / scale)
+
+
+def cost(result, deadband):
+    max_error, end_error = result
+    # the joint has to come to rest inside the deadband
+    return max_error + 10.0 * max(end_error - deadband, 0.0)
+
+
+def tune(lib, joint, period, transfer, plant, positions):
+    """coordinate search: pgain (log grid), ff1gain, deadband, pgain again"""
+    latency = period + transfer
+    step = 1.0 / abs(joint["scale"])
+    pgains = [10.0 * (4.0 / latency / 10.0) ** (num / 23.0) for num in range(24)]
+    ff1gains = [0.5 + num * 0.025 for num in range(41)]
+    deadbands = [step * 0.5, step, step * 2.0]
+    best = [pgains[0], 1.0, step]
+    runs = 0
+
+    def score(gains):
+        nonlocal runs
+        runs += 1
+        return cost(simulate(lib, joint, gains, positions, period, transfer, plant), gains[2])
+
+    best_cost = score(best)
+    for index, values in ((0, pgains), (1, ff1gains), (2, deadbands), (0, None)):
+        if values is None:
+            # fine grid around the pgain with the final ff1gain and deadband
+            values = [best[0] * (0.8 + num * 0.05) for num in range(9)]
+        for value in values:
+            gains = list(best)
+            gains[index] = value
+            result = score(gains)
+            if result < best_cost:
+                best, best_cost = gains, result
+    max_error, end_error = simulate(lib, joint, best, positions, period, transfer, plant)
+    return {"pgain": best[0], "ff1gain": best[1], "deadband": best[2], "ferror": max_error, "end_error": end_error, "runs": runs}
+
+
+def joint_setup(project, num, args):
+    joint = project["jointnames"][num]
+    return {
+        "scale": float(args.scale or joint.get("scale", 800.0)),
+        "maxvel": float(args.vmax or joint.get("max_velocity", 40)),
+        "maxaccel": float(joint.get("stepgen_maxaccel", 4000.0)),
+        "clock": int(project["jdata"]["clock"]["speed"]),
+    }
+
+
+def hal_snippet(num, result, joint, model, plant):
+    return "\n".join(
+        [
+            f"# autotune.py: joint {num} ({plant['type']}), servo period {model['servo_period'] // 1000}us, latency {model['latency'] * 1000:.2f}ms",
+            f"# max following error {result['ferror']:.6f}, at the end {result['end_error']:.6f} (scale {joint['scale']})",
+            f"setp rio.joint.{num}.pgain {result['pgain']:.1f}",
+            f"setp rio.joint.{num}.ff1gain {result['ff1gain']:.3f}",
+            f"setp rio.joint.{num}.deadband {result['deadband']:.6f}",
+            "",
+        ]
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(description="rio position loop tuning (offline)")
+    parser.add_argument("config", help="config.json")
+    parser.add_argument("--joint", type=int, default=0, help="joint number")
+    parser.add_argument("--plant", choices=("stepper", "pwmdir"), default="stepper", help="plant model")
+    parser.add_argument("--scale", type=float, help="steps/counts per unit (default: joint scale)")
+    parser.add_argument("--vmax", type=float, help="units/s (default: joint max_velocity)")
+    parser.add_argument("--amax", type=float, help="units/s^2 (default: joint max_acceleration)")
+    parser.add_argument("--jmax", type=float, help="units/s^3 (default: 10 * amax)")
+    parser.add_argument("--distance", type=float, help="length of the test move (default: 2s at vmax)")
+    parser.add_argument("--kv", type=float, default=1.0, help="pwmdir: counts/s per pwm value (rio.c sends the frequency as pwm value)")
+    parser.add_argument("--tau", type=float, default=0.02, help="pwmdir: motor time constant (s)")
+    parser.add_argument("--umax", type=float, default=100000.0, help="pwmdir: max pwm value (joint_pwmdir: pwm_freq)")
+    parser.add_argument("--component", action="store_true", help="run the generated rio.c (HAL/libftdi mocks) instead of rio_loop.h")
+    args = parser.parse_args()
+
+    project = projectLoader.load(args.config)
+    if args.joint >= len(project["jointnames"]):
+        print(f"ERROR: joint {args.joint} not found")
+        sys.exit(1)
+    model = project["timing"]
+    period = model["servo_period"] / 1000000000.0
+    joint = joint_setup(project, args.joint, args)
+    amax = float(args.amax or project["jointnames"][args.joint].get("max_acceleration", 70))
+    jmax = float(args.jmax or amax * 10.0)
+    distance = float(args.distance or joint["maxvel"] * 2.0)
+    plant = {"type": args.plant, "kv": args.kv, "tau": args.tau, "umax": args.umax}
+
+    if args.component:
+        lib = build_component(args.config, args.joint)
+    else:
+        lib = build_loop()
+    positions = trajectory(distance, joint["maxvel"], amax, jmax, period)
+    result = tune(lib, joint, period, model["transfer_time"], plant, positions)
+    print(hal_snippet(args.joint, result, joint, model, plant))
+
+
+if __name__ == "__main__":
+    main()
@@ -1,30 +1,71 @@
 #!/usr/bin/python
 #
+# pins per package with bank, global clock input (gbin) and differential partner (pair), see chipdb.py
+#   bank from the io tile position: 0 top, 1 right, 2 bottom, 3 left
+#   lvds inputs are on bank 3, both pins of one io tile
+#
+#   python3 chipdata/icebox_chipdb2chipdata_pinlist.py [/opt/oss-cad-suite/share/icebox] > chipdata/ice40.json
 #
 
 
 import json
+import sys
 
+CHIPS = ["1k", "384", "5k", "8k", "lm4k", "u4k"]
 
-packages = {}
-
-for chip in ["1k", "384", "5k", "8k", "lm4k", "u4k"]:
 
-    source = open(f"/opt/oss-cad-suite/share/icebox/chipdb-{chip}.txt").read()
-    
-    packages[chip] = {}
+def convert(source):
+    """chipdb-CHIP.txt -> {package: {pin: attributes}}"""
+    packages = {}
 
+    locations = {}
+    gbufpins = {}
+    section = ""
     package = ""
     for line in source.split("\n"):
         if line.startswith(".pins "):
+            section = "pins"
             package = line.split()[1]
-            packages[chip][package] = []
+            locations[package] = {}
+        elif line.startswith(".gbufpin"):
+            section = "gbufpin"
         elif line.startswith("."):
-            package = ""
-        elif package and line:
-            packages[chip][package].append(line.split()[0])
-            
+            section = ""
+        elif section == "pins" and line:
+            pin, x, y, z = line.split()[:4]
+            locations[package][pin] = (int(x), int(y), int(z))
+        elif section == "gbufpin" and line:
+            x, y, z, glb = line.split()[:4]
+            gbufpins[(int(x), int(y), int(z))] = int(glb)
 
-print(json.dumps(packages, indent=4))
+    max_x = max(loc[0] for pins in locations.values() for loc in pins.values())
+    max_y = max(loc[1] for pins in locations.values() for loc in pins.values())
+    for package, pins in locations.items():
+        packages[package] = {}
+        tiles = {}
+        for pin, (x, y, z) in pins.items():
+            tiles.setdefault((x, y), {})[z] = pin
+        for pin, (x, y, z) in pins.items():
+            if y == max_y:
+                bank = 0
+            elif x == max_x:
+                bank = 1
+            elif y == 0:
+                bank = 2
+            else:
+                bank = 3
+            attrs = {"bank": bank}
+            if (x, y, z) in gbufpins:
+                attrs["gbin"] = gbufpins[(x, y, z)]
+            if bank == 3 and 1 - z in tiles[(x, y)]:
+                attrs["pair"] = tiles[(x, y)][1 - z]
+            packages[package][pin] = attrs
+    return packages
 
 
+if __name__ == "__main__":
+    icebox = sys.argv[1] if len(sys.argv) > 1 else "/opt/oss-cad-suite/share/icebox"
+    packages = {}
+    for chip in CHIPS:
+        packages[chip] = convert(open(f"{icebox}/chipdb-{chip}.txt").read())
+    print(json.dumps(packages, indent=4))
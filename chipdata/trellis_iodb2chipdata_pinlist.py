@@ -1,19 +1,44 @@
 #!/usr/bin/python
 #
+# pins per package with bank, global clock input (gbin) and differential partner (pair), see chipdb.py
+#   gbin: PCLK pins (primary clock inputs), pair: pio A/B and C/D of the same location
+#
+#   python3 chipdata/trellis_iodb2chipdata_pinlist.py [/opt/oss-cad-suite/share/trellis/database] > chipdata/ecp5.json
 #
 
 
 import json
+import sys
 
-packages = {}
-for chip in ["LFE5U-12F", "LFE5U-45F", "LFE5UM-25F", "LFE5UM5G-25F", "LFE5UM5G-85F", "LFE5U-25F", "LFE5U-85F", "LFE5UM-45F", "LFE5UM5G-45F", "LFE5UM-85F"]:
-    source = json.loads(open(f"/opt/oss-cad-suite/share/trellis/database/ECP5/{chip}/iodb.json").read())
-    packages[chip] = {}
-    for package in source["packages"]:
-        packages[chip][package] = []
-        for pin in source["packages"][package]:
-            packages[chip][package].append(pin)
+CHIPS = ["LFE5U-12F", "LFE5U-45F", "LFE5UM-25F", "LFE5UM5G-25F", "LFE5UM5G-85F", "LFE5U-25F", "LFE5U-85F", "LFE5UM-45F", "LFE5UM5G-45F", "LFE5UM-85F"]
 
-print(json.dumps(packages, indent=4))
+
+def convert(source):
+    """iodb.json (parsed) -> {package: {pin: attributes}}"""
+    packages = {}
+    metadata = {}
+    for pio in source["pio_metadata"]:
+        metadata[(pio["col"], pio["row"], pio["pio"])] = pio
+    for package in source["packages"]:
+        packages[package] = {}
+        locations = {}
+        for pin, loc in source["packages"][package].items():
+            locations[(loc["col"], loc["row"], loc["pio"])] = pin
+        for pin, loc in source["packages"][package].items():
+            pio = metadata.get((loc["col"], loc["row"], loc["pio"]), {})
+            attrs = {"bank": pio.get("bank")}
+            if "PCLK" in pio.get("function", ""):
+                attrs["gbin"] = pio["function"]
+            partner = {"A": "B", "B": "A", "C": "D", "D": "C"}.get(loc["pio"])
+            if (loc["col"], loc["row"], partner) in locations:
+                attrs["pair"] = locations[(loc["col"], loc["row"], partner)]
+            packages[package][pin] = attrs
+    return packages
 
 
+if __name__ == "__main__":
+    database = sys.argv[1] if len(sys.argv) > 1 else "/opt/oss-cad-suite/share/trellis/database"
+    packages = {}
+    for chip in CHIPS:
+        packages[chip] = convert(json.loads(open(f"{database}/ECP5/{chip}/iodb.json").read()))
+    print(json.dumps(packages, indent=4))
@@ -0,0 +1,158 @@
+#
+# chip database (chipdata/FAMILY.json) and pin solver
+#
+# the pins of a package are indexed once per chip: pin -> bank, global clock input (gbin), differential partner (pair)
+#   chipdata/icebox_chipdb2chipdata_pinlist.py and trellis_iodb2chipdata_pinlist.py write these attributes,
+#   older chipdata with plain pin lists has no banks (one bank: None)
+#
+# solve() checks the pins of the project (double assigned pins, pins that are not in the package)
+# and assigns the pins set to "auto" to free pins of the package:
+#   the clock input gets a global clock input (error without gbin data), the interface (spi/uart/udp) the bank of the clock input,
+#   the pins of one plugin stay together in one bank (in pin order) if it has enough free pins
+#
+
+import functools
+import json
+import os
+import re
+
+AUTO = "auto"
+
+# jdata type -> chipdata chip (and package suffix)
+CHIPTYPES = {
+    "25k": ("LFE5U-25F", ""),
+    "45k": ("LFE5U-45F", ""),
+    "85k": ("LFE5U-85F", ""),
+    "up5k": ("5k", ""),
+    "hx1k": ("1k", ""),
+    "lp1k": ("1k", ""),
+    "hx4k": ("8k", ":4k"),
+    "hx8k": ("8k", ""),
+    "lp8k": ("8k", ""),
+}
+
+
+def pin_key(pin):
+    """natural order: A2 < A10, 9 < 10"""
+    return [int(part) if part.isdigit() else part for part in re.split(r"(\d+)", str(pin))]
+
+
+@functools.lru_cache(maxsize=None)
+def _chipdata(family):
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "chipdata", f"{family}.json")
+    if not os.path.isfile(path):
+        return None
+    return json.loads(open(path, "r").read())
+
+
+class ChipDB:
+    def __init__(self, pins):
+        self.pins = {}
+        self.banks = {}
+        self.gbin = []
+        for pin in sorted(pins, key=pin_key):
+            attrs = pins[pin] or {}
+            self.pins[pin] = attrs
+            self.banks.setdefault(attrs.get("bank"), []).append(pin)
+            if attrs.get("gbin") is not None:
+                self.gbin.append(pin)
+
+    def bank(self, pin):
+        return self.pins.get(pin, {}).get("bank")
+
+    def pair(self, pin):
+        return self.pins.get(pin, {}).get("pair")
+
+
+@functools.lru_cache(maxsize=None)
+def _load(family, ftype, package):
+    chipdata = _chipdata(family)
+    if chipdata is None or not package:
+        return None
+    chip, suffix = CHIPTYPES.get(ftype, (ftype, ""))
+    pins = chipdata.get(chip, {}).get(f"{package}{suffix}")
+    if pins is None:
+        return None
+    if isinstance(pins, list):
+        pins = {pin: {} for pin in pins}
+    return ChipDB(pins)
+
+
+def load(jdata):
+    """indexed pins of the package of the config (None: no chipdata)"""
+    return _load(jdata.get("family", ""), jdata.get("type", ""), jdata.get("package", ""))
+
+
+def solve(project):
+    """checks the pinlists and assigns the auto pins, returns the list of errors"""
+    db = load(project["jdata"])
+    errors = []
+    used = {}
+    auto = []
+    for group, pinlist in project["pinlists"].items():
+        for num, pinsetup in enumerate(pinlist):
+            pin_id = pinsetup[1]
+            if pin_id.startswith("EXPANSION"):
+                continue
+            if pin_id == AUTO:
+                auto.append((group, num))
+            elif pin_id in used:
+                errors.append(f"pin {pin_id} allready in use\n  old: {used[pin_id]}\n  new: {pinsetup}")
+            else:
+                used[pin_id] = pinsetup
+                if db is not None and pin_id not in db.pins:
+                    errors.append(f"pin {pin_id} ({pinsetup[0]}) is not in package {project['jdata']['package']}")
+
+    if not auto or errors:
+        return errors
+    if db is None:
+        return [f"no chipdata for {project['jdata'].get('family')} {project['jdata'].get('type')} {project['jdata'].get('package')}, pins can not be set to '{AUTO}'"]
+
+    free = {bank: [pin for pin in pins if pin not in used] for bank, pins in db.banks.items()}
+
+    def take(pin):
+        free[db.bank(pin)].remove(pin)
+        return pin
+
+    # bank of the clock input, the interface is placed next to it
+    clock_bank = None
+    for pinsetup in project["pinlists"].get("main", ()):
+        if pinsetup[1] != AUTO:
+            clock_bank = db.bank(pinsetup[1])
+
+    def assign(group, num, pin):
+        pinlist = list(project["pinlists"][group])
+        pinlist[num] = (pinlist[num][0], pin) + tuple(pinlist[num][2:])
+        project["pinlists"][group] = pinlist
+        print(f"pin auto: {pinlist[num][0]} -> {pin}")
+
+    # clock input on a global clock input (no fallback to an other pin)
+    for group, num in [entry for entry in auto if entry[0] == "main"]:
+        if not db.gbin:
+            errors.append(f"no global clock input data for package {project['jdata']['package']}, {project['pinlists'][group][num][0]} can not be '{AUTO}'")
+            continue
+        gbin = [pin for pin in db.gbin if pin in free[db.bank(pin)]]
+        if not gbin:
+            errors.append(f"no free global clock input for {project['pinlists'][group][num][0]}")
+            continue
+        pin = take(gbin[0])
+        clock_bank = db.bank(pin)
+        assign(group, num, pin)
+
+    # interfaces first, then the other plugins, the pins of a group in one bank if possible
+    groups = []
+    for group, num in auto:
+        if group != "main" and group not in groups:
+            groups.append(group)
+    groups.sort(key=lambda group: not group.startswith("interface_"))
+    for group in groups:
+        entries = [num for entry_group, num in auto if entry_group == group]
+        banks = sorted(free, key=lambda bank: (bank != clock_bank if group.startswith("interface_") else False, -len(free[bank])))
+        fitting = [bank for bank in banks if len(free[bank]) >= len(entries)]
+        for num in entries:
+            available = [bank for bank in fitting or banks if free[bank]]
+            if not available:
+                errors.append(f"no free pin for {project['pinlists'][group][num][0]}")
+                continue
+            assign(group, num, take(free[available[0]][0]))
+    return errors
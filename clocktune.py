@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+#
+# sysclk sweep: the highest pll frequency that closes timing
+#
+# the config is generated (buildtool.py) and built (Firmware/Makefile: yosys, nextpnr --freq) with the
+# reachable pll frequencies (generators/firmware/pll.py) from --min upwards, the sweep stops at the first
+# frequency that fails timing, with --write the last passing one is written to clock: speed and the config
+# is generated again (gateware dividers and PRU_OSC use the new sysclk)
+#
+#   python3 clocktune.py configs/ICEBreakerV1.0e/config.json --max 100000000
+#   python3 clocktune.py CONFIG --min 48000000 --max 120000000 --step 4000000 --write
+#
+
+import argparse
+import copy
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+import buildtool
+from generators.firmware import pll
+
+FMAX_RE = re.compile(r"Max frequency for clock\s+'([^']*)':\s+([\d.]+) MHz \((PASS|FAIL) at ([\d.]+) MHz\)")
+
+
+def parse_fmax(log):
+    """(fmax in MHz, passed) of sysclk from the nextpnr log, the last report (after routing) counts"""
+    clocks = {}
+    for clock, fmax, state, target in FMAX_RE.findall(log):
+        clocks[clock] = (float(fmax), state == "PASS")
+    for clock, result in clocks.items():
+        # sysclk, not the oscillator input of the pll (sysclk_in)
+        if clock.startswith("sysclk") and not clock.startswith("sysclk_in"):
+            return result
+    if clocks:
+        return list(clocks.values())[0]
+    return None
+
+
+def candidates(jdata, fmin, fmax, step):
+    """reachable pll frequencies in Hz, ascending, at least step apart"""
+    fin = float(jdata["clock"]["osc"]) / 1000000
+    speeds = []
+    for freq in pll.frequencies(jdata["family"], jdata["type"], fin, fmin / 1000000, fmax / 1000000):
+        speed = round(freq * 1000000)
+        if not speeds or speed - speeds[-1] >= step:
+            speeds.append(speed)
+    return speeds
+
+
+def build(jdata, speed, workdir):
+    """generates and builds the config with this sysclk, returns (fmax, passed) or None"""
+    data = copy.deepcopy(jdata)
+    data["clock"]["speed"] = str(speed)
+    config = os.path.join(workdir, f"config-{speed}.json")
+    output = os.path.join(workdir, f"{speed}")
+    open(config, "w").write(json.dumps(data, indent=4))
+    subprocess.run([sys.executable, "buildtool.py", config, output], stdout=subprocess.DEVNULL, check=True)
+    firmware = os.path.join(output, "Firmware")
+    # a failing timing still writes the report (the Makefile of a normal build stops on it)
+    result = subprocess.run(["make", "-C", firmware, "NEXTPNR_EXTRA=--timing-allow-fail"], capture_output=True, text=True)
+    log = result.stdout + result.stderr
+    if os.path.isfile(os.path.join(firmware, "nextpnr.log")):
+        log += open(os.path.join(firmware, "nextpnr.log")).read()
+    return parse_fmax(log)
+
+
+def sweep(speeds, build_func):
+    """successively higher frequencies until one fails, returns the highest passing one (or None)"""
+    best = None
+    for speed in speeds:
+        result = build_func(speed)
+        if result is None:
+            print(f"{speed / 1000000:0.3f} MHz: no timing report")
+            break
+        fmax, passed = result
+        print(f"{speed / 1000000:0.3f} MHz: {'PASS' if passed else 'FAIL'} (fmax: {fmax:0.2f} MHz)")
+        if not passed:
+            break
+        best = speed
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description="rio sysclk sweep (pll + nextpnr)")
+    parser.add_argument("config", help="config.json")
+    parser.add_argument("--min", type=int, help="lowest sysclk in Hz (default: clock speed)")
+    parser.add_argument("--max", type=int, help="highest sysclk in Hz (default: 2 * clock speed)")
+    parser.add_argument("--step", type=int, default=1000000, help="min. distance of the tried frequencies in Hz")
+    parser.add_argument("--workdir", help="build directory (default: temporary)")
+    parser.add_argument("--write", action="store_true", help="write the result to the config and generate it")
+    args = parser.parse_args()
+
+    jdata = json.loads(open(args.config, "r").read())
+    if jdata.get("toolchain") != "icestorm" or not jdata["clock"].get("osc") or jdata["clock"].get("internal"):
+        print("ERROR: the sweep needs the icestorm toolchain and a pll (clock: osc)")
+        sys.exit(1)
+    speed = int(jdata["clock"]["speed"])
+    fmin = args.min or speed
+    fmax = args.max or speed * 2
+    speeds = candidates(jdata, fmin, fmax, args.step)
+    if not speeds:
+        print(f"ERROR: no pll frequency between {fmin} and {fmax} Hz")
+        sys.exit(1)
+
+    workdir = args.workdir or tempfile.mkdtemp(prefix="clocktune-")
+    os.makedirs(workdir, exist_ok=True)
+    best = sweep(speeds, lambda speed: build(jdata, speed, workdir))
+    if best is None:
+        print(f"ERROR: no sysclk closes timing (from {speeds[0]} Hz)")
+        sys.exit(1)
+    print(f"sysclk: {best} Hz")
+
+    if args.write:
+        jdata["clock"]["speed"] = str(best)
+        open(args.config, "w").write(json.dumps(jdata, indent=4) + "\n")
+        buildtool.main(args.config)
+
+
+if __name__ == "__main__":
+    main()
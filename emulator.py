@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+#
+# software emulation of the rio gateware on frame level
+#
+#   steppers integrate the commanded frequency, dc servos follow the position (when enabled)
+#   setPoint values are looped back into the processVariable values
+#   digital outputs are looped back into the digital inputs
+#   the timestamp (optional) is the host time in fpga clock ticks
+#   joint commands with an apply time (optional) are taken over at this tick
+#   slow vins (multi-rate) are answered one per frame, selected by the previous frame
+#   sequence of events (optional): edges of the looped back dins with the tick of the frame
+#   geared steppers only move with the frequency command (the encoders do not move)
+#
+# can be used in-process (soaktest.py --emulator) or as udp server
+# instead of a board/bridge: python3 emulator.py CONFIG [PORT]
+#
+
+import socket
+import sys
+import time
+
+import frameio
+
+
+class Emulator:
+    def __init__(self, layout):
+        self.layout = layout
+        self.frame = frameio.Frame(layout)
+        self.osc = layout["clock"]
+        self.position = [0.0] * len(layout["joints"])
+        self.joint_cmd = [0] * len(layout["joints"])
+        self.joint_enable = [0] * len(layout["joints"])
+        self.setpoints = [0] * len(layout["vouts"])
+        self.outputs = []
+        self.slow_select = 0
+        self.soe_levels = None
+        self.soe_events = []
+        self.soe_seq = 0
+        self.soe_ack = 0
+        self.pending = None
+        self.last = None
+        self.header_rx = 0
+        self.hash = layout.get("hash", frameio.layout_hash(layout))
+        self.frames = 0
+        self.errors = 0
+
+    def move(self, dt):
+        for num, conv in enumerate(self.layout["joints"]):
+            if conv["type"] == "pwmdir" or not self.joint_enable[num]:
+                continue
+            if conv["type"] == "dcservo":
+                # ideal position loop
+                self.position[num] = frameio.cmd_to_joint(conv, self.joint_cmd[num], self.osc)
+                continue
+            self.position[num] += frameio.cmd_to_joint(conv, self.joint_cmd[num], self.osc) * dt
+
+    def update(self, now):
+        # moves the joints with the commands of the last frame
+        if self.last is not None:
+            if self.pending is not None:
+                apply_time, joint_cmd, joint_enable = self.pending
+                # same check as the gateware: tick reached (signed 32bit difference)
+                diff = (int(now * self.osc) - apply_time) & 0xFFFFFFFF
+                if apply_time == 0 or diff < 0x80000000:
+                    applied = max(self.last, now - diff / self.osc) if apply_time else self.last
+                    self.move(applied - self.last)
+                    self.last = applied
+                    self.joint_cmd = joint_cmd
+                    self.joint_enable = joint_enable
+                    self.pending = None
+            self.move(now - self.last)
+        self.last = now
+
+    def soe_edges(self, soe, now):
+        # the outputs are looped back into the dins, every change is an event
+        count = min(len(self.layout["dins"]), len(self.outputs) * 8)
+        levels = self.frame.unpack_bits(self.outputs, count)
+        levels = [levels[num] if num < count else 0 for num in soe["dins"]]
+        if self.soe_levels is not None:
+            for num, level in enumerate(levels):
+                if level != self.soe_levels[num]:
+                    self.soe_events.append((self.soe_seq, int(now * self.osc) & 0xFFFFFFFF, num, level))
+                    self.soe_seq = (self.soe_seq + 1) & 0xFFFF
+        self.soe_levels = levels
+
+    def transfer(self, data, now=None):
+        if now is None:
+            now = time.monotonic()
+        self.update(now)
+        self.frames += 1
+
+        tx_fields = {field["name"]: field for field in self.frame.tx_fields}
+        values = self.frame.tx_struct.unpack(bytes(data[: self.frame.size]))
+        pos = 0
+        request = {}
+        for field in self.frame.tx_fields:
+            request[field["name"]] = list(values[pos : pos + field["count"]])
+            pos += field["count"]
+
+        # like the spi slave, the answer is latched before the new values are applied
+        vins = len(self.layout["vins"])
+        loopback = (self.setpoints + [0] * vins)[:vins]
+        fast, slow = frameio.vin_slots(self.layout)
+        process = [loopback[num] for num in fast]
+        slow_value = 0
+        if self.slow_select < len(slow):
+            slow_value = loopback[slow[self.slow_select]]
+        inputs = [0] * self.frame.rx_fields[-1]["count"]
+        for num in range(min(len(inputs), tx_fields["outputs"]["count"], len(self.outputs))):
+            inputs[num] = self.outputs[num]
+
+        soe = self.layout.get("soe")
+        soe_events = []
+        if soe:
+            # events from the sequence number acknowledged by the previous frame
+            self.soe_events = [event for event in self.soe_events if ((event[0] - self.soe_ack) & 0xFFFF) < 0x8000]
+            for event in self.soe_events[: soe["slots"]]:
+                soe_events += [event[1], (1 << 31) | (event[3] << 30) | (event[2] << 16) | event[0]]
+
+        answer = self.frame.pack_answer(
+            {
+                "header": self.hash if self.header_rx == frameio.PRU_READ else frameio.PRU_DATA,
+                "timestamp": int(now * self.osc) & 0xFFFFFFFF,
+                "jointFeedback": [(int(position) + 0x80000000) % 0x100000000 - 0x80000000 for position in self.position],
+                "processVariable": process,
+                "slowIndex": self.slow_select,
+                "slowValue": slow_value,
+                "soeStatus": self.soe_seq,
+                "soeEvents": soe_events,
+                "inputs": inputs,
+            }
+        )
+
+        # like the interfaces, write frames and read requests are latched, other frames are dropped
+        if request["header"][0] in (frameio.PRU_WRITE, frameio.PRU_READ):
+            self.header_rx = request["header"][0]
+            self.setpoints = request["setPoint"]
+            enable_bytes = request["jointEnable"]
+            joint_enable = [
+                (enable_bytes[num // 8] >> (num % 8)) & 1
+                for num in range(len(self.layout["joints"]))
+            ]
+            if "applyTime" in request:
+                self.pending = (request["applyTime"][0], request["jointFreqCmd"], joint_enable)
+                self.update(now)
+            else:
+                self.joint_cmd = request["jointFreqCmd"]
+                self.joint_enable = joint_enable
+            self.outputs = request["outputs"]
+            if "slowSelect" in request:
+                self.slow_select = request["slowSelect"][0]
+            if soe:
+                self.soe_ack = request["soeAck"][0]
+                self.soe_edges(soe, now)
+        else:
+            self.errors += 1
+
+        return answer
+
+
+def main(configfile, port=2390):
+    import projectLoader
+
+    project = projectLoader.load(configfile)
+    emulator = Emulator(frameio.layout(project))
+
+    sock = socket.socket(family=socket.AF_INET, type=socket.SOCK_DGRAM)
+    sock.bind(("0.0.0.0", port))
+    print(f"emulating {project['jdata']['name']} on udp port {port}")
+    while True:
+        data, address = sock.recvfrom(1500)
+        if len(data) != emulator.frame.size:
+            print(f"ERROR: wrong frame size: {len(data)} (expected: {emulator.frame.size})")
+            continue
+        sock.sendto(emulator.transfer(data), address)
+
+
+if __name__ == "__main__":
+    main(sys.argv[1], int(sys.argv[2]) if len(sys.argv) > 2 else 2390)
@@ -0,0 +1,513 @@
+#
+# frame layout and value conversions shared by the generators and the test tools
+#
+# the layout is described from the host point of view:
+#   tx: host -> fpga (txData_t in rio.h / rx_data in rio.v)
+#   rx: fpga -> host (rxData_t in rio.h / tx_data in rio.v)
+#
+
+import json
+import math
+import struct
+import zlib
+
+PRU_DATA = 0x64617461
+PRU_READ = 0x72656164
+PRU_WRITE = 0x77726974
+PRU_ESTOP = 0x65737470
+
+RCSERVO_OFFSET = 300
+RCSERVO_DIVIDER = 200000
+
+# vout_pwm with "hires": true gets the duty in clock cycles with fractional bits
+PWM_HIRES_FRAC = 16
+
+# vins with "fixed": true are converted by the gateware into Q16.16 user units
+FIXED_ONE = 1 << 16
+FIXED_SOURCES = ("frequency", "time", "adc")
+
+# joint_stepper with "gear": steps per encoder count in Q16.16
+GEAR_FRAC = 16
+
+LAYOUT_VERSION = 1
+
+
+def _num(value):
+    if isinstance(value, str):
+        try:
+            return int(value)
+        except ValueError:
+            return float(value)
+    return value
+
+
+def joint_conversion(joint):
+    if joint.get("type") == "joint_rcservo":
+        return {"type": "rcservo", "feedback": "abs"}
+    elif joint.get("type") == "joint_pwmdir":
+        return {"type": "pwmdir", "feedback": "rel"}
+    elif joint.get("type") == "joint_dcservo":
+        return {"type": "dcservo", "feedback": "abs"}
+    return {"type": "stepper", "feedback": "rel"}
+
+
+def vout_conversion(vout):
+    vtype = vout.get("type")
+    freq = _num(vout.get("frequency", 10000))
+    if vtype == "vout_sine":
+        # frequency in Hz, 30 steps per sine period (vout_sinepwm.v)
+        conv = {"min": vout.get("min", -100), "max": vout.get("max", 100.0), "freq": 30}
+    elif vtype == "vout_pwm":
+        if vout.get("dir"):
+            conv = {"min": 0, "max": vout.get("max", 100.0), "freq": freq}
+        else:
+            conv = {"min": vout.get("min", 0), "max": vout.get("max", 100.0), "freq": freq}
+    elif vtype == "vout_rcservo":
+        conv = {"min": vout.get("min", -100), "max": vout.get("max", 100.0), "freq": _num(vout.get("frequency", 100))}
+    else:
+        conv = {"min": vout.get("min", 0), "max": vout.get("max", 10.0), "freq": freq}
+    conv["min"] = _num(conv["min"])
+    conv["max"] = _num(conv["max"])
+
+    if vtype == "vout_pwm" and vout.get("dir"):
+        conv["type"] = "pwmdir"
+    elif vtype == "vout_frequency":
+        conv["type"] = "frequency"
+    elif vtype == "vout_pwm":
+        conv["type"] = "pwm"
+    elif vtype == "vout_sine":
+        conv["type"] = "sine"
+    elif vtype == "vout_udpoti":
+        conv["type"] = "udpoti"
+    elif vtype == "vout_rcservo":
+        conv["type"] = "rcservo"
+    else:
+        conv["type"] = "raw"
+    if vtype == "vout_pwm" and vout.get("hires"):
+        conv["type"] += "_hires"
+    return conv
+
+
+def _vin_type(vin):
+    vtype = vin.get("type")
+    if vtype == "vin_frequency":
+        return "frequency"
+    elif vtype == "vin_pwmcounter":
+        return "time"
+    elif vtype == "vin_sonar":
+        return "sonar"
+    elif vtype == "vin_ads1115":
+        # continuous mode: with the sample count (bits 16-23)
+        vtype = "ntc" if vin.get("sensor") == "NTC" else "adc"
+        if vin.get("mode") == "continuous":
+            vtype += "_seq"
+        return vtype
+    elif vtype in ("vin_quadencoder", "vin_quadencoderz"):
+        return "encoder"
+    return "raw"
+
+
+def vin_conversion(vin):
+    vtype = _vin_type(vin)
+    if vin.get("fixed") and vtype in FIXED_SOURCES:
+        return {"type": "fixed", "source": vtype, "scale": float(vin.get("fixed_scale", 1.0))}
+    return {"type": vtype}
+
+
+def vin_fixed_params(conv, osc):
+    """parameters of vin_scale.v for a fixed vin (raw value -> Q16.16 user units)"""
+    source = conv["source"]
+    scale = conv["scale"]
+    params = {"RECIPROCAL": 0, "MUL": 0, "MUL_NEG": int(scale < 0), "SHIFT": 0, "NUMERATOR": 0}
+    if source == "frequency":
+        # osc / raw
+        params["RECIPROCAL"] = 1
+        params["NUMERATOR"] = min(round(osc * abs(scale) * FIXED_ONE), (1 << 64) - 1)
+        return params
+    elif source == "time":
+        # 1000 / (osc / raw)
+        factor = 1000.0 / osc
+    else:
+        # adc: raw in mV
+        factor = 1.0 / 1000.0
+    factor = abs(factor * scale) * FIXED_ONE
+    # largest shift that keeps the multiplier in 31 bits
+    shift = 0
+    while shift < 63 and round(factor * (1 << (shift + 1))) < (1 << 31):
+        shift += 1
+    params["MUL"] = round(factor * (1 << shift))
+    params["SHIFT"] = shift
+    return params
+
+
+def layout(project):
+    size = project["data_size"] // 8
+    joints = project["joints"]
+    vouts = project["vouts"]
+    vins = project.get("vins_fast", project["vins"])
+    slow = project.get("vins_slow", [])
+    velocity = project.get("joints_velocity", [])
+    gear = project.get("joints_gear", [])
+    soe = project.get("soe")
+
+    tx_fields = [("header", "i", 1)]
+    if project.get("apply_time"):
+        tx_fields.append(("applyTime", "I", 1))
+    if slow:
+        # multi-rate: the host selects the slow vin of the next answer
+        tx_fields.append(("slowSelect", "I", 1))
+    if soe:
+        # sequence of events: the next expected sequence number (acknowledges the older ones)
+        tx_fields.append(("soeAck", "I", 1))
+    tx_fields.append(("jointFreqCmd", "i", joints))
+    if velocity:
+        # dc servo joints: position in jointFreqCmd, velocity (counts/s) here
+        tx_fields.append(("jointVelCmd", "i", len(velocity)))
+    if gear:
+        # geared stepper joints: steps per encoder count (Q16.16), the frequency command trims the phase
+        tx_fields.append(("jointGearRatio", "i", len(gear)))
+    tx_fields += [
+        ("setPoint", "i", vouts),
+        ("jointEnable", "B", project["joints_en_total"] // 8),
+        ("outputs", "B", project["douts_total"] // 8),
+    ]
+
+    tx = []
+    offset = 0
+    for name, fmt, count in tx_fields:
+        tx.append({"name": name, "offset": offset, "format": fmt, "count": count})
+        offset += struct.calcsize(f"<{count}{fmt}")
+
+    rx_fields = [("header", "i", 1)]
+    if project.get("timestamp"):
+        # optional fields are only part of the frame when enabled
+        rx_fields.append(("timestamp", "I", 1))
+    rx_fields += [
+        ("jointFeedback", "i", joints),
+        ("processVariable", "i", vins),
+    ]
+    if slow:
+        # the slow vin of this answer and its index in the rotation
+        rx_fields += [("slowIndex", "I", 1), ("slowValue", "i", 1)]
+    if soe:
+        # {lost, next sequence number} and per slot: tick, {valid, level, input, sequence number}
+        rx_fields += [("soeStatus", "I", 1), ("soeEvents", "I", soe["slots"] * 2)]
+    rx_fields += [
+        ("inputs", "B", project["dins_total"] // 8),
+    ]
+
+    rx = []
+    offset = 0
+    for name, fmt, count in rx_fields:
+        rx.append({"name": name, "offset": offset, "format": fmt, "count": count})
+        offset += struct.calcsize(f"<{count}{fmt}")
+
+    vins_layout = []
+    for num, vin in enumerate(project["vinnames"]):
+        vins_layout.append({"name": vin["_name"], **vin_conversion(vin)})
+        if num in slow:
+            vins_layout[-1]["divisor"] = int(vin["divisor"])
+            vins_layout[-1]["slow"] = slow.index(num)
+
+    ret = {
+        "version": LAYOUT_VERSION,
+        "size": size,
+        "clock": int(project["jdata"]["clock"]["speed"]),
+        "tx": tx,
+        "rx": rx,
+        "joints": [
+            {"name": joint["_name"], **joint_conversion(joint)}
+            for joint in project["jointnames"]
+        ],
+        "vouts": [
+            {"name": vout["_name"], **vout_conversion(vout)}
+            for vout in project["voutnames"]
+        ],
+        "vins": vins_layout,
+        "douts": [dout["_name"] for dout in project["doutnames"]],
+        "dins": [din["_name"] for din in project["dinnames"]],
+    }
+    for entry in gear:
+        # the encoder vin of a geared joint
+        ret["joints"][entry["joint"]]["gear"] = entry["vin"]
+    if soe:
+        ret["soe"] = {"slots": soe["slots"], "inputs": soe["inputs"], "dins": soe["dins"]}
+    ret["hash"] = layout_hash(ret)
+    return ret
+
+
+def layout_hash(layout):
+    """crc32 (31 bit) of the layout, the gateware answers a PRU_READ request with it in the header"""
+    data = {key: value for key, value in layout.items() if key != "hash"}
+    value = zlib.crc32(json.dumps(data, sort_keys=True).encode()) & 0x7FFFFFFF
+    # never one of the headers
+    if value in (PRU_DATA, PRU_ESTOP):
+        value ^= 1
+    return value
+
+
+def vin_slots(layout):
+    """fast vins (index in processVariable) and slow vins (index in the rotation), as lists of vin numbers"""
+    fast = [num for num, vin in enumerate(layout["vins"]) if "slow" not in vin]
+    slow = sorted((vin["slow"], num) for num, vin in enumerate(layout["vins"]) if "slow" in vin)
+    return fast, [num for _index, num in slow]
+
+
+def slow_schedule(due, divisors, cycle):
+    """earliest deadline first: the slow vin for this cycle, due is updated in place"""
+    select = min(range(len(due)), key=lambda index: (due[index], index))
+    due[select] = cycle + divisors[select]
+    return select
+
+
+def soe_decode(words, expected):
+    """valid events of the slots in sequence order, starting at the expected sequence number"""
+    events = []
+    for slot in range(0, len(words), 2):
+        tick, info = words[slot], words[slot + 1]
+        if info >> 31 and (info & 0xFFFF) == expected:
+            events.append({"seq": expected, "tick": tick, "input": (info >> 16) & 0xFF, "level": (info >> 30) & 1})
+            expected = (expected + 1) & 0xFFFF
+    return events, expected
+
+
+def layout_json(project):
+    return json.dumps(layout(project), indent=4)
+
+
+def field_offsets(fields):
+    return {field["name"]: field["offset"] for field in fields}
+
+
+def _int32(value):
+    return max(min(int(value), 0x7FFFFFFF), -0x7FFFFFFF)
+
+
+def joint_to_cmd(conv, freq, osc):
+    # dcservo: position in counts
+    if conv["type"] in ("pwmdir", "dcservo"):
+        return _int32(freq)
+    if freq == 0:
+        return 0
+    if conv["type"] == "stepper":
+        return _int32(osc / freq / 2)
+    return _int32(osc / freq)
+
+
+def gear_to_cmd(ratio):
+    # steps per encoder count (float) -> jointGearRatio
+    return _int32(math.floor(ratio * (1 << GEAR_FRAC) + 0.5))
+
+
+def cmd_to_joint(conv, cmd, osc):
+    # inverse of joint_to_cmd (used by the emulator)
+    if conv["type"] in ("pwmdir", "dcservo"):
+        return float(cmd)
+    if cmd == 0:
+        return 0.0
+    if conv["type"] == "stepper":
+        return osc / cmd / 2
+    return osc / cmd
+
+
+def vout_to_setpoint(conv, value, osc):
+    vtype = conv["type"]
+    if vtype == "sine":
+        if value == 0:
+            return 0
+        return _int32(osc / value / conv["freq"])
+    elif vtype == "pwmdir":
+        value = max(min(value, conv["max"]), -conv["max"])
+        return _int32(value * (osc / conv["freq"]) / conv["max"])
+    elif vtype == "pwm":
+        value = max(min(value, conv["max"]), conv["min"])
+        return _int32((value - conv["min"]) * (osc / conv["freq"]) / (conv["max"] - conv["min"]))
+    elif vtype == "pwmdir_hires":
+        value = max(min(value, conv["max"]), -conv["max"])
+        return _int32(math.floor(value * (osc / conv["freq"]) * (1 << PWM_HIRES_FRAC) / conv["max"] + 0.5))
+    elif vtype == "pwm_hires":
+        value = max(min(value, conv["max"]), conv["min"])
+        return _int32(math.floor((value - conv["min"]) * (osc / conv["freq"]) * (1 << PWM_HIRES_FRAC) / (conv["max"] - conv["min"]) + 0.5))
+    elif vtype == "rcservo":
+        return _int32((value + RCSERVO_OFFSET) * (osc // RCSERVO_DIVIDER))
+    elif vtype == "frequency":
+        if value == 0:
+            return 0
+        return _int32(osc / value)
+    return _int32(value)
+
+
+def vin_from_raw(conv, raw, osc):
+    vtype = conv["type"]
+    value = float(raw)
+    if vtype == "fixed":
+        value /= FIXED_ONE
+    elif vtype == "frequency":
+        if value != 0:
+            value = osc / value
+    elif vtype == "time":
+        if value != 0:
+            value = 1000.0 / (osc / value)
+    elif vtype == "sonar":
+        if value != 0:
+            value = 1000.0 / osc / 20.0 * value * 343.2
+    elif vtype in ("adc", "ntc", "adc_seq", "ntc_seq"):
+        # bits 16-23: sample count (vin_ads1115 continuous mode, positive values only)
+        if vtype.endswith("_seq") and raw > 0:
+            value = float(int(raw) & 0xFFFF)
+        value /= 1000.0
+        if vtype.startswith("ntc"):
+            rt = 10.0 * value / (3.3 - value)
+            value = 1.0 / (math.log(rt / 10.0) / 3950.0 + 1.0 / (273.15 + 25.0)) - 273.15
+    return value
+
+
+def vin_unit(conv):
+    if conv["type"] == "fixed" and conv["scale"] == 1.0:
+        return vin_unit({"type": conv["source"]})
+    return {
+        "frequency": "Hz",
+        "time": "ms",
+        "sonar": "mm",
+        "adc": "V",
+        "ntc": "°C",
+        "adc_seq": "V",
+        "ntc_seq": "°C",
+    }.get(conv["type"], "")
+
+
+class Frame:
+    """packs and unpacks complete frames with one precompiled struct per direction"""
+
+    def __init__(self, layout):
+        self.layout = layout
+        self.size = layout["size"]
+        self.osc = layout["clock"]
+        self.tx_fields = layout["tx"]
+        self.rx_fields = layout["rx"]
+        self.tx_struct = self._compile(self.tx_fields)
+        self.rx_struct = self._compile(self.rx_fields)
+        self.fast_vins, self.slow_vins = vin_slots(layout)
+        self.slow_divisors = [layout["vins"][num]["divisor"] for num in self.slow_vins]
+        self.slow_due = list(range(len(self.slow_vins)))
+        self.slow_raw = [0] * len(self.slow_vins)
+        self.slow_stamp = [None] * len(self.slow_vins)
+        self.cycle = 0
+        self.soe_next = 0
+
+    def _compile(self, fields):
+        fmt = "<"
+        used = 0
+        for field in fields:
+            fmt += f"{field['count']}{field['format']}"
+            used += struct.calcsize(f"<{field['count']}{field['format']}")
+        if used > self.size:
+            raise ValueError(f"frame layout needs {used} bytes, frame size is {self.size}")
+        fmt += f"{self.size - used}x"
+        return struct.Struct(fmt)
+
+    def _pack(self, fields, frame_struct, values):
+        flat = []
+        for field in fields:
+            data = values.get(field["name"], [])
+            if isinstance(data, int):
+                data = [data]
+            data = list(data)[: field["count"]]
+            flat += data + [0] * (field["count"] - len(data))
+        return frame_struct.pack(*flat)
+
+    def pack(self, values):
+        # values: dict of field name -> list, missing fields are sent as zeros
+        return self._pack(self.tx_fields, self.tx_struct, values)
+
+    def pack_answer(self, values):
+        # fpga -> host frame (used by the emulator)
+        return self._pack(self.rx_fields, self.rx_struct, values)
+
+    def unpack(self, buffer):
+        flat = self.rx_struct.unpack(bytes(buffer[: self.size]))
+        ret = {}
+        pos = 0
+        for field in self.rx_fields:
+            ret[field["name"]] = list(flat[pos : pos + field["count"]])
+            pos += field["count"]
+        ret["header"] = ret["header"][0]
+        for name in ("timestamp", "slowIndex", "slowValue", "soeStatus"):
+            if name in ret:
+                ret[name] = ret[name][0]
+        return ret
+
+    def pack_bits(self, bits, nbytes, msb_first=True):
+        data = [0] * nbytes
+        for num, bit in enumerate(bits):
+            if bit:
+                if msb_first:
+                    data[num // 8] |= 1 << (7 - num % 8)
+                else:
+                    data[num // 8] |= 1 << (num % 8)
+        return data
+
+    def unpack_bits(self, data, count):
+        return [(data[num // 8] >> (7 - num % 8)) & 1 for num in range(count)]
+
+    def build(self, joint_freqs=(), vout_values=(), joint_enables=(), douts=(), joint_velocities=(), joint_gears=()):
+        # converts user values and packs them into a host -> fpga frame
+        # (joint_velocities: counts/s of the dcservo joints, in joint order)
+        # (joint_gears: steps per encoder count of the geared joints, in joint order)
+        fields = {field["name"]: field for field in self.tx_fields}
+        joints = [
+            joint_to_cmd(conv, freq, self.osc)
+            for conv, freq in zip(self.layout["joints"], joint_freqs)
+        ]
+        setpoints = [
+            vout_to_setpoint(conv, value, self.osc)
+            for conv, value in zip(self.layout["vouts"], vout_values)
+        ]
+        self.cycle += 1
+        select = 0
+        if self.slow_vins:
+            select = slow_schedule(self.slow_due, self.slow_divisors, self.cycle)
+        return self.pack(
+            {
+                "header": PRU_WRITE,
+                "slowSelect": select,
+                "soeAck": self.soe_next,
+                "jointFreqCmd": joints,
+                "jointVelCmd": [_int32(velocity) for velocity in joint_velocities],
+                "jointGearRatio": [gear_to_cmd(ratio) for ratio in joint_gears],
+                "setPoint": setpoints,
+                "jointEnable": self.pack_bits(joint_enables, fields["jointEnable"]["count"], msb_first=False),
+                "outputs": self.pack_bits(douts, fields["outputs"]["count"]),
+            }
+        )
+
+    def parse(self, buffer):
+        # unpacks a fpga -> host frame and converts the values
+        raw = self.unpack(buffer)
+        # slow vins: the last received value and the cycles since (None: not received yet)
+        if self.slow_vins and raw["slowIndex"] < len(self.slow_vins):
+            self.slow_raw[raw["slowIndex"]] = raw["slowValue"]
+            self.slow_stamp[raw["slowIndex"]] = self.cycle
+        raw["vinsRaw"] = [0] * len(self.layout["vins"])
+        raw["vinsAge"] = [0] * len(self.layout["vins"])
+        for index, num in enumerate(self.fast_vins):
+            raw["vinsRaw"][num] = raw["processVariable"][index]
+        for index, num in enumerate(self.slow_vins):
+            raw["vinsRaw"][num] = self.slow_raw[index]
+            if self.slow_stamp[index] is None:
+                raw["vinsAge"][num] = None
+            else:
+                raw["vinsAge"][num] = self.cycle - self.slow_stamp[index]
+        raw["vins"] = [
+            vin_from_raw(conv, value, self.osc)
+            for conv, value in zip(self.layout["vins"], raw["vinsRaw"])
+        ]
+        raw["dins"] = self.unpack_bits(raw["inputs"], len(self.layout["dins"]))
+        if "soeStatus" in raw:
+            # sequence of events, the next frame acknowledges them
+            raw["soe"], self.soe_next = soe_decode(raw["soeEvents"], self.soe_next)
+            raw["soeLost"] = raw["soeStatus"] >> 16
+            # the fpga was restarted: continue with its sequence number
+            if ((raw["soeStatus"] & 0xFFFF) - self.soe_next) & 0x8000:
+                self.soe_next = raw["soeStatus"] & 0xFFFF
+        return raw
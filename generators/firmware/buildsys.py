@@ -214,6 +214,9 @@ def buildsys_icestorm(project):
     makefile_data.append(f"FAMILY  := {project['jdata']['family']}")
     makefile_data.append(f"TYPE    := {project['jdata']['type']}")
     makefile_data.append(f"PACKAGE := {project['jdata']['package']}")
+    makefile_data.append(f"SYSCLK_MHZ := {float(project['jdata']['clock']['speed']) / 1000000}")
+    makefile_data.append("# additional nextpnr options (clocktune.py: --timing-allow-fail)")
+    makefile_data.append("NEXTPNR_EXTRA ?=")
     makefile_data.append("")
 
     makefile_data.append(f"all: {bitfileName}")
@@ -224,7 +227,7 @@ def buildsys_icestorm(project):
 
     if project["jdata"]["family"] == "ecp5":
         makefile_data.append("rio.config: rio.json pins.lpf")
-        makefile_data.append("	nextpnr-${FAMILY} -q -l nextpnr.log --${TYPE} --package ${PACKAGE} --json rio.json --lpf pins.lpf --textcfg rio.config")
+        makefile_data.append("	nextpnr-${FAMILY} -q -l nextpnr.log --${TYPE} --package ${PACKAGE} --freq ${SYSCLK_MHZ} ${NEXTPNR_EXTRA} --json rio.json --lpf pins.lpf --textcfg rio.config")
         makefile_data.append('	@echo ""')
         makefile_data.append('	@grep -B 1 "%$$" nextpnr.log')
         makefile_data.append('	@echo ""')
@@ -239,7 +242,7 @@ def buildsys_icestorm(project):
         makefile_data.append("")
     else:
         makefile_data.append("rio.asc: rio.json pins.pcf")
-        makefile_data.append("	nextpnr-${FAMILY} -q -l nextpnr.log --${TYPE} --package ${PACKAGE} --json rio.json --pcf pins.pcf --asc rio.asc")
+        makefile_data.append("	nextpnr-${FAMILY} -q -l nextpnr.log --${TYPE} --package ${PACKAGE} --freq ${SYSCLK_MHZ} ${NEXTPNR_EXTRA} --json rio.json --pcf pins.pcf --asc rio.asc")
         makefile_data.append('	@echo ""')
         makefile_data.append('	@grep -B 1 "%$$" nextpnr.log')
         makefile_data.append('	@echo ""')
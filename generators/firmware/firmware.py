@@ -1,7 +1,10 @@
 import sys
 import os
+
+import frameio
 from .buildsys import *
 from .testbench import testbench
+from . import pll
 
 
 def verilog_top(project):
@@ -81,15 +84,14 @@ def verilog_top(project):
     top_data.append(f"    wire[{project['data_size'] - 1}:0] tx_data;")
     top_data.append("")
 
-    top_data.append("    reg signed [31:0] header_tx;")
-    top_data.append("    always @(posedge sysclk) begin")
-    top_data.append("        if (ESTOP) begin")
-    top_data.append("            header_tx <= 32'h65737470;")
-    top_data.append("        end else begin")
-    top_data.append("            header_tx <= 32'h64617461;")
-    top_data.append("        end")
-    top_data.append("    end")
-    top_data.append("")
+    if project["timestamp"]:
+        # free running tick counter, sent back in every answer frame
+        # spi: latched at the start of the transfer, uart/udp: after the request
+        top_data.append("    reg [31:0] timestamp = 0;")
+        top_data.append("    always @(posedge sysclk) begin")
+        top_data.append("        timestamp <= timestamp + 1;")
+        top_data.append("    end")
+        top_data.append("")
 
     # plugins wire/register definitions
     for plugin in project["plugins"]:
@@ -162,45 +164,146 @@ def verilog_top(project):
         top_data.append(f"    // vins {project['vins']}")
         for num, vin in enumerate(project["vinnames"]):
             top_data.append(f"    wire signed [31:0] {vin['_prefix']};")
+            if frameio.vin_conversion(vin)["type"] == "fixed":
+                top_data.append(f"    wire signed [31:0] {vin['_prefix']}_Q16;")
         top_data.append("")
 
     if project["jointnames"]:
         top_data.append(f"    // joints {project['joints']}")
         for num, joint in enumerate(project["jointnames"]):
             top_data.append(f"    wire signed [31:0] {joint['_prefix']}FreqCmd;")
+        for num in project["joints_velocity"]:
+            top_data.append(f"    wire signed [31:0] {project['jointnames'][num]['_prefix']}VelCmd;")
+        for entry in project["joints_gear"]:
+            top_data.append(f"    wire signed [31:0] {project['jointnames'][entry['joint']]['_prefix']}GearRatio;")
         for num, joint in enumerate(project["jointnames"]):
             top_data.append(f"    wire signed [31:0] {joint['_prefix']}Feedback;")
         top_data.append("")
 
     top_data.append(f"    // rx_data {project['rx_data_size']}")
-    pos = project["data_size"]
+    frame_layout = frameio.layout(project)
+    offsets = frameio.field_offsets(frame_layout["tx"])
+
+    def rx_word(offset):
+        # little-endian 32bit value at byte offset, the first frame byte is the msb of rx_data
+        pos = project["data_size"] - offset * 8
+        return f"{{rx_data[{pos-3*8-1}:{pos-3*8-8}], rx_data[{pos-2*8-1}:{pos-2*8-8}], rx_data[{pos-1*8-1}:{pos-1*8-8}], rx_data[{pos-1}:{pos-8}]}}"
 
     top_data.append("    wire [31:0] header_rx;")
-    top_data.append(
-        f"    assign header_rx = {{rx_data[{pos-3*8-1}:{pos-3*8-8}], rx_data[{pos-2*8-1}:{pos-2*8-8}], rx_data[{pos-1*8-1}:{pos-1*8-8}], rx_data[{pos-1}:{pos-8}]}};"
-    )
-    pos -= 32
+    top_data.append(f"    assign header_rx = {rx_word(offsets['header'])};")
+    top_data.append("")
+
+    # the answer to a PRU_READ request carries the layout hash (checked by the host at load),
+    # the interfaces latch read requests like write frames (READID)
+    top_data.append("    reg signed [31:0] header_tx;")
+    top_data.append("    always @(posedge sysclk) begin")
+    top_data.append("        if (ESTOP) begin")
+    top_data.append(f"            header_tx <= 32'h{frameio.PRU_ESTOP:08x};")
+    top_data.append(f"        end else if (header_rx == 32'h{frameio.PRU_READ:08x}) begin")
+    top_data.append(f"            header_tx <= 32'h{frame_layout['hash']:08x};")
+    top_data.append("        end else begin")
+    top_data.append(f"            header_tx <= 32'h{frameio.PRU_DATA:08x};")
+    top_data.append("        end")
+    top_data.append("    end")
+    top_data.append("")
 
+    # apply time: the joint commands go through a shadow register bank
+    shadow = "Rx" if project["apply_time"] else ""
     for num, joint in enumerate(project["jointnames"]):
+        if shadow:
+            top_data.append(f"    wire signed [31:0] {joint['_prefix']}FreqCmdRx;")
         top_data.append(
-            f"    assign {joint['_prefix']}FreqCmd = {{rx_data[{pos-3*8-1}:{pos-3*8-8}], rx_data[{pos-2*8-1}:{pos-2*8-8}], rx_data[{pos-1*8-1}:{pos-1*8-8}], rx_data[{pos-1}:{pos-8}]}};"
+            f"    assign {joint['_prefix']}FreqCmd{shadow} = {rx_word(offsets['jointFreqCmd'] + num * 4)};"
+        )
+    velocity_joints = [project["jointnames"][num] for num in project["joints_velocity"]]
+    for index, joint in enumerate(velocity_joints):
+        if shadow:
+            top_data.append(f"    wire signed [31:0] {joint['_prefix']}VelCmdRx;")
+        top_data.append(
+            f"    assign {joint['_prefix']}VelCmd{shadow} = {rx_word(offsets['jointVelCmd'] + index * 4)};"
+        )
+    # the gear ratio is taken over at once (no shadow register)
+    for index, entry in enumerate(project["joints_gear"]):
+        joint = project["jointnames"][entry["joint"]]
+        top_data.append(
+            f"    assign {joint['_prefix']}GearRatio = {rx_word(offsets['jointGearRatio'] + index * 4)};"
         )
-        pos -= 32
 
     for num, vout in enumerate(project["voutnames"]):
         top_data.append(
-            f"    assign {vout['_prefix']} = {{rx_data[{pos-3*8-1}:{pos-3*8-8}], rx_data[{pos-2*8-1}:{pos-2*8-8}], rx_data[{pos-1*8-1}:{pos-1*8-8}], rx_data[{pos-1}:{pos-8}]}};"
+            f"    assign {vout['_prefix']} = {rx_word(offsets['setPoint'] + num * 4)};"
         )
-        pos -= 32
 
+    pos = project["data_size"] - offsets["jointEnable"] * 8
     for dbyte in range(project["joints_en_total"] // 8):
         for num in range(8):
             bitnum = dbyte * 8 + (7 - num)
             if bitnum < project["joints"]:
                 jname = project["jointnames"][bitnum]["_prefix"]
-                top_data.append(f"    assign {jname}Enable = rx_data[{pos-1}];")
+                if shadow:
+                    top_data.append(f"    wire {jname}EnableRx;")
+                top_data.append(f"    assign {jname}Enable{shadow} = rx_data[{pos-1}];")
             pos -= 1
 
+    if shadow:
+        # all joints take over the new commands at the same fpga tick (0: immediately),
+        # late frames are applied at once
+        top_data.append("")
+        top_data.append("    wire [31:0] apply_time;")
+        top_data.append(f"    assign apply_time = {rx_word(offsets['applyTime'])};")
+        top_data.append("    wire [31:0] apply_diff;")
+        top_data.append("    assign apply_diff = timestamp - apply_time;")
+        top_data.append("    reg [31:0] apply_last = 0;")
+        for joint in project["jointnames"]:
+            top_data.append(f"    reg signed [31:0] {joint['_prefix']}FreqCmdShadow = 0;")
+            top_data.append(f"    reg {joint['_prefix']}EnableShadow = 0;")
+            top_data.append(f"    assign {joint['_prefix']}FreqCmd = {joint['_prefix']}FreqCmdShadow;")
+            top_data.append(f"    assign {joint['_prefix']}Enable = {joint['_prefix']}EnableShadow;")
+        for joint in velocity_joints:
+            top_data.append(f"    reg signed [31:0] {joint['_prefix']}VelCmdShadow = 0;")
+            top_data.append(f"    assign {joint['_prefix']}VelCmd = {joint['_prefix']}VelCmdShadow;")
+        top_data.append("    always @(posedge sysclk) begin")
+        top_data.append("        if (apply_time == 0 || (apply_time != apply_last && apply_diff[31] == 0)) begin")
+        top_data.append("            apply_last <= apply_time;")
+        for joint in project["jointnames"]:
+            top_data.append(f"            {joint['_prefix']}FreqCmdShadow <= {joint['_prefix']}FreqCmdRx;")
+            top_data.append(f"            {joint['_prefix']}EnableShadow <= {joint['_prefix']}EnableRx;")
+        for joint in velocity_joints:
+            top_data.append(f"            {joint['_prefix']}VelCmdShadow <= {joint['_prefix']}VelCmdRx;")
+        top_data.append("        end")
+        top_data.append("    end")
+        top_data.append("")
+
+    if project["vins_slow"]:
+        # multi-rate: the slow vins are sent one per frame in a shared slot,
+        # the host selects the vin, the index is sent back with the value
+        top_data.append("")
+        top_data.append("    wire [31:0] slow_select;")
+        top_data.append(f"    assign slow_select = {rx_word(offsets['slowSelect'])};")
+        top_data.append("    reg [31:0] slow_index = 0;")
+        top_data.append("    reg signed [31:0] slow_value = 0;")
+        top_data.append("    always @(posedge sysclk) begin")
+        top_data.append("        slow_index <= slow_select;")
+        top_data.append("        case (slow_select)")
+        for index, num in enumerate(project["vins_slow"]):
+            value = project["vinnames"][num]["_prefix"]
+            if frame_layout["vins"][num]["type"] == "fixed":
+                value = f"{value}_Q16"
+            top_data.append(f"            32'd{index}: slow_value <= {value};")
+        top_data.append("            default: slow_value <= 32'd0;")
+        top_data.append("        endcase")
+        top_data.append("    end")
+        top_data.append("")
+
+    if project["soe"]:
+        # sequence of events (din_soe): the host acknowledges by the next expected sequence number
+        top_data.append("    wire [31:0] soe_ack;")
+        top_data.append(f"    assign soe_ack = {rx_word(offsets['soeAck'])};")
+        top_data.append("    wire [31:0] soe_status;")
+        top_data.append(f"    wire [{project['soe']['slots'] * 64 - 1}:0] soe_events;")
+        top_data.append("")
+
+    pos = project["data_size"] - offsets["outputs"] * 8
     for dbyte in range(project["douts_total"] // 8):
         for num in range(8):
             bitnum = num + (dbyte * 8)
@@ -220,6 +323,10 @@ def verilog_top(project):
     top_data.append(
         "        header_tx[7:0], header_tx[15:8], header_tx[23:16], header_tx[31:24],"
     )
+    if project["timestamp"]:
+        top_data.append(
+            "        timestamp[7:0], timestamp[15:8], timestamp[23:16], timestamp[31:24],"
+        )
 
     for num, joint in enumerate(project["jointnames"]):
         top_data.append(
@@ -227,9 +334,27 @@ def verilog_top(project):
         )
 
     for num, vin in enumerate(project["vinnames"]):
+        if num in project["vins_slow"]:
+            continue
+        value = vin["_prefix"]
+        if frame_layout["vins"][num]["type"] == "fixed":
+            value = f"{value}_Q16"
         top_data.append(
-            f"        {vin['_prefix']}[7:0], {vin['_prefix']}[15:8], {vin['_prefix']}[23:16], {vin['_prefix']}[31:24],"
+            f"        {value}[7:0], {value}[15:8], {value}[23:16], {value}[31:24],"
         )
+    if project["vins_slow"]:
+        for value in ("slow_index", "slow_value"):
+            top_data.append(
+                f"        {value}[7:0], {value}[15:8], {value}[23:16], {value}[31:24],"
+            )
+    if project["soe"]:
+        top_data.append(
+            "        soe_status[7:0], soe_status[15:8], soe_status[23:16], soe_status[31:24],"
+        )
+        # per slot: tick, info
+        for low in range(0, project["soe"]["slots"] * 64, 32):
+            parts = [f"soe_events[{low + bit + 7}:{low + bit}]" for bit in (0, 8, 16, 24)]
+            top_data.append(f"        {', '.join(parts)},")
 
     tdins = []
     ldin = project["dins"]
@@ -269,6 +394,29 @@ def verilog_top(project):
         top_data.append(f"    assign {port} = {{{', '.join(assign_list)}}};")
     #top_data.append("")
 
+    fixed_vins = []
+    for num, vin in enumerate(project["vinnames"]):
+        conv = frame_layout["vins"][num]
+        if conv["type"] == "fixed":
+            fixed_vins.append(num)
+        elif vin.get("fixed"):
+            print(f"WARNING: vin '{vin['_name']}' ({conv['type']}) can not be scaled in the gateware, using raw values")
+    if fixed_vins:
+        top_data.append("")
+        top_data.append("    // vin scaling (Q16.16)")
+        for num in fixed_vins:
+            vin = project["vinnames"][num]
+            params = frameio.vin_fixed_params(frame_layout["vins"][num], frame_layout["clock"])
+            top_data.append(
+                f"    vin_scale #(.RECIPROCAL({params['RECIPROCAL']}), .MUL(32'd{params['MUL']}), .MUL_NEG({params['MUL_NEG']}), .SHIFT({params['SHIFT']}), .NUMERATOR(64'd{params['NUMERATOR']})) vin_scale{num} ("
+            )
+            top_data.append("        .clk (sysclk),")
+            top_data.append(f"        .value_in ({vin['_prefix']}),")
+            top_data.append(f"        .value_out ({vin['_prefix']}_Q16)")
+            top_data.append("    );")
+        project["verilog_files"].append("vin_scale.v")
+        os.system(f"cp -a generators/firmware/vin_scale.v {project['SOURCE_PATH']}/vin_scale.v")
+
     for plugin in project["plugins"]:
         if hasattr(project["plugins"][plugin], "funcs"):
             funcs = project["plugins"][plugin].funcs()
@@ -296,22 +444,7 @@ def generate(project):
     if project["internal_clock"]:
         pass
     elif project["osc_clock"]:
-        if project["jdata"]["family"] == "ecp5":
-            os.system(
-                f"ecppll -f '{project['SOURCE_PATH']}/pll.v' -i {float(project['osc_clock']) / 1000000} -o {float(project['jdata']['clock']['speed']) / 1000000}"
-            )
-        elif project["jdata"]["type"] == "up5k":
-            os.system(
-                f"icepll -p -m -f '{project['SOURCE_PATH']}/pll.v' -i {float(project['osc_clock']) / 1000000} -o {float(project['jdata']['clock']['speed']) / 1000000}"
-            )
-        elif project["jdata"]["family"] == "GW1N-9C":
-            os.system(
-                f"python3 files/gowin-pll.py -d 'GW1NR-9 C6/I5' -f '{project['SOURCE_PATH']}/pll.v' -i {float(project['osc_clock']) / 1000000} -o {float(project['jdata']['clock']['speed']) / 1000000}"
-            )
-        else:
-            os.system(
-                f"icepll -q -m -f '{project['SOURCE_PATH']}/pll.v' -i {float(project['osc_clock']) / 1000000} -o {float(project['jdata']['clock']['speed']) / 1000000}"
-            )
+        open(f"{project['SOURCE_PATH']}/pll.v", "w").write(pll.verilog(project["pll"]))
         project["verilog_files"].append("pll.v")
 
     verilog_top(project)
@@ -0,0 +1,101 @@
+
+// byte addressed frame buffer between the interface and the generated top
+//   rx: the interface writes the received bytes, after a valid frame (rx_commit) the
+//       memory is copied into rx_data (register slice), 32bit word by word, so every
+//       32bit field is updated at once, the whole frame within WORDS*4+2 clocks
+//       the first frame byte is the msb of rx_data (same layout as the shift registers)
+//       the interfaces write slower than one byte per clock, the next frame can not
+//       overtake the copy
+//   tx: tx_data is copied word by word into the memory as long as tx_hold is low,
+//       the interface reads the frozen snapshot byte by byte (latency: 1 clock)
+module frame_ram
+    #(parameter BUFFER_SIZE=64)
+     (
+         input clk,
+         input rx_we,
+         input [15:0] rx_addr,
+         input [7:0] rx_byte,
+         input rx_commit,
+         output reg [31:0] rx_header = 0,
+         output [BUFFER_SIZE-1:0] rx_data,
+         input tx_hold,
+         input [15:0] tx_addr,
+         output [7:0] tx_byte,
+         input [BUFFER_SIZE-1:0] tx_data
+     );
+    localparam BYTES = BUFFER_SIZE / 8;
+    localparam WORDS = (BYTES + 3) / 4;
+
+    reg [7:0] rx_mem [0:WORDS*4-1];
+    reg [31:0] tx_mem [0:WORDS-1];
+
+    integer i;
+    initial begin
+        for (i = 0; i < WORDS * 4; i = i + 1) begin
+            rx_mem[i] = 0;
+        end
+        for (i = 0; i < WORDS; i = i + 1) begin
+            tx_mem[i] = 0;
+        end
+    end
+
+    // rx
+    always @(posedge clk) begin
+        if (rx_we && rx_addr < BYTES) begin
+            rx_mem[rx_addr] <= rx_byte;
+        end
+        if (rx_we && rx_addr < 4) begin
+            rx_header[(3-rx_addr[1:0])*8+:8] <= rx_byte;
+        end
+    end
+
+    reg [WORDS*32-1:0] rx_slice = 0;
+    assign rx_data = rx_slice[WORDS*32-1-:BUFFER_SIZE];
+
+    reg loading = 0;
+    reg [15:0] load_addr = 0;
+    reg [15:0] load_pos = 0;
+    reg load_valid = 0;
+    reg [7:0] load_byte = 0;
+    reg [23:0] load_word = 0;
+    always @(posedge clk) begin
+        load_byte <= rx_mem[load_addr];
+        load_pos <= load_addr;
+        load_valid <= loading;
+        if (rx_commit) begin
+            loading <= 1;
+            load_addr <= 0;
+        end else if (loading) begin
+            if (load_addr == WORDS * 4 - 1) begin
+                loading <= 0;
+            end else begin
+                load_addr <= load_addr + 1;
+            end
+        end
+        if (load_valid) begin
+            load_word <= {load_word[15:0], load_byte};
+            if (load_pos[1:0] == 2'd3) begin
+                rx_slice[WORDS*32-1-load_pos[15:2]*32-:32] <= {load_word, load_byte};
+            end
+        end
+    end
+
+    // tx
+    wire [WORDS*32-1:0] tx_words = tx_data << (WORDS * 32 - BUFFER_SIZE);
+    reg [15:0] refresh = 0;
+    reg [31:0] tx_word = 0;
+    reg [1:0] tx_sel = 0;
+    assign tx_byte = tx_word[(3-tx_sel)*8+:8];
+    always @(posedge clk) begin
+        if (!tx_hold) begin
+            tx_mem[refresh] <= tx_words[WORDS*32-1-refresh*32-:32];
+            if (refresh == WORDS - 1) begin
+                refresh <= 0;
+            end else begin
+                refresh <= refresh + 1;
+            end
+        end
+        tx_word <= tx_mem[tx_addr[15:2]];
+        tx_sel <= tx_addr[1:0];
+    end
+endmodule
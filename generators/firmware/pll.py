@@ -0,0 +1,385 @@
+#
+# pll setup of the system clock (sysclk from the oscillator, clock: osc)
+#   ice40: SB_PLL40_CORE / SB_PLL40_PAD (up5k), simple feedback, same search as icepll
+#   ecp5:  EHXPLLL, CLKOP feedback, same search as ecppll
+#   gowin: rPLL / PLLVR, limits from files/gowin-pll.py
+# the achieved frequency replaces clock: speed (PRU_OSC and the gateware dividers use the real sysclk),
+# frequencies() lists the reachable ones for the sysclk sweep (clocktune.py)
+#
+
+import math
+
+GOWIN_DEVICES = {
+    "GW1NR-1 C6/I5": {
+        "comment": "Untested",
+        "pll_name": "PLLVR",
+        "pfd_min": 3,
+        "pfd_max": 400,
+        "vco_min": 400,
+        "vco_max": 900,
+        "clkout_min": 3.125,
+        "clkout_max": 450,
+    },
+    "GW1NR-1 C5/I4": {
+        "comment": "Untested",
+        "pll_name": "PLLVR",
+        "pfd_min": 3,
+        "pfd_max": 320,
+        "vco_min": 320,
+        "vco_max": 720,
+        "clkout_min": 2.5,
+        "clkout_max": 360,
+    },
+    "GW1NR-2 C7/I6": {
+        "comment": "Untested",
+        "pll_name": "PLLVR",
+        "pfd_min": 3,
+        "pfd_max": 400,
+        "vco_min": 400,
+        "vco_max": 800,
+        "clkout_min": 3.125,
+        "clkout_max": 750,
+    },
+    "GW1NR-2 C6/I5": {
+        "comment": "Untested",
+        "pll_name": "PLLVR",
+        "pfd_min": 3,
+        "pfd_max": 400,
+        "vco_min": 400,
+        "vco_max": 800,
+        "clkout_min": 3.125,
+        "clkout_max": 750,
+    },
+    "GW1NR-2 C5/I4": {
+        "comment": "Untested",
+        "pll_name": "PLLVR",
+        "pfd_min": 3,
+        "pfd_max": 320,
+        "vco_min": 320,
+        "vco_max": 640,
+        "clkout_min": 2.5,
+        "clkout_max": 640,
+    },
+    "GW1NR-4 C6/I5": {
+        "comment": "Untested",
+        "pll_name": "PLLVR",
+        "pfd_min": 3,
+        "pfd_max": 400,
+        "vco_min": 400,
+        "vco_max": 1000,
+        "clkout_min": 3.125,
+        "clkout_max": 500,
+    },
+    "GW1NR-4 C5/I4": {
+        "comment": "Untested",
+        "pll_name": "PLLVR",
+        "pfd_min": 3,
+        "pfd_max": 320,
+        "vco_min": 320,
+        "vco_max": 800,
+        "clkout_min": 2.5,
+        "clkout_max": 400,
+    },
+    "GW1NSR-4(C) C7/I6": {
+        "comment": "Untested",
+        "pll_name": "PLLVR",
+        "pfd_min": 3,
+        "pfd_max": 400,
+        "vco_min": 400,
+        "vco_max": 1200,
+        "clkout_min": 3.125,
+        "clkout_max": 600,
+    },
+    "GW1NSR-4(C) C6/I5": {
+        "comment": "Untested",
+        "pll_name": "PLLVR",
+        "pfd_min": 3,
+        "pfd_max": 400,
+        "vco_min": 400,
+        "vco_max": 1200,
+        "clkout_min": 3.125,
+        "clkout_max": 600,
+    },
+    "GW1NSR-4(C) C5/I4": {
+        "comment": "Untested",
+        "pll_name": "PLLVR",
+        "pfd_min": 3,
+        "pfd_max": 320,
+        "vco_min": 320,
+        "vco_max": 960,
+        "clkout_min": 2.5,
+        "clkout_max": 480,
+    },
+    "GW1NR-9 C7/I6": {
+        "comment": "Untested",
+        "pll_name": "rPLL",
+        "pfd_min": 3,
+        "pfd_max": 400,
+        "vco_min": 400,
+        "vco_max": 1200,
+        "clkout_min": 3.125,
+        "clkout_max": 600,
+    },
+    "GW1NR-9 C6/I5": {
+        "comment": "tested on TangNano9K Board",
+        "pll_name": "rPLL",
+        "pfd_min": 3,
+        "pfd_max": 400,
+        "vco_min": 400,
+        "vco_max": 1200,
+        "clkout_min": 3.125,
+        "clkout_max": 600,
+    },
+    "GW1NR-9 C6/I4": {
+        "comment": "Untested",
+        "pll_name": "rPLL",
+        "pfd_min": 3,
+        "pfd_max": 320,
+        "vco_min": 3200,
+        "vco_max": 960,
+        "clkout_min": 2.5,
+        "clkout_max": 480,
+    },
+    "GW2AR-18 C8/I7": {
+        "comment": "Untested",
+        "pll_name": "rPLL",
+        "pfd_min": 3,
+        "pfd_max": 500,
+        "vco_min": 500,
+        "vco_max": 1250,
+        "clkout_min": 3.90625,
+        "clkout_max": 625,
+    },
+}
+
+# jdata family -> gowin device
+GOWIN_FAMILIES = {
+    "GW1N-9C": "GW1NR-9 C6/I5",
+    "GW2AR-18C": "GW2AR-18 C8/I7",
+}
+
+
+def ice40_settings(fin, fout=None):
+    """all settings (fout=None) or the best one for fout, frequencies in MHz"""
+    results = []
+    best = None
+    if not (10 <= fin <= 133):
+        return results if fout is None else None
+    for divr in range(16):
+        fpfd = fin / (divr + 1)
+        if not (10 <= fpfd <= 133):
+            continue
+        for divf in range(128):
+            fvco = fpfd * (divf + 1)
+            if not (533 <= fvco <= 1066):
+                continue
+            for divq in range(1, 7):
+                freq = fvco / (1 << divq)
+                if not (16 <= freq <= 275):
+                    continue
+                setup = {"DIVR": divr, "DIVF": divf, "DIVQ": divq, "PFD": fpfd, "VCO": fvco, "freq": freq}
+                if fout is None:
+                    results.append(setup)
+                elif best is None or abs(freq - fout) < abs(best["freq"] - fout):
+                    best = setup
+    if fout is None:
+        return results
+    if best is not None:
+        fpfd = best["PFD"]
+        best["FILTER_RANGE"] = 1 if fpfd < 17 else 2 if fpfd < 26 else 3 if fpfd < 44 else 4 if fpfd < 66 else 5 if fpfd < 101 else 6
+    return best
+
+
+def ecp5_settings(fin, fout=None):
+    """all settings (fout=None) or the best one for fout, the vco as close to 600MHz as possible"""
+    results = []
+    best = None
+    if not (8 <= fin <= 400):
+        return results if fout is None else None
+    for clki_div in range(1, 129):
+        fpfd = fin / clki_div
+        if not (3.125 <= fpfd <= 400):
+            continue
+        for clkfb_div in range(1, 81):
+            freq = fpfd * clkfb_div
+            if not (10 <= freq <= 400):
+                continue
+            # output divider with the vco in range (400-800MHz)
+            op_min = max(math.ceil(400 / freq), 1)
+            op_max = min(math.floor(800 / freq), 128)
+            if op_min > op_max:
+                continue
+            clkop_div = min(max(round(600 / freq), op_min), op_max)
+            setup = {"CLKI_DIV": clki_div, "CLKFB_DIV": clkfb_div, "CLKOP_DIV": clkop_div, "PFD": fpfd, "VCO": freq * clkop_div, "freq": freq}
+            if fout is None:
+                results.append(setup)
+            elif best is None or abs(freq - fout) < abs(best["freq"] - fout):
+                best = setup
+    return results if fout is None else best
+
+
+def gowin_settings(fin, fout=None, device="GW1NR-9 C6/I5"):
+    """all settings (fout=None) or the best one for fout (files/gowin-pll.py)"""
+    limits = GOWIN_DEVICES[device]
+    results = []
+    best = None
+    for idiv_sel in range(64):
+        for fbdiv_sel in range(64):
+            for odiv_sel in [2, 4, 8, 16, 32, 48, 64, 80, 96, 112, 128]:
+                fpfd = fin / (idiv_sel + 1)
+                if not (limits["pfd_min"] < fpfd < limits["pfd_max"]):
+                    continue
+                freq = fin * (fbdiv_sel + 1) / (idiv_sel + 1)
+                if not (limits["clkout_min"] < freq < limits["clkout_max"]):
+                    continue
+                fvco = (fin * (fbdiv_sel + 1) * odiv_sel) / (idiv_sel + 1)
+                if not (limits["vco_min"] < fvco < limits["vco_max"]):
+                    continue
+                setup = {"IDIV_SEL": idiv_sel, "FBDIV_SEL": fbdiv_sel, "ODIV_SEL": odiv_sel, "PFD": fpfd, "VCO": fvco, "freq": freq}
+                if fout is None:
+                    results.append(setup)
+                elif best is None or abs(freq - fout) < abs(best["freq"] - fout):
+                    best = setup
+    return results if fout is None else best
+
+
+def settings(family, ftype, fin, fout=None):
+    """pll settings of the family, frequencies in MHz (None: not supported)"""
+    if family == "ice40":
+        result = ice40_settings(fin, fout)
+        prim = "SB_PLL40_PAD" if ftype == "up5k" else "SB_PLL40_CORE"
+    elif family == "ecp5":
+        result = ecp5_settings(fin, fout)
+        prim = "EHXPLLL"
+    elif family in GOWIN_FAMILIES:
+        device = GOWIN_FAMILIES[family]
+        result = gowin_settings(fin, fout, device)
+        prim = GOWIN_DEVICES[device]["pll_name"]
+    else:
+        return None
+    if fout is None or result is None:
+        return result
+    result["family"] = family
+    result["prim"] = prim
+    result["fin"] = fin
+    result["fout"] = fout
+    return result
+
+
+def frequencies(family, ftype, fin, fmin, fmax):
+    """reachable output frequencies between fmin and fmax (MHz), ascending"""
+    return sorted({round(setup["freq"], 6) for setup in settings(family, ftype, fin) or [] if fmin <= setup["freq"] <= fmax})
+
+
+def verilog(setup, module_name="pll"):
+    header = f"""/**
+ * PLL configuration
+ *
+ * This Verilog module was generated automatically
+ * using the rio pll generator (generators/firmware/pll.py).
+ * Use at your own risk.
+ *
+ * Given input frequency:        {setup['fin']:0.3f} MHz
+ * Requested output frequency:   {setup['fout']:0.3f} MHz
+ * Achieved output frequency:    {setup['freq']:0.3f} MHz
+ */
+
+module {module_name}(
+        input  clock_in,
+        output clock_out,
+        output locked
+    );
+"""
+    if setup["family"] == "ice40":
+        if setup["prim"] == "SB_PLL40_PAD":
+            clockin = ".PACKAGEPIN(clock_in),"
+        else:
+            clockin = ".REFERENCECLK(clock_in),"
+        body = f"""
+    {setup['prim']} #(
+        .FEEDBACK_PATH("SIMPLE"),
+        .DIVR(4'd{setup['DIVR']}), // -> PFD = {setup['PFD']:0.3f} MHz
+        .DIVF(7'd{setup['DIVF']}), // -> VCO = {setup['VCO']:0.3f} MHz
+        .DIVQ(3'd{setup['DIVQ']}), // -> CLKOUT = {setup['freq']:0.3f} MHz
+        .FILTER_RANGE(3'd{setup['FILTER_RANGE']})
+    ) pll (
+        .LOCK(locked),
+        .RESETB(1'b1),
+        .BYPASS(1'b0),
+        {clockin}
+        .PLLOUTCORE(clock_out)
+    );
+"""
+    elif setup["family"] == "ecp5":
+        body = f"""
+    (* FREQUENCY_PIN_CLKI="{setup['fin']:g}" *)
+    (* FREQUENCY_PIN_CLKOP="{setup['freq']:g}" *)
+    (* ICP_CURRENT="12" *) (* LPF_RESISTOR="8" *) (* MFG_ENABLE_FILTEROPAMP="1" *) (* MFG_GMCREF_SEL="2" *)
+    EHXPLLL #(
+        .PLLRST_ENA("DISABLED"),
+        .INTFB_WAKE("DISABLED"),
+        .STDBY_ENABLE("DISABLED"),
+        .DPHASE_SOURCE("DISABLED"),
+        .OUTDIVIDER_MUXA("DIVA"),
+        .OUTDIVIDER_MUXB("DIVB"),
+        .OUTDIVIDER_MUXC("DIVC"),
+        .OUTDIVIDER_MUXD("DIVD"),
+        .CLKI_DIV({setup['CLKI_DIV']}), // -> PFD = {setup['PFD']:0.3f} MHz
+        .CLKOP_ENABLE("ENABLED"),
+        .CLKOP_DIV({setup['CLKOP_DIV']}), // -> VCO = {setup['VCO']:0.3f} MHz
+        .CLKOP_CPHASE({setup['CLKOP_DIV'] - 1}),
+        .CLKOP_FPHASE(0),
+        .FEEDBK_PATH("CLKOP"),
+        .CLKFB_DIV({setup['CLKFB_DIV']}) // -> CLKOUT = {setup['freq']:0.3f} MHz
+    ) pll (
+        .RST(1'b0),
+        .STDBY(1'b0),
+        .CLKI(clock_in),
+        .CLKOP(clock_out),
+        .CLKFB(clock_out),
+        .CLKINTFB(),
+        .PHASESEL0(1'b0),
+        .PHASESEL1(1'b0),
+        .PHASEDIR(1'b1),
+        .PHASESTEP(1'b1),
+        .PHASELOADREG(1'b1),
+        .PLLWAKESYNC(1'b0),
+        .ENCLKOP(1'b0),
+        .LOCK(locked)
+    );
+"""
+    else:
+        extra_options = ""
+        if setup["prim"] == "PLLVR":
+            extra_options = ".VREN(1'b1),"
+        body = f"""
+    {setup['prim']} #(
+        .FCLKIN("{setup['fin']:g}"),
+        .IDIV_SEL({setup['IDIV_SEL']}), // -> PFD = {setup['PFD']:0.3f} MHz
+        .FBDIV_SEL({setup['FBDIV_SEL']}), // -> CLKOUT = {setup['freq']:0.3f} MHz
+        .ODIV_SEL({setup['ODIV_SEL']}) // -> VCO = {setup['VCO']:0.3f} MHz
+    ) pll (.CLKOUTP(), .CLKOUTD(), .CLKOUTD3(), .RESET(1'b0), .RESET_P(1'b0), .CLKFB(1'b0), .FBDSEL(6'b0), .IDSEL(6'b0), .ODSEL(6'b0), .PSDA(4'b0), .DUTYDA(4'b0), .FDLY(4'b0), {extra_options}
+        .CLKIN(clock_in),
+        .CLKOUT(clock_out),
+        .LOCK(locked)
+    );
+"""
+    return header + body + "\nendmodule\n"
+
+
+def setup(project):
+    """pll for clock: speed, the achieved frequency is written back to clock: speed"""
+    jdata = project["jdata"]
+    fin = float(project["osc_clock"]) / 1000000
+    fout = float(jdata["clock"]["speed"]) / 1000000
+    result = settings(jdata["family"], jdata["type"], fin, fout)
+    if result is None:
+        print("")
+        print(f"ERROR: pll: no setup for {jdata['family']} ({fin} MHz -> {fout} MHz)")
+        print("")
+        exit(1)
+    speed = round(result["freq"] * 1000000)
+    if speed != round(fout * 1000000):
+        print(f"WARNING: pll: sysclk is {speed} Hz (requested: {jdata['clock']['speed']} Hz)")
+    jdata["clock"]["speed"] = str(speed)
+    return result
@@ -0,0 +1,77 @@
+
+// converts a raw vin value into Q16.16 user units
+//   RECIPROCAL = 0: value_out = value_in * MUL >> SHIFT
+//   RECIPROCAL = 1: value_out = NUMERATOR / value_in (0 for value_in == 0)
+// sequential (one bit per clock), the result is updated every 34 / 66 clocks
+module vin_scale
+    #(parameter RECIPROCAL = 0, parameter [31:0] MUL = 32'd65536, parameter MUL_NEG = 0, parameter SHIFT = 0, parameter [63:0] NUMERATOR = 64'd0)
+     (
+         input clk,
+         input signed [31:0] value_in,
+         output signed [31:0] value_out
+     );
+    reg signed [31:0] result = 0;
+    assign value_out = result;
+
+    reg [6:0] step = 0;
+    reg sign = 0;
+    reg [31:0] operand = 0;
+    reg [63:0] shifter = 0;
+    reg [64:0] acc = 0;
+    reg [63:0] quotient = 0;
+
+    wire [63:0] product = acc[63:0] >> SHIFT;
+    wire [64:0] remainder = {acc[63:0], shifter[63]};
+
+    always @(posedge clk) begin
+        if (step == 0) begin
+            // latch the input
+            sign <= value_in[31] ^ (MUL_NEG != 0);
+            operand <= value_in[31] ? -value_in : value_in;
+            shifter <= RECIPROCAL ? NUMERATOR : {32'd0, MUL};
+            acc <= 0;
+            quotient <= 0;
+            step <= 1;
+        end else if (RECIPROCAL == 0) begin
+            if (step <= 32) begin
+                // shift-add multiply
+                if (operand[0]) begin
+                    acc <= acc + shifter;
+                end
+                operand <= operand >> 1;
+                shifter <= shifter << 1;
+                step <= step + 1;
+            end else begin
+                if (product[63:31] != 0) begin
+                    result <= sign ? -32'sh7FFFFFFF : 32'sh7FFFFFFF;
+                end else begin
+                    result <= sign ? -product[31:0] : product[31:0];
+                end
+                step <= 0;
+            end
+        end else begin
+            if (operand == 0) begin
+                result <= 0;
+                step <= 0;
+            end else if (step <= 64) begin
+                // restoring division
+                if (remainder >= {33'd0, operand}) begin
+                    acc <= remainder - {33'd0, operand};
+                    quotient <= {quotient[62:0], 1'b1};
+                end else begin
+                    acc <= remainder;
+                    quotient <= {quotient[62:0], 1'b0};
+                end
+                shifter <= shifter << 1;
+                step <= step + 1;
+            end else begin
+                if (quotient[63:31] != 0) begin
+                    result <= sign ? -32'sh7FFFFFFF : 32'sh7FFFFFFF;
+                end else begin
+                    result <= sign ? -quotient[31:0] : quotient[31:0];
+                end
+                step <= 0;
+            end
+        end
+    end
+endmodule
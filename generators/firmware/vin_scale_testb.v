@@ -0,0 +1,46 @@
+`timescale 1ns/100ps
+
+module testb;
+    reg clk = 0;
+    always #1 clk = !clk;
+
+    reg signed [31:0] value_in = 0;
+    wire signed [31:0] linear;
+    wire signed [31:0] reciprocal;
+
+    initial begin
+        $dumpfile("testb.vcd");
+        $dumpvars(0, testb);
+
+        // adc: 1234mV -> 1.234V (80871 in Q16.16)
+        value_in = 1234;
+        # 400
+        $display("linear: %d (80871)", linear);
+        // 27MHz / 27000 -> 1000Hz (65536000 in Q16.16)
+        value_in = 27000;
+        # 400
+        $display("reciprocal: %d (65536000)", reciprocal);
+        value_in = -27000;
+        # 400
+        $display("reciprocal: %d (-65536000)", reciprocal);
+        value_in = 0;
+        # 400
+        $display("reciprocal: %d (0)", reciprocal);
+        $finish;
+    end
+
+    // adc: 0.001 * 65536 = 65.536 (frameio.vin_fixed_params)
+    vin_scale #(.RECIPROCAL(0), .MUL(32'd1099511628), .SHIFT(24)) vin_scale_linear (
+        .clk (clk),
+        .value_in (value_in),
+        .value_out (linear)
+    );
+
+    // frequency: 27MHz * 65536
+    vin_scale #(.RECIPROCAL(1), .NUMERATOR(64'd1769472000000)) vin_scale_reciprocal (
+        .clk (clk),
+        .value_in (value_in),
+        .value_out (reciprocal)
+    );
+
+endmodule
@@ -1,7 +1,187 @@
 
 import os
+import struct
 import sys
 
+import frameio
+
+VIN_RAW = [
+    "value += *(data->processVariableOffset[i]);",
+    "value *= *(data->processVariableScale[i]);",
+    "*(data->processVariable[i]) = value;",
+    "*(data->processVariableS32[i]) = (int)value;",
+]
+
+# Q16.16 values of vins scaled by the gateware
+VIN_FIXED = [
+    "value *= (1.0 / 65536.0);",
+] + VIN_RAW
+
+VOUT_RAW = [
+    "return value;",
+]
+
+
+def generate_convert(project, frame_layout):
+    # stitches the host side conversions of the used plugins into rio_convert.h
+    vin_hooks = {"raw": VIN_RAW, "fixed": VIN_FIXED}
+    vout_hooks = {"raw": VOUT_RAW}
+    for plugin in project["plugins"].values():
+        if hasattr(plugin, "vin_convert"):
+            vin_hooks.update(plugin.vin_convert())
+        if hasattr(plugin, "vout_convert"):
+            vout_hooks.update(plugin.vout_convert())
+
+    convert_data = []
+    convert_data.append("// generated: host side conversions of the used vin/vout types")
+    convert_data.append("#ifndef RIO_CONVERT_H")
+    convert_data.append("#define RIO_CONVERT_H")
+    convert_data.append("")
+
+    used = []
+    for vin in frame_layout["vins"]:
+        if vin["type"] not in used:
+            used.append(vin["type"])
+    for vtype in used:
+        if vtype not in vin_hooks:
+            print(f"WARNING: no host conversion for vin type '{vtype}', using raw values")
+            vin_hooks[vtype] = VIN_RAW
+        convert_data.append(f"static inline void vin_convert_{vtype}(int i, float value, long duration) {{")
+        for line in vin_hooks[vtype]:
+            convert_data.append(f"    {line}".rstrip())
+        convert_data.append("}")
+        convert_data.append("")
+
+    used = []
+    for vout in frame_layout["vouts"]:
+        if vout["type"] not in used:
+            used.append(vout["type"])
+    for vtype in used:
+        if vtype not in vout_hooks:
+            print(f"WARNING: no host conversion for vout type '{vtype}', using raw values")
+            vout_hooks[vtype] = VOUT_RAW
+        convert_data.append(f"static inline int32_t vout_convert_{vtype}(int i, float value) {{")
+        for line in vout_hooks[vtype]:
+            convert_data.append(f"    {line}".rstrip())
+        convert_data.append("}")
+        convert_data.append("")
+
+    # unrolled per channel, no type dispatch in the servo-thread
+    # slow vins (multi-rate) are converted from the last received value
+    # the frames are passed in, rio.aux works on its own copies
+    fast, _slow = frameio.vin_slots(frame_layout)
+    convert_data.append("static inline void rio_convert_vins(const rxData_t *rx, long duration) {")
+    for num, vin in enumerate(frame_layout["vins"]):
+        if "slow" in vin:
+            convert_data.append(f"    vin_convert_{vin['type']}({num}, slowVariable[{vin['slow']}], duration);")
+        else:
+            convert_data.append(f"    vin_convert_{vin['type']}({num}, rx->processVariable[{fast.index(num)}], duration);")
+    convert_data.append("}")
+    convert_data.append("")
+
+    convert_data.append("static inline void rio_convert_vouts(txData_t *tx) {")
+    for num, vout in enumerate(frame_layout["vouts"]):
+        convert_data.append(f"    tx->setPoint[{num}] = vout_convert_{vout['type']}({num}, *(data->setPoint[{num}]) * *(data->setPointScale[{num}]) + *(data->setPointOffset[{num}]));")
+    convert_data.append("}")
+    convert_data.append("")
+    convert_data.append("#endif")
+    convert_data.append("")
+
+    open(f"{project['LINUXCNC_PATH']}/Components/rio_convert.h", "w").write("\n".join(convert_data))
+
+
+def generate_frame(project, frame_layout):
+    # frame fields and packing of the values (the C side of frameio.Frame) into rio_frame.h
+    frame_data = []
+    frame_data.append("// generated: frame fields and packing of the values (rio-layout.json, frameio.py)")
+    frame_data.append("#ifndef RIO_FRAME_H")
+    frame_data.append("#define RIO_FRAME_H")
+    frame_data.append("")
+    frame_data.append("#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__")
+    frame_data.append("#error \"the frames are little endian, the unions of rio.h need a little endian host\"")
+    frame_data.append("#endif")
+    frame_data.append("")
+
+    # X(name, offset, element size, count)
+    for direction in ("tx", "rx"):
+        fields = []
+        for field in frame_layout[direction]:
+            size = struct.calcsize(f"<{field['format']}")
+            fields.append(f"    X({field['name']}, {direction.upper()}_OFFSET_{field['name'].upper()}, {size}, {field['count']})")
+        frame_data.append(f"#define RIO_{direction.upper()}_FIELDS(X) \\")
+        frame_data.append(" \\\n".join(fields))
+        frame_data.append("")
+    frame_data.append("// the unions of rio.h against the layout")
+    frame_data.append("#define RIO_FRAME_CHECK(type, name, offset, size, count) \\")
+    frame_data.append("    _Static_assert(offsetof(type, name) == (offset) && sizeof(((type *)0)->name) == (size) * (count), #type \".\" #name);")
+    frame_data.append("#define RIO_FRAME_CHECK_TX(name, offset, size, count) RIO_FRAME_CHECK(txData_t, name, offset, size, count)")
+    frame_data.append("#define RIO_FRAME_CHECK_RX(name, offset, size, count) RIO_FRAME_CHECK(rxData_t, name, offset, size, count)")
+    frame_data.append("RIO_TX_FIELDS(RIO_FRAME_CHECK_TX)")
+    frame_data.append("RIO_RX_FIELDS(RIO_FRAME_CHECK_RX)")
+    frame_data.append("")
+
+    frame_data.append("// frameio._int32()")
+    frame_data.append("static inline int32_t rio_frame_int32(double value) {")
+    frame_data.append("    if (value > 2147483647.0) {")
+    frame_data.append("        return 2147483647;")
+    frame_data.append("    } else if (value < -2147483647.0) {")
+    frame_data.append("        return -2147483647;")
+    frame_data.append("    }")
+    frame_data.append("    return (int32_t)value;")
+    frame_data.append("}")
+    frame_data.append("")
+
+    # unrolled per joint, like rio_convert.h
+    frame_data.append("// frameio.joint_to_cmd(): frequency -> period in clock cycles, position (pwmdir/dcservo) as it is")
+    frame_data.append("static inline int32_t rio_frame_joint_cmd(int i, double value) {")
+    frame_data.append("    switch (i) {")
+    for num, joint in enumerate(frame_layout["joints"]):
+        frame_data.append(f"    case {num}: // {joint['type']}")
+        if joint["type"] in ("pwmdir", "dcservo"):
+            frame_data.append("        return rio_frame_int32(value);")
+        elif joint["type"] == "stepper":
+            frame_data.append("        return value == 0.0 ? 0 : rio_frame_int32(PRU_OSC / value / 2);")
+        else:
+            frame_data.append("        return value == 0.0 ? 0 : rio_frame_int32(PRU_OSC / value);")
+    frame_data.append("    }")
+    frame_data.append("    return 0;")
+    frame_data.append("}")
+    frame_data.append("")
+    if project["joints_gear"]:
+        frame_data.append("// frameio.gear_to_cmd(): steps per encoder count -> Q16.16")
+        frame_data.append("static inline int32_t rio_frame_gear_cmd(double ratio) {")
+        frame_data.append("    return rio_frame_int32(floor(ratio * (1 << GEAR_FRAC) + 0.5));")
+        frame_data.append("}")
+        frame_data.append("")
+
+    # bit order of frameio.Frame.pack_bits()
+    frame_data.append("// frameio.Frame.pack_bits(): douts/dins msb first, joint enables lsb first")
+    frame_data.append("static inline void rio_frame_set_output(txData_t *tx, int num, int value) {")
+    frame_data.append("    if (value) {")
+    frame_data.append("        tx->outputs[num / 8] |= (1 << (7 - num % 8));")
+    frame_data.append("    } else {")
+    frame_data.append("        tx->outputs[num / 8] &= ~(1 << (7 - num % 8));")
+    frame_data.append("    }")
+    frame_data.append("}")
+    frame_data.append("")
+    frame_data.append("static inline void rio_frame_set_enable(txData_t *tx, int num, int value) {")
+    frame_data.append("    if (value) {")
+    frame_data.append("        tx->jointEnable[num / 8] |= (1 << (num % 8));")
+    frame_data.append("    } else {")
+    frame_data.append("        tx->jointEnable[num / 8] &= ~(1 << (num % 8));")
+    frame_data.append("    }")
+    frame_data.append("}")
+    frame_data.append("")
+    frame_data.append("static inline int rio_frame_get_input(const rxData_t *rx, int num) {")
+    frame_data.append("    return (rx->inputs[num / 8] >> (7 - num % 8)) & 1;")
+    frame_data.append("}")
+    frame_data.append("")
+    frame_data.append("#endif")
+    frame_data.append("")
+
+    open(f"{project['LINUXCNC_PATH']}/Components/rio_frame.h", "w").write("\n".join(frame_data))
+
+
 def generate(project):
     print("generating linux-cnc component")
 
@@ -13,22 +193,56 @@ def generate(project):
     if transport == 'UDP':
         rio_data.append("#define TRANSPORT_UDP")
         rio_data.append(f"#define UDP_IP \"{project['jdata'].get('ip', '192.168.10.132')}\"")
+        udp_port = 2390
+        for interface in project['jdata'].get('interface', []):
+            if interface.get('type') == 'udp':
+                udp_port = int(interface.get('port', udp_port))
+        rio_data.append(f"#define UDP_PORT {udp_port}")
     elif transport == 'SERIAL':
         rio_data.append("#define TRANSPORT_SERIAL")
         rio_data.append(f"#define SERIAL_PORT \"{project['jdata'].get('tty', '/dev/ttyUSB1')}\"")
         rio_data.append(f"#define SERIAL_SPEED B{project['jdata']['interface'][0].get('baud', '1000000')}")
+    elif transport == 'MPSSE':
+        # ftdi: vid/pid (hex), interface (A-D), chip select and reset pin (ADBUS, -1: no reset), defaults: iCEBreaker
+        ftdi = project['jdata'].get('ftdi', {})
+        rio_data.append("#define TRANSPORT_MPSSE")
+        rio_data.append(f"#define MPSSE_VID 0x{ftdi.get('vid', '0403')}")
+        rio_data.append(f"#define MPSSE_PID 0x{ftdi.get('pid', '6010')}")
+        rio_data.append(f"#define MPSSE_INTERFACE INTERFACE_{ftdi.get('interface', 'A')}")
+        rio_data.append(f"#define MPSSE_CS {ftdi.get('cs', 4)}")
+        rio_data.append(f"#define MPSSE_RESET {ftdi.get('reset', 7)}")
+        rio_data.append(f"#define MPSSE_DIVISOR {project['timing']['mpsse_divisor']}")
     elif transport == 'SPI':
         rio_data.append("#define TRANSPORT_SPI")
         #rio_data.append("#define SPI_SPEED BCM2835_SPI_CLOCK_DIVIDER_128")
-        rio_data.append("#define SPI_SPEED BCM2835_SPI_CLOCK_DIVIDER_256")
+        rio_data.append(f"#define SPI_SPEED BCM2835_SPI_CLOCK_DIVIDER_{project['timing']['spi_divider']}")
     else:
         print("ERROR: UNKNOWN transport protocol:", transport)
         sys.exit(1)
+    if "fpga_load" in project['jdata']:
+        # bitstream into the fpga at load: ice40 spi slave configuration over the spi lines
+        # pins: creset/cdone as rpi gpio (SPI) or ADBUS (MPSSE, creset is the ftdi reset pin)
+        fpga_load = project['jdata']['fpga_load']
+        if project['jdata'].get('family') != 'ice40' or transport not in ('SPI', 'MPSSE'):
+            print("ERROR: fpga_load: only ice40 over SPI or MPSSE")
+            sys.exit(1)
+        if transport == 'MPSSE':
+            rio_data.append("#define FPGA_CRESET MPSSE_RESET")
+            rio_data.append(f"#define FPGA_CDONE {fpga_load.get('cdone', 6)}")
+        elif 'creset' not in fpga_load or 'cdone' not in fpga_load:
+            print("ERROR: fpga_load: creset and cdone gpio are missing")
+            sys.exit(1)
+        else:
+            rio_data.append(f"#define FPGA_CRESET {fpga_load['creset']}")
+            rio_data.append(f"#define FPGA_CDONE {fpga_load['cdone']}")
     rio_data.append("")
     rio_data.append(f"#define JOINTS               {project['joints']}")
     rio_data.append(f"#define JOINT_ENABLE_BYTES   {project['joints_en_total'] // 8}")
     rio_data.append(f"#define VARIABLE_OUTPUTS     {project['vouts']}")
     rio_data.append(f"#define VARIABLE_INPUTS      {project['vins']}")
+    if project["vins_slow"]:
+        rio_data.append(f"#define VARIABLE_INPUTS_FAST {project['vins_fast']}")
+        rio_data.append(f"#define VARIABLE_INPUTS_SLOW {len(project['vins_slow'])}")
     rio_data.append(f"#define VARIABLES            {max(project['vins'], project['vouts'])}")
     rio_data.append(f"#define DIGITAL_OUTPUTS      {project['douts']}")
     rio_data.append(f"#define DIGITAL_OUTPUT_BYTES {project['douts_total'] // 8}")
@@ -43,17 +257,38 @@ def generate(project):
     if index_num > 0:
         rio_data.append(f"#define INDEX_MAX            {index_num}")
         rio_data.append(f"#define INDEX_INIT           {{{','.join(['0.0'] * index_num)}}}")
+    if project["timestamp"]:
+        rio_data.append("#define RIO_TIMESTAMP")
+    if project["apply_time"]:
+        rio_data.append("#define RIO_APPLY_TIME")
+    if project["vins_slow"]:
+        rio_data.append("#define RIO_MULTIRATE")
+    if project["joints_velocity"]:
+        rio_data.append("#define RIO_DCSERVO")
+        rio_data.append(f"#define JOINT_VELOCITIES     {len(project['joints_velocity'])}")
+    if project["joints_gear"]:
+        rio_data.append("#define RIO_GEAR")
+        rio_data.append(f"#define JOINT_GEARS          {len(project['joints_gear'])}")
+        rio_data.append(f"#define GEAR_FRAC            {frameio.GEAR_FRAC}")
+    if project["soe"]:
+        rio_data.append("#define RIO_SOE")
+        rio_data.append(f"#define SOE_SLOTS            {project['soe']['slots']}")
+        rio_data.append(f"#define SOE_INPUTS           {len(project['soe']['dins'])}")
 
     rio_data.append("")
-    rio_data.append("#define PRU_DATA            0x64617461")
-    rio_data.append("#define PRU_READ            0x72656164")
-    rio_data.append("#define PRU_WRITE           0x77726974")
-    rio_data.append("#define PRU_ESTOP           0x65737470")
+    rio_data.append(f"#define PRU_DATA            0x{frameio.PRU_DATA:x}")
+    rio_data.append(f"#define PRU_READ            0x{frameio.PRU_READ:x}")
+    rio_data.append(f"#define PRU_WRITE           0x{frameio.PRU_WRITE:x}")
+    rio_data.append(f"#define PRU_ESTOP           0x{frameio.PRU_ESTOP:x}")
+    rio_data.append(f"#define RIO_LAYOUT_HASH     0x{frameio.layout(project)['hash']:08x}")
     rio_data.append("#define STEPBIT             22")
     rio_data.append("#define STEP_MASK           (1L<<STEPBIT)")
     rio_data.append("#define STEP_OFFSET         (1L<<(STEPBIT-1))")
     rio_data.append(f"#define PRU_BASEFREQ        100000000")
     rio_data.append(f"#define PRU_OSC             {project['jdata']['clock']['speed']}")
+    rio_data.append(f"#define RCSERVO_OFFSET      {frameio.RCSERVO_OFFSET}")
+    rio_data.append(f"#define RCSERVO_DIVIDER     {frameio.RCSERVO_DIVIDER}")
+    rio_data.append(f"#define PWM_HIRES_FRAC      {frameio.PWM_HIRES_FRAC}")
     rio_data.append("")
 
     rio_data.append("#define TYPE_VOUT_RAW  0")
@@ -63,6 +298,8 @@ def generate(project):
     rio_data.append("#define TYPE_VOUT_SINE 4")
     rio_data.append("#define TYPE_VOUT_FREQ 5")
     rio_data.append("#define TYPE_VOUT_UDPOTI 6")
+    rio_data.append("#define TYPE_VOUT_PWM_HIRES 7")
+    rio_data.append("#define TYPE_VOUT_PWMDIR_HIRES 8")
 
     rio_data.append("#define TYPE_VIN_RAW  0")
     rio_data.append("#define TYPE_VIN_FREQ 1")
@@ -71,6 +308,9 @@ def generate(project):
     rio_data.append("#define TYPE_VIN_ADC 4")
     rio_data.append("#define TYPE_VIN_ENCODER 5")
     rio_data.append("#define TYPE_VIN_NTC 6")
+    rio_data.append("#define TYPE_VIN_FIXED 7")
+    rio_data.append("#define TYPE_VIN_ADC_SEQ 8")
+    rio_data.append("#define TYPE_VIN_NTC_SEQ 9")
 
     rio_data.append("#define JOINT_FB_REL 0")
     rio_data.append("#define JOINT_FB_ABS 1")
@@ -78,89 +318,78 @@ def generate(project):
     rio_data.append("#define JOINT_STEPPER 0")
     rio_data.append("#define JOINT_RCSERVO 1")
     rio_data.append("#define JOINT_PWMDIR  2")
+    rio_data.append("#define JOINT_DCSERVO 3")
 
     rio_data.append("#define DTYPE_IO 0")
     rio_data.append("#define DTYPE_INDEX 1")
 
+    frame_layout = frameio.layout(project)
+
+    vout_types = {
+        "raw": "TYPE_VOUT_RAW",
+        "pwm": "TYPE_VOUT_PWM",
+        "pwmdir": "TYPE_VOUT_PWMDIR",
+        "rcservo": "TYPE_VOUT_RCSERVO",
+        "sine": "TYPE_VOUT_SINE",
+        "frequency": "TYPE_VOUT_FREQ",
+        "udpoti": "TYPE_VOUT_UDPOTI",
+        "pwm_hires": "TYPE_VOUT_PWM_HIRES",
+        "pwmdir_hires": "TYPE_VOUT_PWMDIR_HIRES",
+    }
+    vin_types = {
+        "raw": "TYPE_VIN_RAW",
+        "frequency": "TYPE_VIN_FREQ",
+        "time": "TYPE_VIN_TIME",
+        "sonar": "TYPE_VIN_SONAR",
+        "adc": "TYPE_VIN_ADC",
+        "encoder": "TYPE_VIN_ENCODER",
+        "ntc": "TYPE_VIN_NTC",
+        "fixed": "TYPE_VIN_FIXED",
+        "adc_seq": "TYPE_VIN_ADC_SEQ",
+        "ntc_seq": "TYPE_VIN_NTC_SEQ",
+    }
+
     vouts_min = []
     vouts_max = []
     vouts_type = []
     vouts_freq = []
-    for vout in project["voutnames"]:
-        freq = vout.get('frequency', 10000)
-        if vout.get('type') == "sine":
-            vouts_min.append(str(vout.get("min", -100)))
-            vouts_max.append(str(vout.get("max", 100.0)))
-            vouts_freq.append("30")
-        elif vout.get('type') == "pwm":
-            if vout.get('dir'):
-                vouts_min.append("0")
-            else:
-                vouts_min.append(str(vout.get("min", 0)))
-            vouts_max.append(str(vout.get("max", 100.0)))
-            vouts_freq.append(str(vout.get("frequency", freq)))
-        elif vout.get('type') == "rcservo":
-            freq = vout.get('frequency', 100)
-            vouts_min.append(str(vout.get("min", -100)))
-            vouts_max.append(str(vout.get("max", 100.0)))
-            vouts_freq.append(str(vout.get("frequency", freq)))
-        else:
-            vouts_min.append(str(vout.get("min", 0)))
-            vouts_max.append(str(vout.get("max", 10.0)))
-            vouts_freq.append(str(vout.get("frequency", freq)))
-
-        if vout.get('type') == "vout_pwm" and vout.get('dir'):
-            vouts_type.append(f"TYPE_{vout['type'].upper()}DIR")
-        elif vout.get('type') == "vout_frequency":
-            vouts_type.append(f"TYPE_VOUT_FREQ")
-        elif vout.get('type') == "vout_pwm":
-            vouts_type.append(f"TYPE_VOUT_PWM")
-        elif vout.get('type') == "vout_sine":
-            vouts_type.append(f"TYPE_VOUT_SINE")
-        elif vout.get('type') == "vout_udpoti":
-            vouts_type.append(f"TYPE_VOUT_UDPOTI")
-        else:
-            vouts_type.append(f"TYPE_VOUT_RAW")
+    for vout in frame_layout["vouts"]:
+        vouts_min.append(str(vout["min"]))
+        vouts_max.append(str(vout["max"]))
+        vouts_freq.append(str(vout["freq"]))
+        vouts_type.append(vout_types[vout["type"]])
 
     vins_type = []
-    for vin in project["vinnames"]:
-        if vin.get('type') == "vin_frequency":
-            vins_type.append(f"TYPE_VIN_FREQ")
-        elif vin.get('type') == "vin_pwmcounter":
-            vins_type.append(f"TYPE_VIN_TIME")
-        elif vin.get('type') == "vin_ads1115" and vin.get('sensor') == "NTC":
-            vins_type.append(f"TYPE_VIN_NTC")
-        elif vin.get('type') == "vin_ads1115":
-            vins_type.append(f"TYPE_VIN_ADC")
-        elif vin.get('type') in ("vin_quadencoder", "vin_quadencoderz"):
-            vins_type.append(f"TYPE_VIN_ENCODER")
-        else:
-            vins_type.append(f"TYPE_VIN_RAW")
+    for vin in frame_layout["vins"]:
+        vins_type.append(vin_types[vin["type"]])
 
     rio_data.append(f"float vout_min[VARIABLE_OUTPUTS] = {{{', '.join(vouts_min)}}};")
     rio_data.append(f"float vout_max[VARIABLE_OUTPUTS] = {{{', '.join(vouts_max)}}};")
     rio_data.append(f"float vout_freq[VARIABLE_OUTPUTS] = {{{', '.join(vouts_freq)}}};")
     rio_data.append(f"uint8_t vout_type[VARIABLE_OUTPUTS] = {{{', '.join(vouts_type)}}};")
     rio_data.append(f"uint8_t vin_type[VARIABLE_INPUTS] = {{{', '.join(vins_type)}}};")
+    if project["vins_slow"]:
+        slow_divisors = [str(vin["divisor"]) for vin in frame_layout["vins"] if "slow" in vin]
+        slow_vins = [str(num) for num in project["vins_slow"]]
+        rio_data.append(f"uint32_t slow_divisor[VARIABLE_INPUTS_SLOW] = {{{', '.join(slow_divisors)}}};")
+        rio_data.append(f"uint16_t slow_vin[VARIABLE_INPUTS_SLOW] = {{{', '.join(slow_vins)}}};")
+    if project["soe"]:
+        soe_dins = [str(num) for num in project["soe"]["dins"]]
+        rio_data.append(f"uint16_t soe_din[SOE_INPUTS] = {{{', '.join(soe_dins)}}};")
+    if project["joints_gear"]:
+        gear_joints = [str(entry["joint"]) for entry in project["joints_gear"]]
+        gear_vins = [str(entry["vin"]) for entry in project["joints_gear"]]
+        rio_data.append(f"uint16_t gear_joint[JOINT_GEARS] = {{{', '.join(gear_joints)}}};")
+        rio_data.append(f"uint16_t gear_vin[JOINT_GEARS] = {{{', '.join(gear_vins)}}};")
     rio_data.append("")
 
     joints_fb_type = []
-    for num, joint in enumerate(project["jointnames"]):
-        if joint.get('type') == "joint_rcservo":
-            joints_fb_type.append("JOINT_FB_ABS")
-        else:
-            joints_fb_type.append("JOINT_FB_REL")
+    joints_type = []
+    for joint in frame_layout["joints"]:
+        joints_fb_type.append(f"JOINT_FB_{joint['feedback'].upper()}")
+        joints_type.append(f"JOINT_{joint['type'].upper()}")
     rio_data.append(f"uint8_t joints_fb_type[JOINTS] = {{{', '.join(joints_fb_type)}}};")
     rio_data.append("")
-
-    joints_type = []
-    for num, joint in enumerate(project["jointnames"]):
-        if joint.get('type') == "joint_rcservo":
-            joints_type.append("JOINT_RCSERVO")
-        elif joint.get('type') == "joint_pwmdir":
-            joints_type.append("JOINT_PWMDIR")
-        else:
-            joints_type.append("JOINT_STEPPER")
     rio_data.append(f"uint8_t joints_type[JOINTS] = {{{', '.join(joints_type)}}};")
     rio_data.append("")
 
@@ -170,7 +399,17 @@ def generate(project):
     rio_data.append("    };")
     rio_data.append("    struct {")
     rio_data.append("        int32_t header;")
+    if project["apply_time"]:
+        rio_data.append("        uint32_t applyTime;")
+    if project["vins_slow"]:
+        rio_data.append("        uint32_t slowSelect;")
+    if project["soe"]:
+        rio_data.append("        uint32_t soeAck;")
     rio_data.append("        int32_t jointFreqCmd[JOINTS];")
+    if project["joints_velocity"]:
+        rio_data.append("        int32_t jointVelCmd[JOINT_VELOCITIES];")
+    if project["joints_gear"]:
+        rio_data.append("        int32_t jointGearRatio[JOINT_GEARS];")
     rio_data.append("        int32_t setPoint[VARIABLE_OUTPUTS];")
     rio_data.append("        uint8_t jointEnable[JOINT_ENABLE_BYTES];")
     rio_data.append("        uint8_t outputs[DIGITAL_OUTPUT_BYTES];")
@@ -184,12 +423,28 @@ def generate(project):
     rio_data.append("    };")
     rio_data.append("    struct {")
     rio_data.append("        int32_t header;")
+    if project["timestamp"]:
+        rio_data.append("        uint32_t timestamp;")
     rio_data.append("        int32_t jointFeedback[JOINTS];")
-    rio_data.append("        int32_t processVariable[VARIABLE_INPUTS];")
+    if project["vins_slow"]:
+        rio_data.append("        int32_t processVariable[VARIABLE_INPUTS_FAST];")
+        rio_data.append("        uint32_t slowIndex;")
+        rio_data.append("        int32_t slowValue;")
+    else:
+        rio_data.append("        int32_t processVariable[VARIABLE_INPUTS];")
+    if project["soe"]:
+        rio_data.append("        uint32_t soeStatus;")
+        rio_data.append("        uint32_t soeEvents[SOE_SLOTS * 2];")
     rio_data.append("        uint8_t inputs[DIGITAL_INPUT_BYTES];")
     rio_data.append("    };")
     rio_data.append("} rxData_t;")
     rio_data.append("")
+    rio_data.append("// frame layout offsets (checked against the unions in rio.c)")
+    for field in frame_layout["tx"]:
+        rio_data.append(f"#define TX_OFFSET_{field['name'].upper():<20} {field['offset']}")
+    for field in frame_layout["rx"]:
+        rio_data.append(f"#define RX_OFFSET_{field['name'].upper():<20} {field['offset']}")
+    rio_data.append("")
     rio_data.append("#endif")
     rio_data.append("")
 
@@ -244,6 +499,9 @@ def generate(project):
 
 
     open(f"{project['LINUXCNC_PATH']}/Components/rio.h", "w").write("\n".join(rio_data))
+    open(f"{project['LINUXCNC_PATH']}/Components/rio-layout.json", "w").write(frameio.layout_json(project))
+    generate_convert(project, frame_layout)
+    generate_frame(project, frame_layout)
 
     os.system(f"cp -a generators/linuxcnc_component/*.c {project['LINUXCNC_PATH']}/Components/")
     os.system(f"cp -a generators/linuxcnc_component/*.h {project['LINUXCNC_PATH']}/Components/")
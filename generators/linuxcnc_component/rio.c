@@ -30,6 +30,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 
 #include "rio.h"
 
@@ -51,6 +52,9 @@
 #include "bcm2835.h"
 #include "bcm2835.c"
 #endif
+#ifdef TRANSPORT_MPSSE
+#include "rio_mpsse.h"
+#endif
 
 #define MODNAME "rio"
 #define PREFIX "rio"
@@ -61,6 +65,26 @@ MODULE_LICENSE("GPL v2");
 
 char *ctrl_type[JOINTS] = { "p" };
 RTAPI_MP_ARRAY_STRING(ctrl_type, JOINTS, "control type (pos or vel)");
+char *comp_file[JOINTS] = { 0, };
+RTAPI_MP_ARRAY_STRING(comp_file, JOINTS, "compensation table per joint (nominal forward reverse)");
+int aux_split = 0;
+RTAPI_MP_INT(aux_split, "vins, vouts and digital i/o in rio.aux (slower thread)");
+int layout_check = 1;
+RTAPI_MP_INT(layout_check, "check the layout hash of the gateware at load");
+#ifdef FPGA_CDONE
+char *bitstream = "";
+RTAPI_MP_STRING(bitstream, "bitstream, loaded into the fpga at load (ice40 spi slave configuration)");
+#endif
+#ifdef TRANSPORT_MPSSE
+int mpsse_async = 0;
+RTAPI_MP_INT(mpsse_async, "usb transfer in the background, the answer is read one servo period later");
+#endif
+#ifdef RIO_SOE
+int soe_key = 0x52494f53;
+RTAPI_MP_INT(soe_key, "shared memory key of the sequence of events stream");
+int soe_depth = 1024;
+RTAPI_MP_INT(soe_depth, "entries of the sequence of events stream");
+#endif
 
 /***********************************************************************
 *                STRUCTURES AND GLOBAL VARIABLES                       *
@@ -93,6 +117,10 @@ typedef struct {
     float 			scale_recip[JOINTS];		// reciprocal value used for scaling
     float			prev_cmd[JOINTS];
     float			cmd_d[JOINTS];					// command derivative
+    double			comp_last[JOINTS];			// last position command (position units)
+    double			comp_reverse[JOINTS];		// backlash direction (0: forward, 1: reverse)
+    double			motor_cmd[JOINTS];			// position command with compensation
+    double			motor_fb[JOINTS];			// position feedback without compensation
     hal_float_t 	*setPoint[VARIABLE_OUTPUTS];
     hal_float_t 	*setPointOffset[VARIABLE_OUTPUTS];
     hal_float_t 	*setPointScale[VARIABLE_OUTPUTS];
@@ -106,12 +134,76 @@ typedef struct {
 #ifdef INDEX_MAX
     hal_bit_t   	*index_enable[INDEX_MAX];
 #endif
+#ifdef RIO_TIMESTAMP
+    hal_u32_t   	*timestamp;					// pin: fpga tick of the last answer frame
+    hal_bit_t   	*dpll_locked;				// pin: host period locked to the fpga clock
+    hal_float_t 	*dpll_error;				// pin: phase error of the last frame (us)
+    hal_float_t 	*dpll_clock;				// pin: measured fpga clock (Hz)
+#endif
+#ifdef RIO_APPLY_TIME
+    hal_float_t 	dpll_phase;					// param: apply time after the expected frame (periods)
+#endif
+#ifdef RIO_MULTIRATE
+    hal_u32_t   	*processVariableAge[VARIABLE_INPUTS_SLOW];	// pin: frames since the last update of a slow vin
+#endif
+#ifdef RIO_GEAR
+    hal_float_t 	*gear_ratio[JOINT_GEARS];	// pin: position units per encoder unit (0: off)
+    int				gear_index[JOINTS];			// geared joint number, -1: none
+#endif
+#ifdef RIO_SOE
+    hal_u32_t   	*soe_events;				// pin: received events
+    hal_u32_t   	*soe_lost;					// pin: edges lost in the fpga (fifo full)
+    hal_u32_t   	*soe_overrun;				// pin: events dropped, the stream was full
+#endif
 } data_t;
 
 static data_t *data;
 static txData_t txData;
 static rxData_t rxData;
 
+// the frame layout is shared with the gateware and the test tools (rio-layout.json),
+// rio_frame.h checks the unions against it and packs the values
+#include "rio_frame.h"
+
+#ifdef RIO_MULTIRATE
+// multi-rate: the slow vins share one slot of the answer frame, the host selects
+// the next one (earliest deadline first, due in frames) and keeps the last values
+static int32_t		slowVariable[VARIABLE_INPUTS_SLOW];
+static uint32_t		slowDue[VARIABLE_INPUTS_SLOW];
+static uint32_t		slowStamp[VARIABLE_INPUTS_SLOW];
+static uint32_t		frameCount = 0;
+static uint32_t slow_schedule(void);
+#endif
+
+#ifdef RIO_SOE
+// sequence of events: the edges are acknowledged by the next expected sequence number,
+// the events of lost frames are sent again by the fpga.
+// the events go to a hal stream (tick, din number, level), readable from userspace
+// with hal_stream_attach() (key: soe_key, typestring "uub")
+static hal_stream_t	soeStream;
+static uint16_t		soeNext = 0;
+static void soe_decode(void);
+#endif
+
+#include "rio_convert.h"
+#include "rio_comp.h"
+#include "rio_loop.h"
+
+// aux split (aux_split=1): rio.readwrite only handles the joints (and the index bits),
+// rio.aux converts the vins, vouts and digital i/o in a slower thread.
+// the frame is not changed, the aux values ride on the next frame.
+// rio.aux is preempted by the servo-thread, never the other way round:
+//   vouts/douts: rio.aux fills the unused one of two buffers and publishes it (auxTxReady)
+//   vins/dins: rio.readwrite copies the answer under a sequence counter, rio.aux retries when it changed
+static txData_t		auxTx[2];
+static volatile int	auxTxReady = -1;
+static rxData_t		auxRx;
+static volatile uint32_t auxRxSeq = 0;
+static long			auxStamp = 0;
+
+// compensation tables, loaded at init (comp_file)
+static comp_table_t comp[JOINTS];
+
 long stamp = 0;
 
 
@@ -133,13 +225,41 @@ static int32_t		accum_diff = 0;
 
 typedef enum CONTROL { POSITION, VELOCITY, INVALID } CONTROL;
 
+#ifdef RIO_TIMESTAMP
+// digital pll, follows the fpga timestamps of the answer frames with a grid of
+// one servo period, the step of the grid is the fpga clock measured in ticks per period
+#define DPLL_KP             0.05
+#define DPLL_KI             0.002
+#define DPLL_LOCK_COUNT     100
+#define DPLL_LOCK_TICKS     (PRU_OSC / 100000)		// 10us
+#define DPLL_REBASE         (1LL<<40)
+
+typedef struct {
+    bool		valid;
+    bool		locked;
+    long		period;			// servo period (ns) of the current step
+    uint32_t	last;			// last raw timestamp
+    int64_t		tick;			// unwrapped timestamp
+    double		grid;			// expected tick of the current frame
+    double		step;			// fpga ticks per servo period
+    double		err;			// phase error (ticks)
+    int			count;			// frames in lock range
+} dpll_t;
+
+static dpll_t dpll;
+static void dpll_update(uint32_t timestamp, long period);
+#ifdef RIO_APPLY_TIME
+static uint32_t dpll_apply_time(void);
+#endif
+#endif
+
 static int reset_gpio_pin = 25;				// RPI GPIO pin number used to force watchdog reset of the PRU
 
 
 
 #ifdef TRANSPORT_UDP
-#define DST_PORT 2390
-#define SRC_PORT 2390
+#define DST_PORT UDP_PORT
+#define SRC_PORT UDP_PORT
 #define SEND_TIMEOUT_US 10
 #define RECV_TIMEOUT_US 10
 #define READ_PCK_DELAY_NS 10000
@@ -157,14 +277,31 @@ static int UDP_init(void);
 int serial_fd = -1;
 #endif
 
+#ifdef TRANSPORT_MPSSE
+static mpsse_t mpsse;
+static uint8_t mpsseRx[SPIBUFSIZE];		// answer of the pending frame (mpsse_async)
+static uint8_t mpssePoll[SPIBUFSIZE];		// frame without header: dropped by the spi slave, only answered
+#endif
+
 /***********************************************************************
 *                  LOCAL FUNCTION DECLARATIONS                         *
 ************************************************************************/
+#ifdef TRANSPORT_SPI
 static int rt_bcm2835_init(void);
+#endif
 
 static void update_freq(void *arg, long period);
 static void rio_readwrite();
+static void rio_aux();
+static void rio_write_aux(txData_t *tx);
+static void rio_write_index(txData_t *tx);
+static void rio_read_aux(const rxData_t *rx, long duration);
+static void rio_read_index(const rxData_t *rx);
 static void rio_transfer();
+static int rio_identify(void);
+#ifdef FPGA_CDONE
+static int rio_fpga_load(const char *filename);
+#endif
 static CONTROL parse_ctrl_type(const char *ctrl);
 
 /***********************************************************************
@@ -237,6 +374,33 @@ int rtapi_app_main(void)
         return -1;
     }
 
+    // compensation tables (optional per joint)
+    for (n = 0; n < JOINTS; n++) {
+        comp_init(&comp[n]);
+        data->comp_last[n] = 0.0;
+        data->comp_reverse[n] = 0.0;
+        data->motor_cmd[n] = 0.0;
+        data->motor_fb[n] = 0.0;
+    }
+    for (n = 0; n < JOINTS; n++) {
+        if (comp_file[n] == NULL || comp_file[n][0] == 0) {
+            continue;
+        }
+        retval = comp_load(&comp[n], comp_file[n]);
+        if (retval < 0) {
+            rtapi_print_msg(RTAPI_MSG_ERR,
+                            "%s: ERROR: joint %i: can not load the compensation table '%s' (%i)\n",
+                            modname, n, comp_file[n], retval);
+            for (bn = 0; bn < JOINTS; bn++) {
+                comp_free(&comp[bn]);
+            }
+            hal_exit(comp_id);
+            return -1;
+        }
+        rtapi_print_msg(RTAPI_MSG_INFO, "%s: joint %i: %i compensation points\n", modname, n, retval);
+    }
+    retval = 0;
+
 
 #ifdef TRANSPORT_UDP
     // Initialize the UDP socket
@@ -257,6 +421,17 @@ int rtapi_app_main(void)
     set_interface_attribs (serial_fd, SERIAL_SPEED, 0);
 #endif
 
+#ifdef TRANSPORT_MPSSE
+    rtapi_print("Info: Initialize MPSSE connection\n");
+    retval = mpsse_open(&mpsse, MPSSE_VID, MPSSE_PID, MPSSE_INTERFACE, MPSSE_DIVISOR, MPSSE_CS, MPSSE_RESET);
+    if (retval < 0) {
+        rtapi_print_msg(RTAPI_MSG_ERR, "%s: ERROR: ftdi %04x:%04x setup failed (%i)\n", modname, MPSSE_VID, MPSSE_PID, retval);
+        hal_exit(comp_id);
+        return -1;
+    }
+    retval = 0;
+#endif
+
 #ifdef TRANSPORT_SPI
     rtapi_print("Info: Initialize SPI connection\n");
     // Map the RPi BCM2835 peripherals - uses "rtapi_open_as_root" in place of "open"
@@ -300,6 +475,74 @@ int rtapi_app_main(void)
                               comp_id, "%s.PRU-reset", prefix);
     if (retval != 0) goto error;
 
+#ifdef RIO_TIMESTAMP
+    retval = hal_pin_u32_newf(HAL_OUT, &(data->timestamp),
+                              comp_id, "%s.timestamp", prefix);
+    if (retval != 0) goto error;
+
+    retval = hal_pin_bit_newf(HAL_OUT, &(data->dpll_locked),
+                              comp_id, "%s.dpll.locked", prefix);
+    if (retval != 0) goto error;
+
+    retval = hal_pin_float_newf(HAL_OUT, &(data->dpll_error),
+                                comp_id, "%s.dpll.error-us", prefix);
+    if (retval != 0) goto error;
+
+    retval = hal_pin_float_newf(HAL_OUT, &(data->dpll_clock),
+                                comp_id, "%s.dpll.clock", prefix);
+    if (retval != 0) goto error;
+#endif
+
+#ifdef RIO_APPLY_TIME
+    retval = hal_param_float_newf(HAL_RW, &(data->dpll_phase),
+                                  comp_id, "%s.dpll.phase", prefix);
+    if (retval != 0) goto error;
+    data->dpll_phase = 0.5;
+#endif
+
+
+#ifdef RIO_MULTIRATE
+    for (n = 0; n < VARIABLE_INPUTS_SLOW; n++) {
+        retval = hal_pin_u32_newf(HAL_OUT, &(data->processVariableAge[n]),
+                                  comp_id, "%s.%s-age", prefix, vin_names[slow_vin[n]]);
+        if (retval != 0) goto error;
+        *(data->processVariableAge[n]) = 0;
+        slowVariable[n] = 0;
+        slowDue[n] = n;
+        slowStamp[n] = 0;
+    }
+#endif
+
+#ifdef RIO_GEAR
+    for (n = 0; n < JOINTS; n++) {
+        data->gear_index[n] = -1;
+    }
+    for (n = 0; n < JOINT_GEARS; n++) {
+        retval = hal_pin_float_newf(HAL_IN, &(data->gear_ratio[n]),
+                                    comp_id, "%s.joint.%01d.gear-ratio", prefix, gear_joint[n]);
+        if (retval < 0) goto error;
+        *(data->gear_ratio[n]) = 0.0;
+        data->gear_index[gear_joint[n]] = n;
+    }
+#endif
+
+#ifdef RIO_SOE
+    retval = hal_pin_u32_newf(HAL_OUT, &(data->soe_events),
+                              comp_id, "%s.soe.events", prefix);
+    if (retval != 0) goto error;
+
+    retval = hal_pin_u32_newf(HAL_OUT, &(data->soe_lost),
+                              comp_id, "%s.soe.lost", prefix);
+    if (retval != 0) goto error;
+
+    retval = hal_pin_u32_newf(HAL_OUT, &(data->soe_overrun),
+                              comp_id, "%s.soe.overrun", prefix);
+    if (retval != 0) goto error;
+
+    retval = hal_stream_create(&soeStream, comp_id, soe_key, soe_depth, "uub");
+    if (retval < 0) goto error;
+#endif
+
 
     // export all the variables for each joint
     for (n = 0; n < JOINTS; n++) {
@@ -411,6 +654,11 @@ int rtapi_app_main(void)
             retval = hal_pin_float_newf(HAL_IN, &(data->processVariableExtra[n][1]), comp_id, "%s.%s-last", prefix, vin_names[n]);
             if (retval < 0) goto error;
             *(data->processVariableExtra[n][1]) = 0.0;
+        } else if (vin_type[n] == TYPE_VIN_ADC_SEQ || vin_type[n] == TYPE_VIN_NTC_SEQ) {
+            // sample count of the adc (changes with every new value, continuous mode)
+            retval = hal_pin_float_newf(HAL_OUT, &(data->processVariableExtra[n][0]), comp_id, "%s.%s-seq", prefix, vin_names[n]);
+            if (retval < 0) goto error;
+            *(data->processVariableExtra[n][0]) = 0.0;
         }
     }
 
@@ -460,6 +708,25 @@ error:
     }
 
 
+#ifdef FPGA_CDONE
+    if (bitstream != NULL && bitstream[0] != 0) {
+        retval = rio_fpga_load(bitstream);
+        if (retval < 0) {
+            rtapi_print_msg(RTAPI_MSG_ERR,
+                            "%s: ERROR: loading the bitstream %s failed (%i)\n", modname, bitstream, retval);
+            hal_exit(comp_id);
+            return -1;
+        }
+        rtapi_print_msg(RTAPI_MSG_INFO, "%s: fpga configured with %s (%i bytes)\n", modname, bitstream, retval);
+    }
+#endif
+
+    // the gateware has to be generated from the same config
+    if (layout_check && rio_identify() < 0) {
+        hal_exit(comp_id);
+        return -1;
+    }
+
     // Export functions
     rtapi_snprintf(name, sizeof(name), "%s.update-freq", prefix);
     retval = hal_export_funct(name, update_freq, data, 1, 0, comp_id);
@@ -479,6 +746,17 @@ error:
         return -1;
     }
 
+    if (aux_split) {
+        rtapi_snprintf(name, sizeof(name), "%s.aux", prefix);
+        retval = hal_export_funct(name, rio_aux, data, 1, 0, comp_id);
+        if (retval < 0) {
+            rtapi_print_msg(RTAPI_MSG_ERR,
+                            "%s: ERROR: aux function export failed\n", modname);
+            hal_exit(comp_id);
+            return -1;
+        }
+    }
+
     rtapi_print_msg(RTAPI_MSG_INFO, "%s: installed driver\n", modname);
     hal_ready(comp_id);
     return 0;
@@ -486,6 +764,19 @@ error:
 
 void rtapi_app_exit(void)
 {
+    int n;
+    for (n = 0; n < JOINTS; n++) {
+        comp_free(&comp[n]);
+    }
+#ifdef RIO_SOE
+    hal_stream_destroy(&soeStream);
+#endif
+#ifdef TRANSPORT_MPSSE
+    if (mpsse_pending(&mpsse)) {
+        mpsse_wait(&mpsse, SPIBUFSIZE);
+    }
+    mpsse_close(&mpsse);
+#endif
     hal_exit(comp_id);
 }
 
@@ -700,7 +991,7 @@ void update_freq(void *arg, long period)
     data_t *data = (data_t *)arg;
     double max_ac, vel_cmd, dv, new_vel, max_freq, desired_freq;
 
-    double error, command, feedback;
+    double command, feedback;
     double periodfp, periodrecip;
     float pgain, ff1gain, deadband;
 
@@ -794,21 +1085,12 @@ void update_freq(void *arg, long period)
                 deadband = 1 / data->pos_scale[i];
             }
 
-            // read the command and feedback
-            command = *(data->pos_cmd[i]);
-            feedback = *(data->pos_fb[i]);
-
-            // calcuate the error
-            error = command - feedback;
-
-            // apply the deadband
-            if (error > deadband) {
-                error -= deadband;
-            } else if (error < -deadband) {
-                error += deadband;
-            } else {
-                error = 0;
-            }
+            // read the command and feedback (compensation: machine position -> motor position)
+            data->comp_reverse[i] = comp_direction(data->comp_reverse[i], *(data->pos_cmd[i]) - data->comp_last[i]);
+            data->comp_last[i] = *(data->pos_cmd[i]);
+            command = *(data->pos_cmd[i]) - comp_error(&comp[i], *(data->pos_cmd[i]), data->comp_reverse[i]);
+            data->motor_cmd[i] = command;
+            feedback = data->motor_fb[i];
 
             // calcuate command and derivatives
             data->cmd_d[i] = (command - data->prev_cmd[i]) * periodrecip;
@@ -816,8 +1098,14 @@ void update_freq(void *arg, long period)
             // save old values
             data->prev_cmd[i] = command;
 
-            // calculate the output value
-            vel_cmd = pgain * error + data->cmd_d[i] * ff1gain;
+            // calculate the output value (see rio_loop.h)
+            vel_cmd = loop_position(command, feedback, data->cmd_d[i], pgain, ff1gain, deadband);
+#ifdef RIO_GEAR
+            // geared joint: the gateware follows the encoder, the host only trims the phase
+            if (data->gear_index[i] >= 0 && *(data->gear_ratio[data->gear_index[i]]) != 0.0) {
+                vel_cmd = loop_position(command, feedback, 0.0, pgain, 0.0, deadband);
+            }
+#endif
 
         } else {
             /* VELOCITY CONTROL MODE */
@@ -827,24 +1115,11 @@ void update_freq(void *arg, long period)
 
         vel_cmd = vel_cmd * data->pos_scale[i];
 
-        // apply frequency limit
-        if (vel_cmd > max_freq) {
-            vel_cmd = max_freq;
-        } else if (vel_cmd < -max_freq) {
-            vel_cmd = -max_freq;
-        }
-
         // calc max change in frequency in one period
         dv = max_ac * dt;
 
-        // apply accel limit
-        if ( vel_cmd > (data->freq[i] + dv) ) {
-            new_vel = data->freq[i] + dv;
-        } else if ( vel_cmd < (data->freq[i] - dv) ) {
-            new_vel = data->freq[i] - dv;
-        } else {
-            new_vel = vel_cmd;
-        }
+        // apply frequency and accel limit
+        new_vel = loop_limit(vel_cmd, data->freq[i], max_freq, dv);
 
         // test for disabled stepgen
         if (*data->stepperEnable == 0) {
@@ -859,10 +1134,150 @@ void update_freq(void *arg, long period)
 }
 
 
+#ifdef RIO_TIMESTAMP
+void dpll_update(uint32_t timestamp, long period)
+{
+    double n;
+    int64_t offset;
+
+    if (period <= 0) {
+        return;
+    }
+
+    if (!dpll.valid || period != dpll.period) {
+        // (re)start with the nominal clock
+        dpll.valid = true;
+        dpll.locked = false;
+        dpll.period = period;
+        dpll.last = timestamp;
+        dpll.tick = timestamp;
+        dpll.grid = timestamp;
+        dpll.step = (double)PRU_OSC * period / 1000000000.0;
+        dpll.err = 0.0;
+        dpll.count = 0;
+    } else {
+        // unwrap the 32bit counter (wraps after 42s @100MHz)
+        dpll.tick += (uint32_t)(timestamp - dpll.last);
+        dpll.last = timestamp;
+
+        // number of periods since the last frame (missed frames)
+        n = floor((dpll.tick - dpll.grid) / dpll.step + 0.5);
+        if (n < 1.0) {
+            n = 1.0;
+        }
+        dpll.grid += n * dpll.step;
+        dpll.err = dpll.tick - dpll.grid;
+
+        if (fabs(dpll.err) > dpll.step / 4.0) {
+            // phase jump, restart on this frame
+            dpll.grid = dpll.tick;
+            dpll.err = 0.0;
+            dpll.count = 0;
+            dpll.locked = false;
+        } else {
+            dpll.grid += DPLL_KP * dpll.err;
+            dpll.step += DPLL_KI * dpll.err / n;
+            if (fabs(dpll.err) < DPLL_LOCK_TICKS) {
+                if (dpll.count < DPLL_LOCK_COUNT) {
+                    dpll.count++;
+                }
+            } else {
+                dpll.count = 0;
+            }
+            dpll.locked = (dpll.count >= DPLL_LOCK_COUNT);
+        }
+
+        // keep the doubles small
+        if (dpll.tick > DPLL_REBASE) {
+            offset = (int64_t)dpll.grid;
+            dpll.tick -= offset;
+            dpll.grid -= offset;
+        }
+    }
+
+    *(data->timestamp) = timestamp;
+    *(data->dpll_locked) = dpll.locked;
+    *(data->dpll_error) = dpll.err * 1000000.0 / PRU_OSC;
+    *(data->dpll_clock) = dpll.step * 1000000000.0 / period;
+}
+
+#ifdef RIO_APPLY_TIME
+uint32_t dpll_apply_time(void)
+{
+    // the next frame is expected one period after the last one, the commands are
+    // applied dpll.phase periods later (0: immediately, as long as not locked)
+    double ahead;
+    uint32_t apply;
+
+    if (!dpll.locked) {
+        return 0;
+    }
+    ahead = dpll.grid + dpll.step * (1.0 + data->dpll_phase) - dpll.tick;
+    apply = dpll.last + (uint32_t)(int64_t)ahead;
+    if (apply == 0) {
+        apply = 1;
+    }
+    return apply;
+}
+#endif
+#endif
+
+
+#ifdef RIO_MULTIRATE
+uint32_t slow_schedule(void)
+{
+    // the slow vin with the earliest due frame (same as frameio.slow_schedule)
+    uint32_t n;
+    uint32_t select = 0;
+
+    frameCount++;
+    for (n = 1; n < VARIABLE_INPUTS_SLOW; n++) {
+        if ((int32_t)(slowDue[n] - slowDue[select]) < 0) {
+            select = n;
+        }
+    }
+    slowDue[select] = frameCount + slow_divisor[select];
+    return select;
+}
+#endif
+
+
+#ifdef RIO_SOE
+void soe_decode(void)
+{
+    // the valid slots in sequence order (same as frameio.soe_decode)
+    uint32_t n;
+    union hal_stream_data event[3];
+
+    for (n = 0; n < SOE_SLOTS; n++) {
+        uint32_t tick = rxData.soeEvents[n * 2];
+        uint32_t info = rxData.soeEvents[n * 2 + 1];
+        uint32_t input = (info >> 16) & 0xFF;
+        if ((info & (1U << 31)) == 0 || (uint16_t)info != soeNext) {
+            continue;
+        }
+        event[0].u = tick;
+        event[1].u = input < SOE_INPUTS ? soe_din[input] : input;
+        event[2].b = (info >> 30) & 1;
+        if (hal_stream_write(&soeStream, event) < 0) {
+            // the reader is too slow, the event is acknowledged anyway
+            *(data->soe_overrun) += 1;
+        }
+        *(data->soe_events) += 1;
+        soeNext++;
+    }
+    *(data->soe_lost) = rxData.soeStatus >> 16;
+    // the fpga was restarted: continue with its sequence number
+    if ((uint16_t)((uint16_t)rxData.soeStatus - soeNext) & 0x8000) {
+        soeNext = (uint16_t)rxData.soeStatus;
+    }
+}
+#endif
+
+
 void rio_readwrite()
 {
     int i = 0;
-    int bi = 0;
     double curr_pos;
     long new_stamp;
     long duration;
@@ -880,81 +1295,58 @@ void rio_readwrite()
             int i = 0;
             // Data header
             txData.header = PRU_WRITE;
-
-            // Joint frequency commands
-            for (i = 0; i < JOINTS; i++) {
-                if (joints_type[i] == JOINT_PWMDIR) {
-                    txData.jointFreqCmd[i] = data->freq[i];
-                } else if (joints_type[i] == JOINT_STEPPER) {
-                    txData.jointFreqCmd[i] = PRU_OSC / data->freq[i] / 2;
-                } else {
-                    txData.jointFreqCmd[i] = PRU_OSC / data->freq[i];
+#ifdef RIO_APPLY_TIME
+            txData.applyTime = dpll_apply_time();
+#endif
+#ifdef RIO_MULTIRATE
+            txData.slowSelect = slow_schedule();
+#endif
+#ifdef RIO_SOE
+            txData.soeAck = soeNext;
+#endif
+#ifdef RIO_GEAR
+            // steps per encoder count: position units per encoder unit * steps per unit / counts per encoder unit
+            for (i = 0; i < JOINT_GEARS; i++) {
+                double vin_scale = *(data->processVariableScale[gear_vin[i]]);
+                double ratio = 0.0;
+                if (vin_scale != 0.0) {
+                    ratio = *(data->gear_ratio[i]) * data->pos_scale[gear_joint[i]] / vin_scale;
                 }
+                txData.jointGearRatio[i] = rio_frame_gear_cmd(ratio);
             }
+#endif
 
-            for (bi = 0; bi < JOINT_ENABLE_BYTES; bi++) {
-                txData.jointEnable[bi] = 0;
-                for (i = 0; i < JOINTS; i++) {
-                    if (*(data->stepperEnable[bi * 8 + i]) == 1) {
-                        txData.jointEnable[bi] |= (1 << i);
-                    }
+            // Joint frequency commands
+#ifdef RIO_DCSERVO
+            int vi = 0;
+#endif
+            for (i = 0; i < JOINTS; i++) {
+#ifdef RIO_DCSERVO
+                if (joints_type[i] == JOINT_DCSERVO) {
+                    // position loop in the fpga: position and velocity in counts (position mode)
+                    txData.jointFreqCmd[i] = rio_frame_joint_cmd(i, data->motor_cmd[i] * data->pos_scale[i]);
+                    txData.jointVelCmd[vi++] = rio_frame_int32(data->cmd_d[i] * data->pos_scale[i]);
+                    continue;
                 }
+#endif
+                txData.jointFreqCmd[i] = rio_frame_joint_cmd(i, data->freq[i]);
             }
 
-            // Set points
-            for (i = 0; i < VARIABLE_OUTPUTS; i++) {
-
-                float value = *(data->setPoint[i]);
-                value *= *(data->setPointScale[i]);
-                value += *(data->setPointOffset[i]);
-
-                if (vout_type[i] == TYPE_VOUT_SINE) {
-                    txData.setPoint[i] = PRU_OSC / value / vout_freq[i];
-                } else if (vout_type[i] == TYPE_VOUT_PWMDIR) {
-                    if (value > vout_max[i]) {
-                        value = vout_max[i];
-                    }
-                    if (value < -vout_max[i]) {
-                        value = -vout_max[i];
-                    }
-                    txData.setPoint[i] = (value) * (PRU_OSC / vout_freq[i]) / (vout_max[i]);
-                } else if (vout_type[i] == TYPE_VOUT_PWM) {
-                    if (value > vout_max[i]) {
-                        value = vout_max[i];
-                    }
-                    if (value < vout_min[i]) {
-                        value = vout_min[i];
-                    }
-                    txData.setPoint[i] = (value - vout_min[i]) * (PRU_OSC / vout_freq[i]) / (vout_max[i] - vout_min[i]);
-                } else if (vout_type[i] == TYPE_VOUT_RCSERVO) {
-                    txData.setPoint[i] = (value + 200 + 100) * (PRU_OSC / 200000);
-                } else {
-                    txData.setPoint[i] = value;
-                }
+            for (i = 0; i < JOINTS; i++) {
+                rio_frame_set_enable(&txData, i, *(data->stepperEnable[i]) == 1);
             }
 
-            // Outputs
-            int byte_out = 0;
-            int index_num = 0;
-            for (byte_out = 0; byte_out < DIGITAL_OUTPUT_BYTES; byte_out++) {
-                txData.outputs[byte_out] = 0;
-                for (i = 0; i < 8; i++) {
-                    if (byte_out * 8 + i < DIGITAL_OUTPUTS) {
-                        if (dout_types[byte_out * 8 + i] != DTYPE_INDEX) {
-                            if (*(data->outputs[byte_out * 8 + i]) == 1) {
-                                txData.outputs[byte_out] |= (1 << (7-i));		// output is high
-                            }
-                        } else {
-#ifdef INDEX_MAX
-                            if (*(data->index_enable[index_num]) == 1) {
-                                txData.outputs[byte_out] |= (1 << (7-i));
-                            }
-                            index_num++;
-#endif
-                        }
-                    }
+            if (aux_split) {
+                // set points and outputs of the last rio.aux call
+                int ready = auxTxReady;
+                if (ready >= 0) {
+                    memcpy(txData.setPoint, auxTx[ready].setPoint, sizeof(txData.setPoint));
+                    memcpy(txData.outputs, auxTx[ready].outputs, sizeof(txData.outputs));
                 }
+            } else {
+                rio_write_aux(&txData);
             }
+            rio_write_index(&txData);
 
             rio_transfer();
 
@@ -963,6 +1355,10 @@ void rio_readwrite()
                 // we have received a GOOD payload from the PRU
                 *(data->SPIstatus) = 1;
 
+#ifdef RIO_TIMESTAMP
+                dpll_update(rxData.timestamp, old_dtns);
+#endif
+
                 for (i = 0; i < JOINTS; i++) {
                     if (data->fb_scale[i] == 0.0) {
                         data->fb_scale[i] = data->pos_scale[i];
@@ -979,110 +1375,37 @@ void rio_readwrite()
                         curr_pos = (double)(accum[i]);
                         *(data->pos_fb[i]) = (float)((curr_pos+0.5) / data->fb_scale[i]);
                     }
+                    // compensation: motor position -> machine position
+                    data->motor_fb[i] = *(data->pos_fb[i]);
+                    *(data->pos_fb[i]) = data->motor_fb[i] + comp_error(&comp[i], data->motor_fb[i], data->comp_reverse[i]);
                 }
 
-                // Feedback
-                for (i = 0; i < VARIABLE_INPUTS; i++) {
-                    float value = rxData.processVariable[i];
-                    if (vin_type[i] == TYPE_VIN_FREQ) {
-                        if (value != 0) {
-                            value = (float)PRU_OSC / value;
-                        }
-                        value += *(data->processVariableOffset[i]);
-                        value *= *(data->processVariableScale[i]);
-                        *(data->processVariable[i]) = value;
-                        *(data->processVariableS32[i]) = (int)value;
-                    } else if (vin_type[i] == TYPE_VIN_TIME) {
-                        if (value != 0) {
-                            value = 1000.0 / ((float)PRU_OSC / value);
-                        }
-                        value += *(data->processVariableOffset[i]);
-                        value *= *(data->processVariableScale[i]);
-                        *(data->processVariable[i]) = value;
-                        *(data->processVariableS32[i]) = (int)value;
-                    } else if (vin_type[i] == TYPE_VIN_SONAR) {
-                        if (value != 0) {
-                            value = 1000.0 / (float)PRU_OSC / 20.0 * value * 343.2;
-                        }
-                        value += *(data->processVariableOffset[i]);
-                        value *= *(data->processVariableScale[i]);
-                        *(data->processVariable[i]) = value;
-                        *(data->processVariableS32[i]) = (int)value;
-                    } else if (vin_type[i] == TYPE_VIN_ADC) {
-                        value /= 1000.0; // to Volt
-                        value += *(data->processVariableOffset[i]);
-                        value *= *(data->processVariableScale[i]);
-                        *(data->processVariable[i]) = value;
-                        *(data->processVariableS32[i]) = (int)(value * 100); // to mV
-
-
-                    } else if (vin_type[i] == TYPE_VIN_NTC) {
-
-                        value /= 1000.0;
-                        float Rt = 10.0 * value / (3.3 - value);
-                        float tempK = 1.0 / (log(Rt / 10.0) / 3950.0 + 1.0 / (273.15 + 25.0));
-                        float tempC = tempK - 273.15;
-                        value = tempC;
-
-                        value += *(data->processVariableOffset[i]);
-                        value *= *(data->processVariableScale[i]);
-                        *(data->processVariable[i]) = value;
-                        *(data->processVariableS32[i]) = (int)(value);
-
-
-
-                    } else if (vin_type[i] == TYPE_VIN_ENCODER) {
-                        value += *(data->processVariableOffset[i]);
-                        value /= *(data->processVariableScale[i]);
-                        *(data->processVariable[i]) = value;
-                        *(data->processVariableS32[i]) = (int)value;
-
-                        // calc RPM
-                        float last = *(data->processVariableExtra[i][1]);
-                        *(data->processVariableExtra[i][0]) = (value - last) * (1000000000.0 / (float)duration) * 60;
-                        *(data->processVariableExtra[i][1]) = value;
-
-
-                    } else {
-                        value += *(data->processVariableOffset[i]);
-                        value *= *(data->processVariableScale[i]);
-                        *(data->processVariable[i]) = value;
-                        *(data->processVariableS32[i]) = (int)value;
-                    }
+#ifdef RIO_MULTIRATE
+                // the slow vin of this answer (selected by an earlier frame)
+                if (rxData.slowIndex < VARIABLE_INPUTS_SLOW) {
+                    slowVariable[rxData.slowIndex] = rxData.slowValue;
+                    slowStamp[rxData.slowIndex] = frameCount;
                 }
+                for (i = 0; i < VARIABLE_INPUTS_SLOW; i++) {
+                    *(data->processVariableAge[i]) = frameCount - slowStamp[i];
+                }
+#endif
 
-                // Inputs
-                int index_num = 0;
-                for (bi = 0; bi < DIGITAL_INPUT_BYTES; bi++) {
-                    for (i = 0; i < 8; i++) {
-                        if (bi * 8 + i < DIGITAL_INPUTS) {
-                            if (din_types[bi * 8 + i] != DTYPE_INDEX) {
-                                if ((rxData.inputs[bi] & (1 << (7-i))) != 0) {
-                                    *(data->inputs[(bi * 8 + i) * 2]) = 1; 		// input is high
-                                    *(data->inputs[(bi * 8 + i) * 2 + 1]) = 0;  // not
-                                } else {
-                                    *(data->inputs[(bi * 8 + i) * 2]) = 0;			// input is low
-                                    *(data->inputs[(bi * 8 + i) * 2 + 1]) = 1;  // not
-                                }
-                            } else {
-                                float ibit = 0;
-                                if ((rxData.inputs[bi] & (1 << (7-i))) != 0) {
-                                    ibit = 1;
-                                }
-#ifdef INDEX_MAX
-                                if (ibit != index_enable_in[index_num]) {
-                                    index_enable_in[index_num] = ibit;
-                                    if (index_enable_in[index_num] == 0) {
-                                        *(data->index_enable[index_num]) = 0;
-                                    }
-                                }
-                                index_num++;
+#ifdef RIO_SOE
+                soe_decode();
 #endif
-                            }
-                        }
-                    }
-                }
 
+                if (aux_split) {
+                    // answer for rio.aux
+                    auxRxSeq++;
+                    __sync_synchronize();
+                    memcpy(&auxRx, &rxData, sizeof(auxRx));
+                    __sync_synchronize();
+                    auxRxSeq++;
+                } else {
+                    rio_read_aux(&rxData, duration);
+                }
+                rio_read_index(&rxData);
 
                 break;
 
@@ -1110,6 +1433,193 @@ void rio_readwrite()
 }
 
 
+void rio_aux()
+{
+    static rxData_t rx;
+    uint32_t seq;
+    int next;
+    long new_stamp;
+    long duration;
+
+    new_stamp = rtapi_get_time();
+    duration = new_stamp - auxStamp;
+    auxStamp = new_stamp;
+
+    // outputs for the next frame
+    next = auxTxReady == 0 ? 1 : 0;
+    rio_write_aux(&auxTx[next]);
+    __sync_synchronize();
+    auxTxReady = next;
+
+    // last answer, copied again if rio.readwrite ran in between
+    if (*(data->SPIstatus)) {
+        do {
+            seq = auxRxSeq;
+            __sync_synchronize();
+            memcpy(&rx, &auxRx, sizeof(rx));
+            __sync_synchronize();
+        } while ((seq & 1) || seq != auxRxSeq);
+        if (seq != 0) {
+            rio_read_aux(&rx, duration);
+        }
+    }
+}
+
+void rio_write_aux(txData_t *tx)
+{
+    int i = 0;
+
+    // Set points (generated per plugin type, see rio_convert.h)
+    rio_convert_vouts(tx);
+
+    // Outputs (the index bits are set by rio_write_index())
+    for (i = 0; i < DIGITAL_OUTPUTS; i++) {
+        if (dout_types[i] != DTYPE_INDEX) {
+            rio_frame_set_output(tx, i, *(data->outputs[i]) == 1);
+        }
+    }
+}
+
+void rio_write_index(txData_t *tx)
+{
+#ifdef INDEX_MAX
+    int i = 0;
+    int index_num = 0;
+
+    for (i = 0; i < DIGITAL_OUTPUTS; i++) {
+        if (dout_types[i] == DTYPE_INDEX) {
+            rio_frame_set_output(tx, i, *(data->index_enable[index_num]) == 1);
+            index_num++;
+        }
+    }
+#endif
+}
+
+void rio_read_aux(const rxData_t *rx, long duration)
+{
+    int i = 0;
+
+    // Feedback (generated per plugin type, see rio_convert.h)
+    rio_convert_vins(rx, duration);
+
+    // Inputs (the index bits are handled by rio_read_index())
+    for (i = 0; i < DIGITAL_INPUTS; i++) {
+        if (din_types[i] != DTYPE_INDEX) {
+            int level = rio_frame_get_input(rx, i);
+            *(data->inputs[i * 2]) = level;			// input
+            *(data->inputs[i * 2 + 1]) = !level;	// not
+        }
+    }
+}
+
+void rio_read_index(const rxData_t *rx)
+{
+#ifdef INDEX_MAX
+    int i = 0;
+    int index_num = 0;
+
+    for (i = 0; i < DIGITAL_INPUTS; i++) {
+        if (din_types[i] == DTYPE_INDEX) {
+            float ibit = rio_frame_get_input(rx, i);
+            if (ibit != index_enable_in[index_num]) {
+                index_enable_in[index_num] = ibit;
+                if (index_enable_in[index_num] == 0) {
+                    *(data->index_enable[index_num]) = 0;
+                }
+            }
+            index_num++;
+        }
+    }
+#endif
+}
+
+
+int rio_identify(void)
+{
+    int n;
+    int found = 0;
+
+    // the answer after a PRU_READ request carries the layout hash in the header:
+    // uart/udp in the first answer, spi (latched at the start of the frame) in the second
+    // the interfaces latch both frames like write frames, they are empty: the joints and outputs stay disabled
+    for (n = 0; n < 2; n++) {
+        txData.header = n == 0 ? PRU_READ : PRU_WRITE;
+        rio_transfer();
+        if ((uint32_t)rxData.header == RIO_LAYOUT_HASH) {
+            found = 1;
+        }
+    }
+    txData.header = PRU_READ;
+    if (!found) {
+        rtapi_print_msg(RTAPI_MSG_ERR,
+                        "%s: ERROR: gateware layout mismatch (expected 0x%08x, got 0x%08x), load the matching bitstream or use layout_check=0\n",
+                        modname, RIO_LAYOUT_HASH, (uint32_t)rxData.header);
+        return -1;
+    }
+    rtapi_print_msg(RTAPI_MSG_INFO, "%s: gateware layout 0x%08x\n", modname, RIO_LAYOUT_HASH);
+    return 0;
+}
+
+#ifdef FPGA_CDONE
+// returns the size of the bitstream or a negative value (-1: file, -4: memory, -5: cdone low, else transport)
+int rio_fpga_load(const char *filename)
+{
+    FILE *fd;
+    long size;
+    uint8_t *data;
+    int ret;
+
+    fd = fopen(filename, "rb");
+    if (fd == NULL) {
+        return -1;
+    }
+    fseek(fd, 0, SEEK_END);
+    size = ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    data = malloc(size > 0 ? size : 1);
+    if (data == NULL) {
+        fclose(fd);
+        return -4;
+    }
+    if (size <= 0 || fread(data, 1, size, fd) != (size_t)size) {
+        free(data);
+        fclose(fd);
+        return -1;
+    }
+    fclose(fd);
+
+#ifdef TRANSPORT_MPSSE
+    ret = mpsse_configure(&mpsse, data, size, FPGA_CDONE);
+#endif
+#ifdef TRANSPORT_SPI
+    // ice40 spi slave configuration (Lattice TN1248), up to 25MHz
+    char dummy[13] = {0};
+    bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_16);
+    bcm2835_gpio_fsel(FPGA_CRESET, BCM2835_GPIO_FSEL_OUTP);
+    bcm2835_gpio_fsel(FPGA_CDONE, BCM2835_GPIO_FSEL_INPT);
+    bcm2835_gpio_fsel(RPI_GPIO_P1_26, BCM2835_GPIO_FSEL_OUTP);
+    // creset low with the chip select low: the fpga starts as spi slave
+    bcm2835_gpio_write(RPI_GPIO_P1_26, LOW);
+    bcm2835_gpio_write(FPGA_CRESET, LOW);
+    bcm2835_delayMicroseconds(100);
+    bcm2835_gpio_write(FPGA_CRESET, HIGH);
+    bcm2835_delayMicroseconds(1200);
+    // 8 dummy clocks with the chip select high, the bitstream with the chip select low
+    bcm2835_gpio_write(RPI_GPIO_P1_26, HIGH);
+    bcm2835_spi_writenb(dummy, 1);
+    bcm2835_gpio_write(RPI_GPIO_P1_26, LOW);
+    bcm2835_spi_writenb((char *)data, size);
+    // at least 49 dummy clocks to start the user mode
+    bcm2835_gpio_write(RPI_GPIO_P1_26, HIGH);
+    bcm2835_spi_writenb(dummy, sizeof(dummy));
+    bcm2835_spi_setClockDivider(SPI_SPEED);
+    ret = bcm2835_gpio_lev(FPGA_CDONE) == HIGH ? 0 : -5;
+#endif
+    free(data);
+    return ret < 0 ? ret : size;
+}
+#endif
+
 void rio_transfer()
 {
 
@@ -1180,6 +1690,32 @@ void rio_transfer()
     bcm2835_gpio_write(RPI_GPIO_P1_26, HIGH);
 #endif
 
+#ifdef TRANSPORT_MPSSE
+    int ret;
+    const uint8_t *next = txData.txBuffer;
+
+    if (mpsse_async && mpsse_pending(&mpsse)) {
+        // answer of the previous frame, this frame is sent in the background
+        ret = mpsse_wait(&mpsse, SPIBUFSIZE);
+        if (ret == SPIBUFSIZE) {
+            memcpy(rxData.rxBuffer, mpsseRx, SPIBUFSIZE);
+        }
+    } else {
+        // first frame (or after an error): this frame synchronously, then a poll frame in the background,
+        // so every frame is sent once and the next one gets the answer of the poll
+        ret = mpsse_transfer(&mpsse, txData.txBuffer, rxData.rxBuffer, SPIBUFSIZE);
+        next = mpssePoll;
+    }
+    if (ret != SPIBUFSIZE) {
+        rxData.header = 0;
+        rtapi_print("MPSSE ERROR: %s\n", ftdi_get_error_string(mpsse.ftdi));
+    } else if (mpsse_async) {
+        if (mpsse_submit(&mpsse, next, mpsseRx, SPIBUFSIZE) < 0) {
+            rtapi_print("MPSSE ERROR: %s\n", ftdi_get_error_string(mpsse.ftdi));
+        }
+    }
+#endif
+
 }
 
 static CONTROL parse_ctrl_type(const char *ctrl)
@@ -0,0 +1,132 @@
+#ifndef RIO_COMP_H
+#define RIO_COMP_H
+
+// leadscrew and backlash compensation per joint (plain C, no HAL, see tests/rio_comp_bench.c)
+//   the table is loaded from a LinuxCNC style comp file at init: "nominal forward reverse" per line
+//   (true positions when moving forward / reverse to the nominal position), the nominal positions
+//   have to be on a uniform grid.
+//   the lookup is O(1) on the grid with a linear interpolation, clamped at the ends, without branches
+//   the backlash is the difference of the forward and reverse errors, blended by the direction (0: forward, 1: reverse)
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    double		start;		// nominal position of the first point
+    double		recip;		// 1 / grid step
+    double		last;		// last index (points - 1)
+    float		*fwd;		// forward error (true - nominal), points + 1 (the last one repeated)
+    float		*rev;		// reverse error
+} comp_table_t;
+
+// no table: the errors are zero
+static float comp_zero[2] = {0.0, 0.0};
+
+static inline void comp_init(comp_table_t *table)
+{
+    table->start = 0.0;
+    table->recip = 0.0;
+    table->last = 0.0;
+    table->fwd = comp_zero;
+    table->rev = comp_zero;
+}
+
+static inline void comp_free(comp_table_t *table)
+{
+    if (table->fwd != comp_zero) {
+        free(table->fwd);
+        free(table->rev);
+    }
+    comp_init(table);
+}
+
+// returns the number of points or a negative value (-1: file, -2: format, -3: grid, -4: memory)
+static int comp_load(comp_table_t *table, const char *filename)
+{
+    FILE *fd;
+    char line[256];
+    double nominal, forward, reverse, step = 0.0, first = 0.0;
+    int points = 0, size = 0;
+    float *fwd = NULL, *rev = NULL;
+
+    comp_init(table);
+    fd = fopen(filename, "r");
+    if (fd == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fd) != NULL) {
+        char *pos = line;
+        while (*pos == ' ' || *pos == '\t') {
+            pos++;
+        }
+        if (*pos == '#' || *pos == ';' || *pos == '\n' || *pos == '\r' || *pos == 0) {
+            continue;
+        }
+        if (sscanf(pos, "%lf %lf %lf", &nominal, &forward, &reverse) != 3) {
+            points = -2;
+            break;
+        }
+        if (points == 0) {
+            first = nominal;
+        } else if (points == 1) {
+            step = nominal - first;
+        }
+        if (points >= 1 && (step <= 0.0 || fabs(nominal - (first + step * points)) > step * 1e-6)) {
+            points = -3;
+            break;
+        }
+        if (points + 2 > size) {
+            float *new_fwd, *new_rev;
+            size = size ? size * 2 : 1024;
+            new_fwd = realloc(fwd, size * sizeof(float));
+            new_rev = realloc(rev, size * sizeof(float));
+            if (new_fwd == NULL || new_rev == NULL) {
+                free(new_fwd ? new_fwd : fwd);
+                free(new_rev ? new_rev : rev);
+                fclose(fd);
+                return -4;
+            }
+            fwd = new_fwd;
+            rev = new_rev;
+        }
+        fwd[points] = forward - nominal;
+        rev[points] = reverse - nominal;
+        points++;
+    }
+    fclose(fd);
+    if (points < 2) {
+        free(fwd);
+        free(rev);
+        return points < 0 ? points : -2;
+    }
+    // the interpolation reads one point behind the last index
+    fwd[points] = fwd[points - 1];
+    rev[points] = rev[points - 1];
+    table->start = first;
+    table->recip = 1.0 / step;
+    table->last = points - 1;
+    table->fwd = fwd;
+    table->rev = rev;
+    return points;
+}
+
+// error (true - nominal) at the nominal position
+static inline double comp_error(const comp_table_t *table, double position, double reverse)
+{
+    double x = fmin(fmax((position - table->start) * table->recip, 0.0), table->last);
+    int32_t index = (int32_t)x;
+    double frac = x - index;
+    double fwd = table->fwd[index] + frac * (table->fwd[index + 1] - table->fwd[index]);
+    double rev = table->rev[index] + frac * (table->rev[index + 1] - table->rev[index]);
+    return fwd + reverse * (rev - fwd);
+}
+
+// direction for the backlash: 0 after a forward move, 1 after a reverse move, unchanged at standstill
+static inline double comp_direction(double reverse, double delta)
+{
+    return delta > 0.0 ? 0.0 : (delta < 0.0 ? 1.0 : reverse);
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef RIO_LOOP_H
+#define RIO_LOOP_H
+
+// position loop of update_freq() (plain C, no HAL), shared with the offline tuner (autotune.py)
+
+// the error inside +-deadband is zero, outside it is reduced by the deadband
+static inline double loop_deadband(double error, double deadband)
+{
+    if (error > deadband) {
+        return error - deadband;
+    } else if (error < -deadband) {
+        return error + deadband;
+    }
+    return 0.0;
+}
+
+// velocity command (position units/s): proportional control with feed forward
+static inline double loop_position(double command, double feedback, double cmd_d, double pgain, double ff1gain, double deadband)
+{
+    return pgain * loop_deadband(command - feedback, deadband) + cmd_d * ff1gain;
+}
+
+// frequency (steps/s) with the frequency limit and the max change per period (acceleration limit)
+static inline double loop_limit(double vel_cmd, double freq, double max_freq, double dv)
+{
+    if (vel_cmd > max_freq) {
+        vel_cmd = max_freq;
+    } else if (vel_cmd < -max_freq) {
+        vel_cmd = -max_freq;
+    }
+    if (vel_cmd > freq + dv) {
+        return freq + dv;
+    } else if (vel_cmd < freq - dv) {
+        return freq - dv;
+    }
+    return vel_cmd;
+}
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef RIO_MPSSE_H
+#define RIO_MPSSE_H
+
+// spi master on the MPSSE engine of an FT2232H/FT232H (libftdi1, plain C, no HAL, see tests/rio_mpsse_test.c)
+//   ADBUS0: SCK, ADBUS1: MOSI, ADBUS2: MISO, chip select and an optional reset line on the other ADBUS pins
+//   one frame is one usb write (cs low, full duplex transfer, cs high, send immediate) and one usb read
+//   mpsse_submit() / mpsse_wait() split the transfer, the usb round trip runs in the background
+//   SPI mode 0 like interface_spislave: MOSI changes on the falling edge, MISO is sampled on the rising edge
+//   mpsse_configure() loads an ice40 bitstream over the same lines (spi slave configuration, CRESET on the reset pin)
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <ftdi.h>
+
+// SET_BITS_LOW + transfer header + SET_BITS_LOW + SEND_IMMEDIATE
+#define MPSSE_FRAME_OVERHEAD	(3 + 3 + 3 + 1)
+#define MPSSE_MAX_FRAME		8192
+
+typedef struct {
+    struct ftdi_context				*ftdi;
+    struct ftdi_transfer_control	*write_tc;
+    struct ftdi_transfer_control	*read_tc;
+    uint8_t		idle;			// ADBUS level: cs high, reset high, sck low
+    uint8_t		select;			// ADBUS level while the frame is transferred
+    uint8_t		dir;			// ADBUS direction: sck, mosi, cs, reset
+    int			reset;			// reset pin (-1: none)
+    uint8_t		cmd[MPSSE_MAX_FRAME + MPSSE_FRAME_OVERHEAD];
+} mpsse_t;
+
+// returns 0 or a negative value (-1: context, -2: open, -3: setup, -4: frame size)
+static int mpsse_open(mpsse_t *m, int vid, int pid, int interface, int divisor, int cs, int reset)
+{
+    uint8_t setup[] = {
+        DIS_DIV_5,
+        DIS_ADAPTIVE,
+        DIS_3_PHASE,
+        LOOPBACK_END,
+        TCK_DIVISOR, divisor & 0xff, (divisor >> 8) & 0xff,		// 60MHz / ((1 + divisor) * 2)
+        SET_BITS_LOW, 0, 0,
+    };
+
+    memset(m, 0, sizeof(mpsse_t));
+    m->reset = reset;
+    m->dir = (1 << 0) | (1 << 1) | (1 << cs);
+    m->idle = (1 << cs);
+    if (reset >= 0) {
+        // the fpga reset (iCEBreaker: CRESET on ADBUS7) is held high
+        m->dir |= (1 << reset);
+        m->idle |= (1 << reset);
+    }
+    m->select = m->idle & ~(1 << cs);
+    setup[8] = m->idle;
+    setup[9] = m->dir;
+
+    m->ftdi = ftdi_new();
+    if (m->ftdi == NULL) {
+        return -1;
+    }
+    if (ftdi_set_interface(m->ftdi, interface) < 0 || ftdi_usb_open(m->ftdi, vid, pid) < 0) {
+        ftdi_free(m->ftdi);
+        m->ftdi = NULL;
+        return -2;
+    }
+    if (ftdi_usb_reset(m->ftdi) < 0
+        || ftdi_set_latency_timer(m->ftdi, 1) < 0
+        || ftdi_set_bitmode(m->ftdi, 0, BITMODE_RESET) < 0
+        || ftdi_set_bitmode(m->ftdi, 0, BITMODE_MPSSE) < 0
+        || ftdi_usb_purge_buffers(m->ftdi) < 0
+        || ftdi_write_data(m->ftdi, setup, sizeof(setup)) != sizeof(setup)) {
+        ftdi_usb_close(m->ftdi);
+        ftdi_free(m->ftdi);
+        m->ftdi = NULL;
+        return -3;
+    }
+    return 0;
+}
+
+static void mpsse_close(mpsse_t *m)
+{
+    if (m->ftdi != NULL) {
+        ftdi_set_bitmode(m->ftdi, 0, BITMODE_RESET);
+        ftdi_usb_close(m->ftdi);
+        ftdi_free(m->ftdi);
+        m->ftdi = NULL;
+    }
+}
+
+// command buffer of one frame, returns the length
+static int mpsse_frame(mpsse_t *m, const uint8_t *tx, int size)
+{
+    uint8_t *cmd = m->cmd;
+    *cmd++ = SET_BITS_LOW;
+    *cmd++ = m->select;
+    *cmd++ = m->dir;
+    *cmd++ = MPSSE_DO_WRITE | MPSSE_DO_READ | MPSSE_WRITE_NEG;
+    *cmd++ = (size - 1) & 0xff;
+    *cmd++ = ((size - 1) >> 8) & 0xff;
+    memcpy(cmd, tx, size);
+    cmd += size;
+    *cmd++ = SET_BITS_LOW;
+    *cmd++ = m->idle;
+    *cmd++ = m->dir;
+    *cmd++ = SEND_IMMEDIATE;
+    return cmd - m->cmd;
+}
+
+// starts the transfer of one frame, the answer is written to rx by mpsse_wait()
+static int mpsse_submit(mpsse_t *m, const uint8_t *tx, uint8_t *rx, int size)
+{
+    int len;
+
+    if (size < 1 || size > MPSSE_MAX_FRAME) {
+        return -4;
+    }
+    len = mpsse_frame(m, tx, size);
+    m->write_tc = ftdi_write_data_submit(m->ftdi, m->cmd, len);
+    if (m->write_tc == NULL) {
+        return -1;
+    }
+    m->read_tc = ftdi_read_data_submit(m->ftdi, rx, size);
+    if (m->read_tc == NULL) {
+        ftdi_transfer_data_done(m->write_tc);
+        m->write_tc = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static inline int mpsse_pending(const mpsse_t *m)
+{
+    return m->read_tc != NULL;
+}
+
+// returns the received bytes or a negative value
+static int mpsse_wait(mpsse_t *m, int size)
+{
+    int written, received;
+
+    if (m->read_tc == NULL) {
+        return -1;
+    }
+    written = ftdi_transfer_data_done(m->write_tc);
+    received = ftdi_transfer_data_done(m->read_tc);
+    m->write_tc = NULL;
+    m->read_tc = NULL;
+    if (written < 0 || received != size) {
+        return -1;
+    }
+    return received;
+}
+
+static int mpsse_transfer(mpsse_t *m, const uint8_t *tx, uint8_t *rx, int size)
+{
+    int ret = mpsse_submit(m, tx, rx, size);
+    if (ret < 0) {
+        return ret;
+    }
+    return mpsse_wait(m, size);
+}
+
+#ifdef FPGA_CDONE
+// bitstream loading (only with a cdone pin)
+static int mpsse_pins(mpsse_t *m, uint8_t level)
+{
+    uint8_t cmd[] = {SET_BITS_LOW, level, m->dir};
+    return ftdi_write_data(m->ftdi, cmd, sizeof(cmd)) == sizeof(cmd) ? 0 : -1;
+}
+
+// write only, size bytes of data (NULL: zeros as dummy clocks)
+static int mpsse_write(mpsse_t *m, const uint8_t *data, int size)
+{
+    uint8_t *cmd = m->cmd;
+    *cmd++ = MPSSE_DO_WRITE | MPSSE_WRITE_NEG;
+    *cmd++ = (size - 1) & 0xff;
+    *cmd++ = ((size - 1) >> 8) & 0xff;
+    if (data != NULL) {
+        memcpy(cmd, data, size);
+    } else {
+        memset(cmd, 0, size);
+    }
+    return ftdi_write_data(m->ftdi, m->cmd, size + 3) == size + 3 ? 0 : -1;
+}
+
+// ice40 spi slave configuration (Lattice TN1248), returns 0 or a negative value (-1: usb, -3: no reset pin, -5: cdone low)
+static int mpsse_configure(mpsse_t *m, const uint8_t *bitstream, long size, int cdone)
+{
+    uint8_t cmd[] = {GET_BITS_LOW, SEND_IMMEDIATE};
+    uint8_t level = 0;
+    struct ftdi_transfer_control *tc;
+    long pos;
+
+    if (m->reset < 0) {
+        return -3;
+    }
+    // creset low with the chip select low: the fpga starts as spi slave
+    if (mpsse_pins(m, m->select & ~(1 << m->reset)) < 0) {
+        return -1;
+    }
+    usleep(100);
+    if (mpsse_pins(m, m->select) < 0) {
+        return -1;
+    }
+    // clearing the configuration memory
+    usleep(1200);
+    // 8 dummy clocks with the chip select high, the bitstream with the chip select low
+    if (mpsse_pins(m, m->idle) < 0 || mpsse_write(m, NULL, 1) < 0 || mpsse_pins(m, m->select) < 0) {
+        return -1;
+    }
+    for (pos = 0; pos < size; pos += MPSSE_MAX_FRAME) {
+        int len = size - pos < MPSSE_MAX_FRAME ? size - pos : MPSSE_MAX_FRAME;
+        if (mpsse_write(m, bitstream + pos, len) < 0) {
+            return -1;
+        }
+    }
+    // at least 49 dummy clocks to start the user mode
+    if (mpsse_pins(m, m->idle) < 0 || mpsse_write(m, NULL, 13) < 0) {
+        return -1;
+    }
+    if (ftdi_write_data(m->ftdi, cmd, sizeof(cmd)) != sizeof(cmd)) {
+        return -1;
+    }
+    tc = ftdi_read_data_submit(m->ftdi, &level, 1);
+    if (tc == NULL || ftdi_transfer_data_done(tc) != 1) {
+        return -1;
+    }
+    return (level & (1 << cdone)) ? 0 : -5;
+}
+#endif
+
+#endif
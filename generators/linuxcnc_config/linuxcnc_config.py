@@ -579,7 +579,7 @@ def generate_rio_ini(project):
             "COMM_TIMEOUT": 1.0,
             "COMM_WAIT": 0.010,
             "BASE_PERIOD": 0,
-            "SERVO_PERIOD": 1000000,
+            "SERVO_PERIOD": project["timing"]["servo_period"],
         },
         "HAL": {
             "HALFILE": "rio.hal",
@@ -731,8 +731,10 @@ def generate_rio_ini(project):
 
         cfgini_data.append(f"[JOINT_{num}]")
         if joint.get("cl", False):
+            if float(joint.get("pid", {}).get("P", 0.0)) > project["timing"]["pid_p_max"]:
+                print(f"WARNING: JOINT_{num}: P is too high for the transport latency ({project['timing']['latency'] * 1000:.2f}ms), max: {project['timing']['pid_p_max']:.1f}")
             for key, default in {
-                "P": "1.0",
+                "P": str(project["timing"]["pid_p"]),
                 "I": "0.0",
                 "D": "0.0",
                 "FF0": "0.0",
@@ -845,20 +847,35 @@ def generate_rio_hal(project):
         else:
             ctrl_types.append("p")  # position mode
 
+    # vins, vouts and digital i/o in a slower thread (timing: aux_period)
+    aux_period = project["timing"]["aux_period"]
+    aux_load = ""
+    aux_split = ""
+    aux_addf = ""
+    if aux_period:
+        aux_load = f"\nloadrt threads name1=aux-thread period1={aux_period}"
+        aux_split = " aux_split=1"
+        aux_addf = "\naddf rio.aux aux-thread"
+
+    # the bitstream of the firmware build is loaded by the component (ice40)
+    bitstream = ""
+    if "fpga_load" in project["jdata"]:
+        bitstream = f" bitstream={os.path.abspath(project['FIRMWARE_PATH'])}/rio.bin"
+
     cfghal_data.append(
         f"""
 # load the realtime components
 loadrt [KINS]KINEMATICS
-loadrt [EMCMOT]EMCMOT base_period_nsec=[EMCMOT]BASE_PERIOD servo_period_nsec=[EMCMOT]SERVO_PERIOD num_joints=[KINS]JOINTS
+loadrt [EMCMOT]EMCMOT base_period_nsec=[EMCMOT]BASE_PERIOD servo_period_nsec=[EMCMOT]SERVO_PERIOD num_joints=[KINS]JOINTS{aux_load}
 
 # set joint modes (p=postion, v=velocity)
-loadrt rio ctrl_type={','.join(ctrl_types)}
+loadrt rio ctrl_type={','.join(ctrl_types)}{aux_split}{bitstream}
 
 # add the rio and motion functions to threads
 addf motion-command-handler servo-thread
 addf motion-controller servo-thread
 addf rio.update-freq servo-thread
-addf rio.readwrite servo-thread
+addf rio.readwrite servo-thread{aux_addf}
 
 # estop loopback, SPI comms enable and feedback
 net user-enable-out 	<= iocontrol.0.user-enable-out		=> rio.SPI-enable
@@ -1,3 +1,7 @@
+import os
+
+import frameio
+
 
 def generate(project):
     print("generating qtgui")
@@ -5,11 +9,12 @@ def generate(project):
     spitest_data = []
     spitest_data.append("")
     spitest_data.append("import time")
-    spitest_data.append("from struct import *")
     spitest_data.append("import sys")
     spitest_data.append("from PyQt5.QtWidgets import QWidget,QPushButton,QApplication,QListWidget,QGridLayout,QLabel,QSlider,QCheckBox")
     spitest_data.append("from PyQt5.QtCore import QTimer,QDateTime, Qt")
     spitest_data.append("")
+    spitest_data.append("import frameio")
+    spitest_data.append("")
     spitest_data.append("SERIAL = ''")
     spitest_data.append("NET_IP = ''")
     spitest_data.append("if len(sys.argv) > 1 and sys.argv[1].startswith('/dev/tty'):")
@@ -34,11 +39,8 @@ def generate(project):
     spitest_data.append("")
     spitest_data.append("INTERVAL = 100")
     spitest_data.append("")
-    spitest_data.append(f"data = [0] * {project['data_size'] // 8}")
-    spitest_data.append("data[0] = 0x74")
-    spitest_data.append("data[1] = 0x69")
-    spitest_data.append("data[2] = 0x72")
-    spitest_data.append("data[3] = 0x77")
+    spitest_data.append(f"LAYOUT = {frameio.layout(project)}")
+    spitest_data.append("FRAME = frameio.Frame(LAYOUT)")
     spitest_data.append("")
     spitest_data.append(f"JOINTS = {project['joints']}")
     spitest_data.append(f"VOUTS = {project['vouts']}")
@@ -71,23 +73,6 @@ def generate(project):
     spitest_data.append("]")
     spitest_data.append("")
 
-    spitest_data.append(f"PRU_OSC = {project['jdata']['clock']['speed']}")
-    spitest_data.append("")
-
-    spitest_data.append("vinminmax = [")
-    for num, vin in enumerate(project["vinnames"]):
-        if vin.get("type") == "frequency":
-            spitest_data.append(f"    ({vin.get('min', -100)}, {vin.get('max', 100)}, 'frequency', 0),")
-        elif vin.get("type") == "pwm":
-            spitest_data.append(f"    ({vin.get('min', -100)}, {vin.get('max', 100)}, 'pwm', 0),")
-        elif vin.get("type") == "sonar":
-            spitest_data.append(f"    ({vin.get('min', 0)}, {vin.get('max', 100000)}, 'sonar', 0),")
-        else:
-            spitest_data.append(f"    ({vin.get('min', -100)}, {vin.get('max', 100)}, '', 0),")
-
-    spitest_data.append("]")
-    spitest_data.append("")
-
     spitest_data.append("vout_types = [")
     for num, vout in enumerate(project["voutnames"]):
         spitest_data.append(f"    '{vout['type']}',")
@@ -99,31 +84,6 @@ def generate(project):
         spitest_data.append(f"    '{vin['type']}',")
     spitest_data.append("]")
     spitest_data.append("")
-
-    spitest_data.append("voutminmax = [")
-    for num, vout in enumerate(project["voutnames"]):
-        if vout.get('type') == "vout_sine":
-            spitest_data.append(f"    ({vout.get('min', -100)}, {vout.get('max', 100)}, 'sine', 30),")
-        elif vout.get('type') == "pwm":
-            freq = vout.get('vout_frequency', 10000)
-            if "dir" in vout:
-                spitest_data.append(f"    (0, {vout.get('max', 100)}, 'pwmdir', {freq}),")
-            else:
-                spitest_data.append(f"    ({vout.get('min', 0)}, {vout.get('max', 100)}, 'pwm', {freq}),")
-        elif vout.get('type') == "vout_rcservo":
-            freq = vout.get('frequency', 100)
-            spitest_data.append(f"    ({vout.get('min', -100)}, {vout.get('max', 100)}, 'rcservo', {freq}),")
-        elif vout.get('type') == "vout_frequency":
-            spitest_data.append(f"    ({vout.get('min', 0)}, {vout.get('max', 100000)}, 'frequency', 0),")
-        elif vout.get('type') == "vout_udpoti":
-            spitest_data.append(f"    ({vout.get('min', 0)}, {vout.get('max', 100)}, 'udpoti', 0),")
-        elif vout.get('type') == "vout_spipoti":
-            spitest_data.append(f"    ({vout.get('min', 0)}, {vout.get('max', 255)}, 'spipoti', 0),")
-        else:
-            spitest_data.append(f"    ({vout.get('min', 0)}, {vout.get('max', 10)}, 'scale', 1),")
-    spitest_data.append("]")
-    spitest_data.append("")
-    spitest_data.append(f"JOINT_ENABLE_BYTES = {project['joints_en_total'] // 8}")
     spitest_data.append(f"DIGITAL_OUTPUT_BYTES = {project['douts_total'] // 8}")
     spitest_data.append(f"DIGITAL_INPUT_BYTES = {project['dins_total'] // 8}")
     spitest_data.append("")
@@ -191,11 +151,12 @@ class WinForm(QWidget):
         for vn in range(VOUTS):
             key = f'vos{vn}'
             self.widgets[key] = QSlider(Qt.Horizontal)
-            if voutminmax[vn][2] == "pwmdir":
-                self.widgets[key].setMinimum(-voutminmax[vn][1])
+            vconv = LAYOUT["vouts"][vn]
+            if vconv["type"] in ("pwmdir", "pwmdir_hires"):
+                self.widgets[key].setMinimum(-int(vconv["max"]))
             else:
-                self.widgets[key].setMinimum(voutminmax[vn][0])
-            self.widgets[key].setMaximum(voutminmax[vn][1])
+                self.widgets[key].setMinimum(int(vconv["min"]))
+            self.widgets[key].setMaximum(int(vconv["max"]))
             self.widgets[key].setValue(0)
             layout.addWidget(self.widgets[key], gpy, vn + 3)
         gpy += 1
@@ -282,13 +243,6 @@ class WinForm(QWidget):
         self.timer.start(INTERVAL)
 
     def runTimer(self):
-
-        #data = [0] * {project['data_size'] // 8}
-        data[0] = 0x74
-        data[1] = 0x69
-        data[2] = 0x72
-        data[3] = 0x77
-
         try:
 
             for jn in range(JOINTS):
@@ -324,68 +278,17 @@ class WinForm(QWidget):
 
             douts = []
             for dbyte in range(DIGITAL_OUTPUT_BYTES):
-                douts.append(0)
                 for dn in range(8):
                     key = f"doc{dbyte}{dn}"
-                    if self.widgets[key].isChecked():
-                        douts[dbyte] |= (1<<(7-dn))
+                    douts.append(self.widgets[key].isChecked())
                     if dbyte * 8 + dn == DOUTS - 1:
                         break
 
-
-            bn = 4
             for jn, value in enumerate(joints):
-                # precalc
-                if value == 0:
-                    value = 0
-                else:
-                    value = int(PRU_OSC / value)
-
                 key = f"jc{jn}"
-                self.widgets[key].setText(str(value))
-
-                joint = list(pack('<i', value))
-                for byte in range(4):
-                    data[bn + byte] = joint[byte]
-                bn += 4
-
-            for vn, value in enumerate(vouts):
-                if voutminmax[vn][2] == 'sine':
-                    if value != 0:
-                        value = int(PRU_OSC / value / voutminmax[vn][3])
-                    else:
-                        value = 0
-                elif voutminmax[vn][2] == 'pwmdir':
-                    value = int((value) * (PRU_OSC / voutminmax[vn][3]) / (voutminmax[vn][1]))
-                elif voutminmax[vn][2] == 'pwm':
-                    value = int((value - voutminmax[vn][0]) * (PRU_OSC / voutminmax[vn][3]) / (voutminmax[vn][1] - voutminmax[vn][0]))
-                elif voutminmax[vn][2] == 'rcservo':
-                    value = int(((value + 300)) * (PRU_OSC / 200000))
-                elif voutminmax[vn][2] == 'udpoti':
-                    value = value
-                elif voutminmax[vn][2] == 'spipoti':
-                    value = value
-                elif voutminmax[vn][2] == 'frequency':
-                    if value != 0:
-                        value = int(PRU_OSC / value)
-                    else:
-                        value = 0
-
-                vout = list(pack('<i', (value)))
-                for byte in range(4):
-                    data[bn + byte] = vout[byte]
-                bn += 4
-
-
-            # jointEnable and dout (TODO: split in bits)
-            for dbyte in range(JOINT_ENABLE_BYTES):
-                data[bn] = 0xFF
-                bn += 1
+                self.widgets[key].setText(str(frameio.joint_to_cmd(LAYOUT["joints"][jn], value, FRAME.osc)))
 
-            # dout
-            for dbyte in range(DIGITAL_OUTPUT_BYTES):
-                data[bn] = douts[dbyte]
-                bn += 1
+            data = list(FRAME.build(joints, vouts, [1] * JOINTS, douts))
 
             print("")
             print("tx:", data)
@@ -407,27 +310,11 @@ class WinForm(QWidget):
             print(f"Duration: {self.time_trx * 1000:02.02f}ms")
             print("rx:", rec)
 
-            jointFeedback = [0] * JOINTS
-            processVariable = [0] * VINS
-
-            pos = 0
-            header = unpack('<i', bytes(rec[pos:pos+4]))[0]
-            pos += 4
-
-            for num in range(JOINTS):
-                jointFeedback[num] = unpack('<i', bytes(rec[pos:pos+4]))[0]
-                pos += 4
+            frame = FRAME.parse(rec)
+            header = frame["header"]
+            jointFeedback = frame["jointFeedback"]
 
-            for num in range(VINS):
-                processVariable[num] = unpack('<i', bytes(rec[pos:pos+4]))[0]
-                pos += 4
-
-            inputs = []
-            for dbyte in range(DIGITAL_INPUT_BYTES):
-                inputs.append(unpack('<B', bytes(rec[pos:pos+1]))[0])
-                pos += 1
-
-            if header == 0x64617461:
+            if header == frameio.PRU_DATA:
                 print(f'PRU_DATA: 0x{header:x}')
                 #for num in range(JOINTS):
                 #    print(f' Joint({num}): {jointFeedback[num]} // 1')
@@ -444,29 +331,15 @@ class WinForm(QWidget):
 
             for vn in range(VINS):
                 key = f"vi{vn}"
-                unit = ""
-                value = processVariable[vn]
-                if vinminmax[vn][2] == 'frequency':
-                    unit = "Hz"
-                    if value != 0:
-                        value = PRU_OSC / value
-                elif vinminmax[vn][2] == 'pwm':
-                    unit = "ms"
-                    if value != 0:
-                        value = 1000 / (PRU_OSC / value)
-                elif vinminmax[vn][2] == 'sonar':
-                    unit = "mm"
-                    if value != 0:
-                        value = 1000 / PRU_OSC / 20 * value * 343.2
+                unit = frameio.vin_unit(LAYOUT["vins"][vn])
+                value = frame["vins"][vn]
                 self.widgets[key].setText(f"{round(value, 2)}{unit}")
 
             for dbyte in range(DIGITAL_INPUT_BYTES):
                 for dn in range(8):
                     key = f"dic{dbyte}{dn}"
 
-                    value = "0"
-                    if inputs[dbyte] & (1<<(7-dn)) != 0:
-                        value = "1"
+                    value = str(frame["dins"][dbyte * 8 + dn])
 
                     self.widgets[key].setText(value)
                     if value == "0":
@@ -493,9 +366,13 @@ if __name__ == '__main__':
     sys.exit(app.exec_())
 
 
+
+
+
     """)
 
     open(f"{project['FIRMWARE_PATH']}/qt_spitest.py", "w").write("\n".join(spitest_data))
+    os.system(f"cp -a frameio.py {project['FIRMWARE_PATH']}/frameio.py")
 
 
 
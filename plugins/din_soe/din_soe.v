@@ -0,0 +1,100 @@
+/* verilator lint_off WIDTHEXPAND */
+/* verilator lint_off WIDTHTRUNC */
+
+// sequence of events: timestamped edges of the inputs in a fifo (BRAM)
+//   every edge is stored with the fpga tick (timestamp) of the edge, the input number and the new level
+//   the answer frame carries SLOTS entries, starting at the sequence number acknowledged by the host (ack),
+//   the host sends the next expected sequence number, so entries of lost frames are sent again
+//   status: {lost edges[15:0], next sequence number[15:0]}
+//   events: per slot {info, tick}, info: {valid, level, 6'd0, input[7:0], sequence[15:0]}
+//   a full fifo holds the edges back (one per input), further edges of this input are lost
+module din_soe
+    #(parameter INPUTS = 8, parameter SLOTS = 4, parameter ABITS = 8)
+     (
+         input clk,
+         input [31:0] timestamp,
+         input [INPUTS-1:0] inputs,
+         input [31:0] ack,
+         output [31:0] status,
+         output reg [SLOTS*64-1:0] events = 0
+     );
+    localparam DEPTH = 1 << ABITS;
+
+    reg [INPUTS-1:0] sync1 = 0;
+    reg [INPUTS-1:0] sync2 = 0;
+    reg [INPUTS-1:0] last = 0;
+    reg [INPUTS-1:0] pending = 0;
+    reg [INPUTS-1:0] level = 0;
+    reg [31:0] stamp [0:INPUTS-1];
+    reg [15:0] wr_seq = 0;
+    reg [15:0] lost = 0;
+    reg [40:0] mem [0:DEPTH-1];
+    assign status = {lost, wr_seq};
+
+    wire [15:0] used = wr_seq - ack[15:0];
+    wire full = (used >= DEPTH);
+
+    // lowest pending input
+    reg [7:0] select;
+    reg selected;
+    integer i;
+    always @(*) begin
+        select = 0;
+        selected = 0;
+        for (i = INPUTS - 1; i >= 0; i = i - 1) begin
+            if (pending[i]) begin
+                select = i;
+                selected = 1;
+            end
+        end
+    end
+
+    // edges, an edge of a pending input is lost (unless the pending one is stored in this clock)
+    wire [INPUTS-1:0] edges = sync2 ^ last;
+    wire [INPUTS-1:0] one = 1;
+    wire [INPUTS-1:0] taken = (selected && !full) ? (one << select) : {INPUTS{1'b0}};
+    wire lost_edge = |(edges & pending & ~taken);
+    integer n;
+    always @(posedge clk) begin
+        sync1 <= inputs;
+        sync2 <= sync1;
+        last <= sync2;
+        for (n = 0; n < INPUTS; n = n + 1) begin
+            if (edges[n] && (!pending[n] || taken[n])) begin
+                pending[n] <= 1;
+                level[n] <= sync2[n];
+                stamp[n] <= timestamp;
+            end else if (taken[n]) begin
+                pending[n] <= 0;
+            end
+        end
+        if (lost_edge && lost != 16'hFFFF) begin
+            lost <= lost + 16'd1;
+        end
+        if (selected && !full) begin
+            mem[wr_seq[ABITS-1:0]] <= {level[select], select, stamp[select]};
+            wr_seq <= wr_seq + 16'd1;
+        end
+    end
+
+    // slots of the answer frame, one per clock: read (BRAM), then store
+    reg [7:0] rd_slot = 0;
+    reg [7:0] out_slot = 0;
+    reg [15:0] out_seq = 0;
+    reg out_valid = 0;
+    reg [40:0] out_data = 0;
+    wire [15:0] rd_seq = ack[15:0] + rd_slot;
+    wire [15:0] rd_used = wr_seq - rd_seq;
+    always @(posedge clk) begin
+        if (rd_slot == SLOTS - 1) begin
+            rd_slot <= 0;
+        end else begin
+            rd_slot <= rd_slot + 8'd1;
+        end
+        out_data <= mem[rd_seq[ABITS-1:0]];
+        out_seq <= rd_seq;
+        out_valid <= (rd_used != 0 && rd_used <= DEPTH);
+        out_slot <= rd_slot;
+        events[out_slot*64 +: 64] <= {out_valid, out_data[40], 6'd0, out_data[39:32], out_seq, out_data[31:0]};
+    end
+endmodule
@@ -0,0 +1,90 @@
+class Plugin:
+    ptype = "din_soe"
+
+    def __init__(self, jdata):
+        self.jdata = jdata
+
+    def setup(self):
+        return [
+            {
+                "basetype": "din",
+                "subtype": self.ptype,
+                "comment": "sequence of events: timestamped edges of digital inputs",
+                "options": {
+                    "inputs": {
+                        "type": "str",
+                        "name": "input names",
+                        "comment": "list of the din names",
+                        "default": "",
+                    },
+                    "slots": {
+                        "type": "int",
+                        "name": "events per frame",
+                        "default": "4",
+                    },
+                    "depth": {
+                        "type": "int",
+                        "name": "fifo depth",
+                        "comment": "power of 2",
+                        "default": "256",
+                    },
+                },
+            }
+        ]
+
+    def config(self):
+        for data in self.jdata["plugins"]:
+            if data.get("type") == self.ptype:
+                return data
+        return None
+
+    def soe(self):
+        # frame setup (projectLoader): events per answer frame and the din names
+        data = self.config()
+        if data is None:
+            return None
+        return {
+            "slots": int(data.get("slots", 4)),
+            "inputs": list(data.get("inputs", [])),
+        }
+
+    def funcs(self):
+        func_out = []
+        data = self.config()
+        if data is None:
+            return func_out
+        dins = {}
+        for din in self.jdata["plugins"]:
+            if din.get("type", "").startswith("din_") and "_prefix" in din:
+                dins[din["_name"]] = din
+        wires = []
+        for name in data.get("inputs", []):
+            if name not in dins:
+                print(f"ERROR: din_soe: unknown input '{name}'")
+                exit(1)
+            if dins[name].get("invert", False):
+                wires.append(f"~{dins[name]['_prefix']}")
+            else:
+                wires.append(dins[name]["_prefix"])
+        depth = int(data.get("depth", 256))
+        abits = max(depth - 1, 1).bit_length()
+        # 16bit sequence numbers, 8bit input numbers
+        if abits > 15 or len(wires) > 256:
+            print("ERROR: din_soe: depth > 32768 or more than 256 inputs")
+            exit(1)
+        slots = int(data.get("slots", 4))
+        # the first input is the lowest bit
+        func_out.append(f"    din_soe #({len(wires)}, {slots}, {abits}) din_soe1 (")
+        func_out.append("        .clk (sysclk),")
+        func_out.append("        .timestamp (timestamp),")
+        func_out.append(f"        .inputs ({{{', '.join(reversed(wires))}}}),")
+        func_out.append("        .ack (soe_ack),")
+        func_out.append("        .status (soe_status),")
+        func_out.append("        .events (soe_events)")
+        func_out.append("    );")
+        return func_out
+
+    def ips(self):
+        if self.config() is not None:
+            return ["din_soe.v"]
+        return []
@@ -0,0 +1,131 @@
+`timescale 1ns/100ps
+
+// self-checking testbench for din_soe
+//   edges on 4 inputs (also in the same clock), read back like the host: ack = next expected sequence number
+//   checks input, level and tick of every edge, then fills the fifo (8 entries) and checks the lost counter
+module testb;
+    reg clk = 0;
+    always #5 clk = !clk;
+
+    parameter INPUTS = 4;
+    parameter SLOTS = 2;
+
+    reg [31:0] timestamp = 0;
+    always @(posedge clk) timestamp <= timestamp + 1;
+
+    reg [INPUTS-1:0] inputs = 0;
+    reg [31:0] ack = 0;
+    wire [31:0] status;
+    wire [SLOTS*64-1:0] events;
+
+    din_soe #(INPUTS, SLOTS, 3) din_soe1 (
+        .clk (clk),
+        .timestamp (timestamp),
+        .inputs (inputs),
+        .ack (ack),
+        .status (status),
+        .events (events)
+    );
+
+    // expected events
+    reg [31:0] exp_tick [0:63];
+    reg [7:0] exp_input [0:63];
+    reg exp_level [0:63];
+    integer expected = 0;
+    integer received = 0;
+    integer errors = 0;
+    integer n;
+
+    task edge_on;
+        input [INPUTS-1:0] mask;
+        begin
+            @(negedge clk);
+            inputs = inputs ^ mask;
+            for (n = 0; n < INPUTS; n = n + 1) begin
+                if (mask[n]) begin
+                    // tick after the synchronizer
+                    exp_tick[expected] = timestamp + 2;
+                    exp_input[expected] = n;
+                    exp_level[expected] = inputs[n];
+                    expected = expected + 1;
+                end
+            end
+        end
+    endtask
+
+    // one host frame: takes the valid entries in order, acknowledges them
+    //   held back edges (full fifo) are stored by input number, so the events are matched by tick/input/level
+    reg [63:0] entry;
+    reg matched [0:63];
+    reg found;
+    integer slot;
+    integer m;
+    task frame;
+        begin
+            repeat (SLOTS + 4) @(posedge clk);
+            @(negedge clk);
+            for (slot = 0; slot < SLOTS; slot = slot + 1) begin
+                entry = events[slot*64 +: 64];
+                if (entry[63] && entry[47:32] == ack[15:0]) begin
+                    found = 0;
+                    for (m = 0; m < expected; m = m + 1) begin
+                        if (!found && !matched[m] && entry[31:0] == exp_tick[m] && entry[55:48] == exp_input[m] && entry[62] == exp_level[m]) begin
+                            matched[m] = 1;
+                            found = 1;
+                        end
+                    end
+                    if (!found) begin
+                        $display("ERROR: unexpected event %0d: tick %0d input %0d level %0d", entry[47:32], entry[31:0], entry[55:48], entry[62]);
+                        errors = errors + 1;
+                    end
+                    received = received + 1;
+                    ack = ack + 1;
+                end
+            end
+        end
+    endtask
+
+    initial begin
+        $dumpfile("testb.vcd");
+        $dumpvars(0, testb);
+        for (n = 0; n < 64; n = n + 1) matched[n] = 0;
+        #100
+
+        edge_on(4'b0001);
+        #50
+        edge_on(4'b0001);
+        edge_on(4'b0110);
+        edge_on(4'b1000);
+        #200
+        for (n = 0; n < 4; n = n + 1) frame;
+        if (received != 5) begin
+            $display("ERROR: %0d events received (expected: 5)", received);
+            errors = errors + 1;
+        end
+
+        // fifo full (8 entries): 3 more are held back (one per input), the rest is lost
+        for (n = 0; n < 12; n = n + 1) begin
+            edge_on(4'b0010 << (n % 3));
+            #20;
+        end
+        #100
+        if (status[31:16] != 1) begin
+            $display("ERROR: lost %0d (expected: 1)", status[31:16]);
+            errors = errors + 1;
+        end
+        // edges after the lost one are not expected any more
+        expected = expected - 1;
+        for (n = 0; n < 10; n = n + 1) frame;
+        if (received != expected) begin
+            $display("ERROR: %0d events received (expected: %0d)", received, expected);
+            errors = errors + 1;
+        end
+
+        if (errors == 0) begin
+            $display("OK");
+        end else begin
+            $display("FAILED: %0d errors", errors);
+        end
+        $finish;
+    end
+endmodule
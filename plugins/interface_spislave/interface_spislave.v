@@ -1,6 +1,6 @@
 
 module interface_spislave
-    #(parameter BUFFER_SIZE=64, parameter MSGID=32'h74697277, parameter TIMEOUT=32'd4800000)
+    #(parameter BUFFER_SIZE=64, parameter MSGID=32'h74697277, parameter TIMEOUT=32'd4800000, parameter READID=32'h64616572)
      (
          input clk,
          input SPI_SCK,
@@ -40,7 +40,7 @@ module interface_spislave
     end
     always @(posedge clk) begin
         if (SSEL_endmessage) begin
-            if (byte_data_receive[BUFFER_SIZE-1:BUFFER_SIZE-32] == MSGID) begin
+            if (byte_data_receive[BUFFER_SIZE-1:BUFFER_SIZE-32] == MSGID || byte_data_receive[BUFFER_SIZE-1:BUFFER_SIZE-32] == READID) begin
                 byte_data_received <= byte_data_receive;
                 timeout_counter <= 0;
             end
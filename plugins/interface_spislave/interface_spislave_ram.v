@@ -0,0 +1,103 @@
+
+// spi slave with the frame in a byte addressed memory (frame_ram.v) instead of shift registers
+//   same ports and behavior as interface_spislave, the frame must be exactly BUFFER_SIZE bits
+//   the next tx byte is fetched in the middle of the current byte
+module interface_spislave_ram
+    #(parameter BUFFER_SIZE=64, parameter MSGID=32'h74697277, parameter TIMEOUT=32'd4800000, parameter READID=32'h64616572)
+     (
+         input clk,
+         input SPI_SCK,
+         input SPI_SSEL,
+         input SPI_MOSI,
+         input [BUFFER_SIZE-1:0] tx_data,
+         output [BUFFER_SIZE-1:0] rx_data,
+         output SPI_MISO,
+         output pkg_timeout
+     );
+    reg [31:0] timeout_counter = 0;
+    reg[2:0] SCKr;  always @(posedge clk) SCKr <= {SCKr[1:0], SPI_SCK};
+    wire SCK_risingedge = (SCKr[2:1]==2'b01);
+    wire SCK_fallingedge = (SCKr[2:1]==2'b10);
+    reg[2:0] SSELr;  always @(posedge clk) SSELr <= {SSELr[1:0], SPI_SSEL};
+    wire SSEL_active = ~SSELr[1];
+    wire SSEL_startmessage = (SSELr[2:1]==2'b10);
+    wire SSEL_endmessage = (SSELr[2:1]==2'b01);
+    reg[15:0] bitcnt = 0;
+    reg timeout = 1;
+    assign pkg_timeout = timeout;
+
+    reg [6:0] rx_shift = 0;
+    reg rx_we = 0;
+    reg [15:0] rx_addr = 0;
+    reg [7:0] rx_byte = 0;
+    reg rx_commit = 0;
+    wire [31:0] rx_header;
+    wire [15:0] tx_addr = SSEL_active ? bitcnt[15:3] + 16'd1 : 16'd0;
+    wire [7:0] tx_byte;
+    reg [7:0] tx_next = 0;
+    reg [7:0] byte_data_sent = 0;
+
+    frame_ram #(BUFFER_SIZE) frame_ram1 (
+        .clk (clk),
+        .rx_we (rx_we),
+        .rx_addr (rx_addr),
+        .rx_byte (rx_byte),
+        .rx_commit (rx_commit),
+        .rx_header (rx_header),
+        .rx_data (rx_data),
+        .tx_hold (SSEL_active),
+        .tx_addr (tx_addr),
+        .tx_byte (tx_byte),
+        .tx_data (tx_data)
+    );
+
+    always @(posedge clk) begin
+        rx_we <= 0;
+        if(~SSEL_active) begin
+            bitcnt <= 16'd0;
+        end else begin
+            if(SCK_risingedge) begin
+                bitcnt <= bitcnt + 16'd1;
+                rx_shift <= {rx_shift[5:0], SPI_MOSI};
+                if (bitcnt[2:0] == 3'd7) begin
+                    rx_we <= 1;
+                    rx_addr <= bitcnt[15:3];
+                    rx_byte <= {rx_shift, SPI_MOSI};
+                end
+                if (bitcnt[2:0] == 3'd3) begin
+                    tx_next <= tx_byte;
+                end
+            end
+        end
+    end
+    always @(posedge clk) begin
+        rx_commit <= 0;
+        if (SSEL_endmessage) begin
+            if (bitcnt == BUFFER_SIZE && (rx_header == MSGID || rx_header == READID)) begin
+                rx_commit <= 1;
+                timeout_counter <= 0;
+            end
+        end else if (timeout_counter < TIMEOUT) begin
+            timeout_counter <= timeout_counter + 1;
+            timeout <= 0;
+        end else begin
+            timeout <= 1;
+        end
+    end
+    always @(posedge clk) begin
+        if(SSEL_active) begin
+            if(SSEL_startmessage) begin
+                byte_data_sent <= tx_byte;
+            end else begin
+                if(SCK_fallingedge) begin
+                    if (bitcnt[2:0] == 3'd0) begin
+                        byte_data_sent <= tx_next;
+                    end else begin
+                        byte_data_sent <= {byte_data_sent[6:0], 1'b0};
+                    end
+                end
+            end
+        end
+    end
+    assign SPI_MISO = byte_data_sent[7];  // send MSB first
+endmodule
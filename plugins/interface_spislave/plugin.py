@@ -62,8 +62,10 @@ class Plugin:
         func_out = []
         for num, interface in enumerate(self.jdata.get("interface", [])):
             if interface["type"] == "spi":
+                # frame in a memory instead of shift registers (big frames)
+                module = "interface_spislave_ram" if self.jdata.get("frame_ram") else "interface_spislave"
                 func_out.append(
-                    f"    interface_spislave #(BUFFER_SIZE, 32'h74697277, 32'd{int(self.jdata['clock']['speed']) // 4}) spi1 ("
+                    f"    {module} #(BUFFER_SIZE, 32'h74697277, 32'd{interface.get('_timeout', int(self.jdata['clock']['speed']) // 4)}) spi1 ("
                 )
                 func_out.append("        .clk (sysclk),")
                 func_out.append("        .SPI_SCK (INTERFACE_SPI_SCK),")
@@ -76,8 +78,18 @@ class Plugin:
                 func_out.append("    );")
         return func_out
 
+    def frame_limit(self):
+        # max. frame size in bytes
+        for num, interface in enumerate(self.jdata.get("interface", [])):
+            if interface["type"] == "spi":
+                # 16bit bit counter
+                return 65535 // 8
+        return None
+
     def ips(self):
         for num, interface in enumerate(self.jdata.get("interface", [])):
             if interface["type"] == "spi":
+                if self.jdata.get("frame_ram"):
+                    return ["interface_spislave_ram.v", "frame_ram.v"]
                 return ["interface_spislave.v"]
         return []
@@ -0,0 +1,98 @@
+`timescale 1 ns/10 ps
+
+// self-checking testbench for interface_spislave_ram (spi mode 0, msb first)
+module testb;
+    reg clk = 0;
+    always #2 clk = !clk;
+
+    parameter BUFFER_SIZE = 96;
+
+    reg SPI_SCK = 0;
+    reg SPI_SSEL = 1;
+    reg SPI_MOSI = 0;
+    wire SPI_MISO;
+    wire pkg_timeout;
+
+    wire [BUFFER_SIZE-1:0] rx_data;
+    reg [BUFFER_SIZE-1:0] tx_data = 96'h64617461_11223344_55667788;
+    reg [BUFFER_SIZE-1:0] answer = 0;
+    integer errors = 0;
+    integer n;
+
+    task transfer;
+        input [BUFFER_SIZE-1:0] frame;
+        input integer bits;
+        begin
+            SPI_SSEL = 0;
+            #100
+            for (n = 0; n < bits; n = n + 1) begin
+                SPI_MOSI = frame[BUFFER_SIZE-1-n];
+                #20 SPI_SCK = 1;
+                answer = {answer[BUFFER_SIZE-2:0], SPI_MISO};
+                #20 SPI_SCK = 0;
+            end
+            #100
+            SPI_SSEL = 1;
+            // copy into rx_data (BUFFER_SIZE/8 + 2 clocks)
+            #200;
+        end
+    endtask
+
+    initial begin
+        $dumpfile("testb.vcd");
+        $dumpvars(0, testb);
+        #100
+
+        transfer(96'h17a17a17_a1177aa1_0000177a, BUFFER_SIZE);
+        if (rx_data != 96'h17a17a17_a1177aa1_0000177a) begin
+            $display("ERROR: rx_data = %h", rx_data);
+            errors = errors + 1;
+        end
+        if (answer != tx_data) begin
+            $display("ERROR: answer = %h (expected: %h)", answer, tx_data);
+            errors = errors + 1;
+        end
+
+        // the answer is a snapshot of tx_data at the start of the frame
+        tx_data = 96'h64617461_deadbeef_01020304;
+        transfer(96'h17a17a17_00000001_00000002, BUFFER_SIZE);
+        if (rx_data != 96'h17a17a17_00000001_00000002) begin
+            $display("ERROR: rx_data = %h", rx_data);
+            errors = errors + 1;
+        end
+        if (answer != tx_data) begin
+            $display("ERROR: answer = %h (expected: %h)", answer, tx_data);
+            errors = errors + 1;
+        end
+
+        // wrong header and short frame are ignored
+        transfer(96'h12345678_00000003_00000004, BUFFER_SIZE);
+        transfer(96'h17a17a17_00000005_00000006, BUFFER_SIZE - 8);
+        if (rx_data != 96'h17a17a17_00000001_00000002) begin
+            $display("ERROR: rx_data = %h (frame not ignored)", rx_data);
+            errors = errors + 1;
+        end
+        if (pkg_timeout) begin
+            $display("ERROR: pkg_timeout");
+            errors = errors + 1;
+        end
+
+        if (errors == 0) begin
+            $display("OK");
+        end else begin
+            $display("FAILED: %0d errors", errors);
+        end
+        $finish;
+    end
+
+    interface_spislave_ram #(BUFFER_SIZE, 32'h17a17a17) interface_spislave1 (
+        .clk (clk),
+        .SPI_SCK (SPI_SCK),
+        .SPI_SSEL (SPI_SSEL),
+        .SPI_MOSI (SPI_MOSI),
+        .SPI_MISO (SPI_MISO),
+        .rx_data (rx_data),
+        .tx_data (tx_data),
+        .pkg_timeout (pkg_timeout)
+    );
+endmodule
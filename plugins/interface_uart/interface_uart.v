@@ -1,6 +1,6 @@
 
 module interface_uart
-    #(parameter BUFFER_SIZE=80, parameter MSGID=32'h74697277, parameter TIMEOUT=32'd4800000, parameter ClkFrequency=12000000, parameter Baud=2000000)
+    #(parameter BUFFER_SIZE=80, parameter MSGID=32'h74697277, parameter TIMEOUT=32'd4800000, parameter ClkFrequency=12000000, parameter Baud=2000000, parameter READID=32'h64616572)
     (
         input clk,
         output reg [BUFFER_SIZE-1:0] rx_data,
@@ -39,8 +39,10 @@ module interface_uart
     );
 
     reg tx_state = 0;
-    reg [7:0] rx_counter = 0;
-    reg [7:0] tx_counter = 0;
+    // frames up to 65535 bytes
+    reg [15:0] rx_counter = 0;
+    reg [15:0] tx_counter = 0;
+    wire [BUFFER_SIZE-1:0] rx_frame = {rx_data_buffer[BUFFER_SIZE-1-8:0], RxD_data};
 
     always @(posedge clk) begin
         if (RxD_endofpacket == 1) begin
@@ -63,12 +65,14 @@ module interface_uart
                 rx_data_buffer <= {rx_data_buffer[BUFFER_SIZE-1-8:0], RxD_data};
                 rx_counter <= rx_counter + 1;
             end else begin
-                // TODO: check MSGID
-                rx_data <= {rx_data_buffer[BUFFER_SIZE-1-8:0], RxD_data};
+                // complete frame (a gap resets the counter), answer only valid frames
                 rx_counter <= 0;
-                tx_counter <= 0;
-                tx_data_buffer <= tx_data;
-                tx_state <= 1;
+                if (rx_frame[BUFFER_SIZE-1:BUFFER_SIZE-32] == MSGID || rx_frame[BUFFER_SIZE-1:BUFFER_SIZE-32] == READID) begin
+                    rx_data <= rx_frame;
+                    tx_counter <= 0;
+                    tx_data_buffer <= tx_data;
+                    tx_state <= 1;
+                end
             end
         end
     end
@@ -0,0 +1,99 @@
+
+// uart interface with the frame in a byte addressed memory (frame_ram.v) instead of shift registers
+//   same ports and behavior as interface_uart
+module interface_uart_ram
+    #(parameter BUFFER_SIZE=80, parameter MSGID=32'h74697277, parameter TIMEOUT=32'd4800000, parameter ClkFrequency=12000000, parameter Baud=2000000, parameter READID=32'h64616572)
+    (
+        input clk,
+        output [BUFFER_SIZE-1:0] rx_data,
+        input [BUFFER_SIZE-1:0] tx_data,
+        output UART_TX,
+        input UART_RX
+    );
+
+    reg TxD_start = 0;
+    wire TxD_busy;
+
+    reg [7:0] TxD_data;
+    wire [7:0] RxD_data;
+    wire RxD_data_ready;
+    wire RxD_idle;
+    wire RxD_endofpacket;
+
+    uart_rx #(ClkFrequency, Baud) uart_rx1 (
+        .clk (clk),
+        .RxD (UART_RX),
+        .RxD_data_ready (RxD_data_ready),
+        .RxD_data (RxD_data),
+        .RxD_idle (RxD_idle),
+        .RxD_endofpacket (RxD_endofpacket)
+    );
+
+    uart_tx #(ClkFrequency, Baud) uart_tx1 (
+        .clk (clk),
+        .TxD_start (TxD_start),
+        .TxD_data (TxD_data),
+        .TxD (UART_TX),
+        .TxD_busy (TxD_busy)
+    );
+
+    reg tx_state = 0;
+    reg [15:0] rx_counter = 0;
+    reg [15:0] tx_counter = 0;
+
+    reg rx_we = 0;
+    reg rx_commit = 0;
+    wire [31:0] rx_header;
+    wire [7:0] tx_byte;
+    // byte 0 is ready when the answer starts
+    wire [15:0] tx_addr = tx_state ? tx_counter : 16'd0;
+
+    frame_ram #(BUFFER_SIZE) frame_ram1 (
+        .clk (clk),
+        .rx_we (rx_we),
+        .rx_addr (rx_counter),
+        .rx_byte (RxD_data),
+        .rx_commit (rx_commit),
+        .rx_header (rx_header),
+        .rx_data (rx_data),
+        .tx_hold (tx_state),
+        .tx_addr (tx_addr),
+        .tx_byte (tx_byte),
+        .tx_data (tx_data)
+    );
+
+    always @(posedge clk) begin
+        rx_we <= 0;
+        rx_commit <= 0;
+        if (rx_we) begin
+            // the byte is written, next address
+            if (rx_counter < BUFFER_SIZE/8-1) begin
+                rx_counter <= rx_counter + 1;
+            end else begin
+                // complete frame (a gap resets the counter), answer only valid frames
+                rx_counter <= 0;
+                if (rx_header == MSGID || rx_header == READID) begin
+                    rx_commit <= 1;
+                    tx_counter <= 0;
+                    tx_state <= 1;
+                end
+            end
+        end else if (RxD_endofpacket == 1) begin
+            rx_counter <= 0;
+        end else if (tx_state == 1) begin
+            if (TxD_busy == 0) begin
+                TxD_data <= tx_byte;
+                TxD_start <= 1;
+            end else if (TxD_start == 1) begin
+                TxD_start <= 0;
+                if (tx_counter < BUFFER_SIZE/8-1) begin
+                    tx_counter <= tx_counter+1;
+                end else begin
+                    tx_state <= 0;
+                end
+            end
+        end else if (RxD_data_ready == 1) begin
+            rx_we <= 1;
+        end
+    end
+endmodule
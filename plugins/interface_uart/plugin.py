@@ -49,8 +49,10 @@ class Plugin:
             if interface["type"] == "uart":
                 baud = interface.get("baud", 1000000)
                 func_out.append("    assign INTERFACE_TIMEOUT = 0;")
+                # frame in a memory instead of shift registers (big frames)
+                module = "interface_uart_ram" if self.jdata.get("frame_ram") else "interface_uart"
                 func_out.append(
-                    f"    interface_uart #(BUFFER_SIZE, 32'h74697277, 32'd{int(self.jdata['clock']['speed']) // 4}, {self.jdata['clock']['speed']}, {baud}) uart1 ("
+                    f"    {module} #(BUFFER_SIZE, 32'h74697277, 32'd{interface.get('_timeout', int(self.jdata['clock']['speed']) // 4)}, {self.jdata['clock']['speed']}, {baud}) uart1 ("
                 )
                 func_out.append("        .clk (sysclk),")
                 func_out.append("        .UART_RX (INTERFACE_UART_RX),")
@@ -61,8 +63,18 @@ class Plugin:
                 func_out.append("    );")
         return func_out
 
+    def frame_limit(self):
+        # max. frame size in bytes
+        for num, interface in enumerate(self.jdata.get("interface", [])):
+            if interface["type"] == "uart":
+                # 16bit byte counters
+                return 65535
+        return None
+
     def ips(self):
         for num, interface in enumerate(self.jdata.get("interface", [])):
             if interface["type"] == "uart":
+                if self.jdata.get("frame_ram"):
+                    return ["uart_baud.v", "uart_rx.v", "uart_tx.v", "interface_uart_ram.v", "frame_ram.v"]
                 return ["uart_baud.v", "uart_rx.v", "uart_tx.v", "interface_uart.v"]
         return []
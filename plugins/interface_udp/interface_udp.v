@@ -0,0 +1,378 @@
+
+// minimal ethernet interface: mac, arp responder and udp responder (100MBit, MII or RGMII)
+//   the phy signals are sampled with the system clock (clk >= 4 * 25MHz)
+//   one udp frame (port PORT) with BUFFER_SIZE / 8 bytes payload is written to rx_data,
+//   the answer (tx_data) is sent back to the ip/port of the request
+module interface_udp
+    #(parameter BUFFER_SIZE=64, parameter MSGID=32'h74697277, parameter TIMEOUT=32'd4800000,
+      parameter ClkFrequency=100000000, parameter [47:0] MAC=48'h0252494F0001, parameter [31:0] IP=32'hC0A80A84,
+      parameter [15:0] PORT=16'd2390, parameter RGMII=0, parameter PHY_ADDR=0, parameter READID=32'h64616572)
+     (
+         input clk,
+         input PHY_RX_CLK,
+         input PHY_RX_DV,
+         input [3:0] PHY_RXD,
+         input PHY_TX_CLK_IN,
+         output PHY_TX_CLK_OUT,
+         output PHY_REF_CLK,
+         output reg PHY_TX_EN = 0,
+         output reg [3:0] PHY_TXD = 0,
+         output PHY_MDC,
+         output PHY_MDIO,
+         output PHY_RESET_N,
+         input [BUFFER_SIZE-1:0] tx_data,
+         output [BUFFER_SIZE-1:0] rx_data,
+         output pkg_timeout
+     );
+    localparam PAYLOAD = BUFFER_SIZE / 8;
+    localparam [15:0] UDP_LEN = PAYLOAD + 8;
+    localparam [15:0] IP_LEN = PAYLOAD + 8 + 20;
+    // frame size without fcs
+    localparam MIN_LEN = 60;
+    localparam HEADER_LEN = 42;
+    // constant part of the ip header checksum
+    localparam [31:0] IP_SUM = 32'h4500 + IP_LEN + 32'h4000 + 32'h4011 + IP[31:16] + IP[15:0];
+    // the rgmii tx clock and the mii reference clock (25MHz) are generated from the system clock
+    localparam TX_CLK_DIV = ClkFrequency / 25000000;
+    localparam RESET_TIME = ClkFrequency / 1000;
+
+    function [31:0] crc32_byte(input [31:0] crc, input [7:0] data);
+        integer i;
+        begin
+            crc32_byte = crc;
+            for (i = 0; i < 8; i = i + 1) begin
+                if (crc32_byte[0] ^ data[i]) begin
+                    crc32_byte = (crc32_byte >> 1) ^ 32'hEDB88320;
+                end else begin
+                    crc32_byte = crc32_byte >> 1;
+                end
+            end
+        end
+    endfunction
+
+    // phy reset and setup (disables 1000MBit on gigabit phys)
+    reg [31:0] reset_counter = 0;
+    assign PHY_RESET_N = (reset_counter == RESET_TIME);
+    always @(posedge clk) begin
+        if (reset_counter < RESET_TIME) begin
+            reset_counter <= reset_counter + 1;
+        end
+    end
+
+    interface_udp_mdio #(ClkFrequency, PHY_ADDR) mdio1 (
+        .clk (clk),
+        .MDC (PHY_MDC),
+        .MDIO (PHY_MDIO)
+    );
+
+    // rx: nibbles
+    reg [2:0] rx_clk_r = 0;
+    reg [3:0] rxd_r1 = 0;
+    reg [3:0] rxd_r2 = 0;
+    reg rx_dv_r1 = 0;
+    reg rx_dv_r2 = 0;
+    always @(posedge clk) begin
+        rx_clk_r <= {rx_clk_r[1:0], PHY_RX_CLK};
+        rxd_r1 <= PHY_RXD;
+        rxd_r2 <= rxd_r1;
+        rx_dv_r1 <= PHY_RX_DV;
+        rx_dv_r2 <= rx_dv_r1;
+    end
+    wire rx_tick = (rx_clk_r[2:1] == 2'b01);
+
+    // rx: preamble and bytes (low nibble first)
+    reg rx_preamble = 0;
+    reg rx_active = 0;
+    reg rx_high = 0;
+    reg [3:0] rx_low = 0;
+    reg [7:0] rx_byte = 0;
+    reg rx_byte_valid = 0;
+    reg rx_start = 0;
+    reg rx_end = 0;
+    always @(posedge clk) begin
+        rx_byte_valid <= 0;
+        rx_start <= 0;
+        rx_end <= 0;
+        if (rx_tick) begin
+            if (!rx_dv_r2) begin
+                rx_end <= rx_active;
+                rx_active <= 0;
+                rx_preamble <= 0;
+            end else if (rx_active) begin
+                if (rx_high) begin
+                    rx_byte <= {rxd_r2, rx_low};
+                    rx_byte_valid <= 1;
+                end else begin
+                    rx_low <= rxd_r2;
+                end
+                rx_high <= ~rx_high;
+            end else if (rxd_r2 == 4'h5) begin
+                rx_preamble <= 1;
+            end else if (rxd_r2 == 4'hD && rx_preamble) begin
+                rx_active <= 1;
+                rx_high <= 0;
+                rx_start <= 1;
+            end else begin
+                rx_preamble <= 0;
+            end
+        end
+    end
+
+    // rx: frame parser
+    localparam [15:0] TYPE_IP = 16'h0800;
+    localparam [15:0] TYPE_ARP = 16'h0806;
+    reg [10:0] rx_count = 0;
+    reg [31:0] rx_crc = 0;
+    reg rx_drop = 0;
+    reg rx_unicast = 0;
+    reg rx_broadcast = 0;
+    reg [15:0] rx_type = 0;
+    reg [47:0] rx_mac = 0;
+    reg [31:0] rx_ip = 0;
+    reg [15:0] rx_port = 0;
+    reg [47:0] rx_cmp_mac = 0;
+    reg [31:0] rx_cmp_ip = 0;
+    reg [31:0] rx_cmp_udp = 0;
+    reg [63:0] rx_cmp_arp = 0;
+    reg [BUFFER_SIZE-1:0] rx_buffer = 0;
+    reg [BUFFER_SIZE-1:0] rx_data_received = 0;
+    reg rx_received = 0;
+    reg tx_request = 0;
+    reg tx_request_arp = 0;
+    wire tx_busy;
+    assign rx_data = rx_data_received;
+
+    always @(posedge clk) begin
+        rx_received <= 0;
+        tx_request <= 0;
+        if (rx_start) begin
+            rx_count <= 0;
+            rx_crc <= 32'hFFFFFFFF;
+            // no new requests while answering
+            rx_drop <= tx_busy;
+            rx_unicast <= 1;
+            rx_broadcast <= 1;
+            rx_cmp_mac <= MAC;
+            rx_cmp_ip <= IP;
+            rx_cmp_udp <= {PORT, UDP_LEN};
+            rx_cmp_arp <= 64'h0001080006040001;
+        end else if (rx_byte_valid) begin
+            rx_crc <= crc32_byte(rx_crc, rx_byte);
+            if (rx_count != 11'h7FF) begin
+                rx_count <= rx_count + 1;
+            end
+            if (rx_count < 6) begin
+                if (rx_byte != 8'hFF) begin
+                    rx_broadcast <= 0;
+                end
+                if (rx_byte != rx_cmp_mac[47:40]) begin
+                    rx_unicast <= 0;
+                end
+                rx_cmp_mac <= {rx_cmp_mac[39:0], 8'd0};
+            end else if (rx_count < 12) begin
+                rx_mac <= {rx_mac[39:0], rx_byte};
+            end else if (rx_count < 14) begin
+                rx_type <= {rx_type[7:0], rx_byte};
+            end else if (rx_type == TYPE_ARP) begin
+                if (rx_count < 22) begin
+                    // htype, ptype, hlen, plen, oper (request)
+                    if (rx_byte != rx_cmp_arp[63:56]) begin
+                        rx_drop <= 1;
+                    end
+                    rx_cmp_arp <= {rx_cmp_arp[55:0], 8'd0};
+                end else if (rx_count >= 28 && rx_count < 32) begin
+                    rx_ip <= {rx_ip[23:0], rx_byte};
+                end else if (rx_count >= 38 && rx_count < 42) begin
+                    if (rx_byte != rx_cmp_ip[31:24]) begin
+                        rx_drop <= 1;
+                    end
+                    rx_cmp_ip <= {rx_cmp_ip[23:0], 8'd0};
+                end
+            end else if (rx_type == TYPE_IP) begin
+                if (rx_count == 14 && rx_byte != 8'h45) begin
+                    // ipv4 without options
+                    rx_drop <= 1;
+                end else if (rx_count == 20 && rx_byte[5:0] != 0) begin
+                    // fragments
+                    rx_drop <= 1;
+                end else if (rx_count == 21 && rx_byte != 0) begin
+                    rx_drop <= 1;
+                end else if (rx_count == 23 && rx_byte != 8'h11) begin
+                    // udp
+                    rx_drop <= 1;
+                end else if (rx_count >= 26 && rx_count < 30) begin
+                    rx_ip <= {rx_ip[23:0], rx_byte};
+                end else if (rx_count >= 30 && rx_count < 34) begin
+                    if (rx_byte != rx_cmp_ip[31:24]) begin
+                        rx_drop <= 1;
+                    end
+                    rx_cmp_ip <= {rx_cmp_ip[23:0], 8'd0};
+                end else if (rx_count >= 34 && rx_count < 36) begin
+                    rx_port <= {rx_port[7:0], rx_byte};
+                end else if (rx_count >= 36 && rx_count < 40) begin
+                    // destination port and length
+                    if (rx_byte != rx_cmp_udp[31:24]) begin
+                        rx_drop <= 1;
+                    end
+                    rx_cmp_udp <= {rx_cmp_udp[23:0], 8'd0};
+                end else if (rx_count >= HEADER_LEN && rx_count < HEADER_LEN + PAYLOAD) begin
+                    rx_buffer <= {rx_buffer[BUFFER_SIZE-9:0], rx_byte};
+                end
+            end else begin
+                rx_drop <= 1;
+            end
+        end else if (rx_end) begin
+            // residue of the crc over data and fcs
+            if (!rx_drop && rx_crc == 32'hDEBB20E3) begin
+                if (rx_type == TYPE_ARP && (rx_unicast || rx_broadcast) && rx_count >= HEADER_LEN + 4) begin
+                    tx_request <= 1;
+                    tx_request_arp <= 1;
+                end else if (rx_type == TYPE_IP && rx_unicast && rx_count >= HEADER_LEN + PAYLOAD + 4) begin
+                    if (rx_buffer[BUFFER_SIZE-1:BUFFER_SIZE-32] == MSGID || rx_buffer[BUFFER_SIZE-1:BUFFER_SIZE-32] == READID) begin
+                        rx_data_received <= rx_buffer;
+                        rx_received <= 1;
+                    end
+                    tx_request <= 1;
+                    tx_request_arp <= 0;
+                end
+            end
+        end
+    end
+
+    reg [31:0] timeout_counter = 0;
+    reg timeout = 1;
+    assign pkg_timeout = timeout;
+    always @(posedge clk) begin
+        if (rx_received) begin
+            timeout_counter <= 0;
+        end else if (timeout_counter < TIMEOUT) begin
+            timeout_counter <= timeout_counter + 1;
+            timeout <= 0;
+        end else begin
+            timeout <= 1;
+        end
+    end
+
+    // tx: clock
+    reg [2:0] tx_clk_r = 0;
+    reg [7:0] tx_div = 0;
+    reg tx_clk_gen = 0;
+    assign PHY_TX_CLK_OUT = tx_clk_gen;
+    assign PHY_REF_CLK = tx_clk_gen;
+    always @(posedge clk) begin
+        tx_clk_r <= {tx_clk_r[1:0], PHY_TX_CLK_IN};
+        if (tx_div == TX_CLK_DIV - 1) begin
+            tx_div <= 0;
+        end else begin
+            tx_div <= tx_div + 1;
+        end
+        tx_clk_gen <= (tx_div < TX_CLK_DIV / 2);
+    end
+    // the phy samples at the rising edge, new data after the (rgmii: falling) edge
+    wire tx_tick = RGMII ? (tx_div == TX_CLK_DIV / 2) : (tx_clk_r[2:1] == 2'b01);
+
+    // tx: frame
+    localparam TX_IDLE = 0;
+    localparam TX_PREAMBLE = 1;
+    localparam TX_HEADER = 2;
+    localparam TX_PAYLOAD = 3;
+    localparam TX_PAD = 4;
+    localparam TX_FCS = 5;
+    localparam TX_GAP = 6;
+    reg [2:0] tx_state = TX_IDLE;
+    reg [10:0] tx_count = 0;
+    reg [10:0] tx_len = 0;
+    reg tx_high = 0;
+    reg tx_arp = 0;
+    reg [31:0] tx_crc = 0;
+    reg [31:0] tx_fcs = 0;
+    reg [HEADER_LEN*8-1:0] tx_header = 0;
+    reg [BUFFER_SIZE-1:0] tx_buffer = 0;
+    assign tx_busy = (tx_state != TX_IDLE);
+
+    wire [31:0] ip_sum1 = IP_SUM + rx_ip[31:16] + rx_ip[15:0];
+    wire [16:0] ip_sum2 = ip_sum1[31:16] + ip_sum1[15:0];
+    wire [15:0] ip_csum = ~(ip_sum2[15:0] + ip_sum2[16]);
+
+    wire [7:0] tx_byte = (tx_state == TX_PREAMBLE) ? ((tx_count == 7) ? 8'hD5 : 8'h55) :
+                         (tx_state == TX_HEADER) ? tx_header[HEADER_LEN*8-1:HEADER_LEN*8-8] :
+                         (tx_state == TX_PAYLOAD) ? tx_buffer[BUFFER_SIZE-1:BUFFER_SIZE-8] :
+                         (tx_state == TX_FCS) ? tx_fcs[7:0] : 8'h00;
+    wire [31:0] tx_crc_next = crc32_byte(tx_crc, tx_byte);
+
+    always @(posedge clk) begin
+        if (tx_state == TX_IDLE) begin
+            if (tx_tick) begin
+                PHY_TX_EN <= 0;
+            end
+            if (tx_request) begin
+                if (tx_request_arp) begin
+                    tx_header <= {rx_mac, MAC, TYPE_ARP, 16'h0001, TYPE_IP, 8'h06, 8'h04, 16'h0002, MAC, IP, rx_mac, rx_ip};
+                end else begin
+                    tx_header <= {rx_mac, MAC, TYPE_IP, 8'h45, 8'h00, IP_LEN, 16'h0000, 16'h4000, 8'h40, 8'h11, ip_csum, IP, rx_ip, PORT, rx_port, UDP_LEN, 16'h0000};
+                end
+                tx_arp <= tx_request_arp;
+                tx_buffer <= tx_data;
+                tx_crc <= 32'hFFFFFFFF;
+                tx_count <= 0;
+                tx_len <= 0;
+                tx_high <= 0;
+                tx_state <= TX_PREAMBLE;
+            end
+        end else if (tx_tick) begin
+            PHY_TX_EN <= (tx_state != TX_GAP);
+            PHY_TXD <= tx_high ? tx_byte[7:4] : tx_byte[3:0];
+            tx_high <= ~tx_high;
+            if (tx_high) begin
+                // next byte
+                tx_count <= tx_count + 1;
+                if (tx_state == TX_HEADER || tx_state == TX_PAYLOAD || tx_state == TX_PAD) begin
+                    tx_crc <= tx_crc_next;
+                    tx_fcs <= ~tx_crc_next;
+                    tx_len <= tx_len + 1;
+                end
+                case (tx_state)
+                    TX_PREAMBLE: begin
+                        if (tx_count == 7) begin
+                            tx_count <= 0;
+                            tx_state <= TX_HEADER;
+                        end
+                    end
+                    TX_HEADER: begin
+                        tx_header <= {tx_header[HEADER_LEN*8-9:0], 8'd0};
+                        if (tx_count == HEADER_LEN - 1) begin
+                            tx_count <= 0;
+                            tx_state <= tx_arp ? TX_PAD : TX_PAYLOAD;
+                        end
+                    end
+                    TX_PAYLOAD: begin
+                        tx_buffer <= {tx_buffer[BUFFER_SIZE-9:0], 8'd0};
+                        if (tx_count == PAYLOAD - 1) begin
+                            tx_count <= 0;
+                            tx_state <= (tx_len + 1 < MIN_LEN) ? TX_PAD : TX_FCS;
+                        end
+                    end
+                    TX_PAD: begin
+                        if (tx_len + 1 == MIN_LEN) begin
+                            tx_count <= 0;
+                            tx_state <= TX_FCS;
+                        end
+                    end
+                    TX_FCS: begin
+                        tx_fcs <= {8'd0, tx_fcs[31:8]};
+                        if (tx_count == 3) begin
+                            tx_count <= 0;
+                            tx_state <= TX_GAP;
+                        end
+                    end
+                    default: begin
+                        // inter frame gap (12 bytes)
+                        if (tx_count == 11) begin
+                            tx_state <= TX_IDLE;
+                        end
+                    end
+                endcase
+            end
+        end
+    end
+endmodule
@@ -0,0 +1,62 @@
+
+// writes the phy setup after power up (MDC: 1MHz)
+//   reg 9 (1000BASE-T control): 0x0000 -> no 1000MBit advertisement
+//   reg 0 (control): 0x1200 -> restart autonegotiation
+module interface_udp_mdio
+    #(parameter ClkFrequency=100000000, parameter PHY_ADDR=0)
+     (
+         input clk,
+         output reg MDC = 0,
+         output MDIO,
+         output reg done = 0
+     );
+    localparam HALF = ClkFrequency / 2000000;
+    localparam DELAY = ClkFrequency / 100;
+    wire [4:0] addr = PHY_ADDR;
+
+    reg [31:0] delay = 0;
+    reg [15:0] div = 0;
+    reg [5:0] bitcnt = 0;
+    reg frame = 0;
+    reg busy = 0;
+    reg [63:0] shift = 64'hFFFFFFFFFFFFFFFF;
+    assign MDIO = shift[63];
+
+    always @(posedge clk) begin
+        if (done) begin
+            MDC <= 0;
+        end else if (!busy) begin
+            if (delay < DELAY) begin
+                delay <= delay + 1;
+            end else begin
+                // preamble, start, write, phy address, register, turnaround, data
+                if (frame) begin
+                    shift <= {32'hFFFFFFFF, 4'b0101, addr, 5'd0, 2'b10, 16'h1200};
+                end else begin
+                    shift <= {32'hFFFFFFFF, 4'b0101, addr, 5'd9, 2'b10, 16'h0000};
+                end
+                busy <= 1;
+                bitcnt <= 0;
+                div <= 0;
+                MDC <= 0;
+            end
+        end else if (div < HALF - 1) begin
+            div <= div + 1;
+        end else begin
+            div <= 0;
+            MDC <= ~MDC;
+            if (MDC) begin
+                // the phy samples at the rising edge, next bit after the falling edge
+                shift <= {shift[62:0], 1'b1};
+                if (bitcnt == 63) begin
+                    busy <= 0;
+                    delay <= 0;
+                    frame <= 1;
+                    done <= frame;
+                end else begin
+                    bitcnt <= bitcnt + 1;
+                end
+            end
+        end
+    end
+endmodule
@@ -0,0 +1,142 @@
+class Plugin:
+    def __init__(self, jdata):
+        self.jdata = jdata
+
+    def setup(self):
+        return [
+            {
+                "basetype": "interface",
+                "subtype": "udp",
+                "comment": "ethernet interface (udp) for the communication with LinuxCNC, 100MBit MII/RGMII phy",
+                "options": {
+                    "mode": {
+                        "type": "str",
+                        "name": "phy interface",
+                        "comment": "mii or rgmii (100MBit)",
+                        "default": "mii",
+                    },
+                    "mac": {
+                        "type": "str",
+                        "name": "mac address",
+                        "default": "02:52:49:4F:00:01",
+                    },
+                    "port": {
+                        "type": "int",
+                        "name": "udp port",
+                        "default": 2390,
+                    },
+                    "phy_addr": {
+                        "type": "int",
+                        "name": "phy address (mdio)",
+                        "default": 0,
+                    },
+                    "pins": {
+                        "type": "dict",
+                        "name": "pin config",
+                        "options": {
+                            "RX_CLK": {"type": "input", "name": "rx clock pin"},
+                            "RX_DV": {"type": "input", "name": "rx data valid pin (rgmii: RX_CTL)"},
+                            "RXD0": {"type": "input", "name": "rx data 0 pin"},
+                            "RXD1": {"type": "input", "name": "rx data 1 pin"},
+                            "RXD2": {"type": "input", "name": "rx data 2 pin"},
+                            "RXD3": {"type": "input", "name": "rx data 3 pin"},
+                            "TX_CLK": {"type": "input", "name": "tx clock pin (rgmii: output)"},
+                            "TX_EN": {"type": "output", "name": "tx enable pin (rgmii: TX_CTL)"},
+                            "TXD0": {"type": "output", "name": "tx data 0 pin"},
+                            "TXD1": {"type": "output", "name": "tx data 1 pin"},
+                            "TXD2": {"type": "output", "name": "tx data 2 pin"},
+                            "TXD3": {"type": "output", "name": "tx data 3 pin"},
+                            "MDC": {"type": "output", "name": "mdio clock pin (optional)"},
+                            "MDIO": {"type": "output", "name": "mdio data pin (optional)"},
+                            "RESET": {"type": "output", "name": "phy reset pin (optional)"},
+                            "REF_CLK": {"type": "output", "name": "25MHz phy reference clock pin (optional)"},
+                        },
+                    },
+                },
+            }
+        ]
+
+    def pinlist(self):
+        pinlist_out = []
+        for num, interface in enumerate(self.jdata.get("interface", [])):
+            if interface["type"] == "udp":
+                pins = interface["pins"]
+                rgmii = interface.get("mode", "mii") == "rgmii"
+                pinlist_out.append(("INTERFACE_UDP_RX_CLK", pins["RX_CLK"], "INPUT"))
+                pinlist_out.append(("INTERFACE_UDP_RX_DV", pins["RX_DV"], "INPUT"))
+                for bit in range(4):
+                    pinlist_out.append((f"INTERFACE_UDP_RXD{bit}", pins[f"RXD{bit}"], "INPUT"))
+                pinlist_out.append(("INTERFACE_UDP_TX_CLK", pins["TX_CLK"], "OUTPUT" if rgmii else "INPUT"))
+                pinlist_out.append(("INTERFACE_UDP_TX_EN", pins["TX_EN"], "OUTPUT"))
+                for bit in range(4):
+                    pinlist_out.append((f"INTERFACE_UDP_TXD{bit}", pins[f"TXD{bit}"], "OUTPUT"))
+                for name in ("MDC", "MDIO", "RESET", "REF_CLK"):
+                    if name in pins:
+                        pinlist_out.append((f"INTERFACE_UDP_{name}", pins[name], "OUTPUT"))
+        return pinlist_out
+
+    def errors(self):
+        errors = []
+        for num, interface in enumerate(self.jdata.get("interface", [])):
+            if interface["type"] == "udp":
+                clock = int(self.jdata["clock"]["speed"])
+                rgmii = interface.get("mode", "mii") == "rgmii"
+                if clock < 100000000 or ((rgmii or "REF_CLK" in interface["pins"]) and clock % 50000000 != 0):
+                    errors.append(f"interface_udp needs a system clock of at least 100MHz (rgmii/REF_CLK: multiple of 50MHz): {clock}")
+                if not 0 < int(interface.get("port", 2390)) < 65536:
+                    errors.append(f"interface_udp: invalid udp port: {interface['port']}")
+        return errors
+
+    def funcs(self):
+        func_out = []
+        for num, interface in enumerate(self.jdata.get("interface", [])):
+            if interface["type"] == "udp":
+                pins = interface["pins"]
+                clock = int(self.jdata["clock"]["speed"])
+                rgmii = interface.get("mode", "mii") == "rgmii"
+                mac = interface.get("mac", "02:52:49:4F:00:01").replace(":", "").replace("-", "")
+                ip = "".join(f"{int(part):02X}" for part in self.jdata.get("ip", "192.168.10.132").split("."))
+                port = int(interface.get("port", 2390))
+                func_out.append(
+                    f"    interface_udp #(BUFFER_SIZE, 32'h74697277, 32'd{interface.get('_timeout', clock // 4)}, {clock}, 48'h{mac}, 32'h{ip}, 16'd{port}, {int(rgmii)}, {int(interface.get('phy_addr', 0))}) udp1 ("
+                )
+                func_out.append("        .clk (sysclk),")
+                func_out.append("        .PHY_RX_CLK (INTERFACE_UDP_RX_CLK),")
+                func_out.append("        .PHY_RX_DV (INTERFACE_UDP_RX_DV),")
+                func_out.append("        .PHY_RXD ({INTERFACE_UDP_RXD3, INTERFACE_UDP_RXD2, INTERFACE_UDP_RXD1, INTERFACE_UDP_RXD0}),")
+                if rgmii:
+                    func_out.append("        .PHY_TX_CLK_IN (1'b0),")
+                    func_out.append("        .PHY_TX_CLK_OUT (INTERFACE_UDP_TX_CLK),")
+                else:
+                    func_out.append("        .PHY_TX_CLK_IN (INTERFACE_UDP_TX_CLK),")
+                    func_out.append("        .PHY_TX_CLK_OUT (),")
+                func_out.append("        .PHY_TX_EN (INTERFACE_UDP_TX_EN),")
+                func_out.append("        .PHY_TXD ({INTERFACE_UDP_TXD3, INTERFACE_UDP_TXD2, INTERFACE_UDP_TXD1, INTERFACE_UDP_TXD0}),")
+                for name in ("MDC", "MDIO", "REF_CLK"):
+                    if name in pins:
+                        func_out.append(f"        .PHY_{name} (INTERFACE_UDP_{name}),")
+                    else:
+                        func_out.append(f"        .PHY_{name} (),")
+                if "RESET" in pins:
+                    func_out.append("        .PHY_RESET_N (INTERFACE_UDP_RESET),")
+                else:
+                    func_out.append("        .PHY_RESET_N (),")
+                func_out.append("        .rx_data (rx_data),")
+                func_out.append("        .tx_data (tx_data),")
+                func_out.append("        .pkg_timeout (INTERFACE_TIMEOUT)")
+                func_out.append("    );")
+        return func_out
+
+    def frame_limit(self):
+        # max. frame size in bytes
+        for num, interface in enumerate(self.jdata.get("interface", [])):
+            if interface["type"] == "udp":
+                # one ethernet frame, no ip fragmentation
+                return 1500 - 20 - 8
+        return None
+
+    def ips(self):
+        for num, interface in enumerate(self.jdata.get("interface", [])):
+            if interface["type"] == "udp":
+                return ["interface_udp.v", "interface_udp_mdio.v"]
+        return []
@@ -0,0 +1,116 @@
+`timescale 1ns/100ps
+
+module testb;
+    // system clock 100MHz
+    reg clk = 0;
+    always #5 clk = !clk;
+
+    // phy clocks 25MHz
+    reg rx_clk = 0;
+    always #20 rx_clk = !rx_clk;
+    reg tx_clk = 0;
+    initial begin
+        # 7
+        forever #20 tx_clk = !tx_clk;
+    end
+
+    reg rx_dv = 0;
+    reg [3:0] rxd = 0;
+    wire tx_en;
+    wire [3:0] txd;
+
+    wire [63:0] rx_data;
+    reg [63:0] tx_data = 64'h6174616401020304;
+    wire pkg_timeout;
+
+    // recorded frames (testb_frames.py)
+    reg [8:0] frames [0:4095];
+    integer pos = 0;
+    integer gap = 0;
+    reg high = 0;
+    reg done = 0;
+
+    initial begin
+        $readmemh("testb_frames.hex", frames);
+        $dumpfile("testb.vcd");
+        $dumpvars(0, testb);
+    end
+
+    // the phy sends the nibbles after the rising edge
+    always @(posedge rx_clk) begin
+        #12
+        if (done) begin
+            rx_dv <= 0;
+        end else if (gap > 0) begin
+            gap <= gap - 1;
+            if (gap == 1 && frames[pos] == 9'h0FF) begin
+                done <= 1;
+            end
+        end else if (frames[pos][8]) begin
+            rx_dv <= 1;
+            rxd <= high ? frames[pos][7:4] : frames[pos][3:0];
+            high <= ~high;
+            if (high) begin
+                pos <= pos + 1;
+            end
+        end else begin
+            // time for the answer
+            rx_dv <= 0;
+            gap <= 500;
+            pos <= pos + 1;
+        end
+    end
+
+    // received answers (testb_out.hex)
+    integer outfile;
+    integer tx_bytes = 0;
+    reg tx_high = 0;
+    reg [3:0] tx_low = 0;
+    initial outfile = $fopen("testb_out.hex", "w");
+
+    always @(posedge tx_clk) begin
+        if (tx_en) begin
+            if (tx_high) begin
+                if (tx_bytes > 0) begin
+                    $fwrite(outfile, " ");
+                end
+                $fwrite(outfile, "%02x", {txd, tx_low});
+                tx_bytes <= tx_bytes + 1;
+            end else begin
+                tx_low <= txd;
+            end
+            tx_high <= ~tx_high;
+        end else if (tx_bytes > 0) begin
+            $fwrite(outfile, "\n");
+            tx_bytes <= 0;
+            tx_high <= 0;
+        end
+    end
+
+    initial begin
+        wait (done);
+        # 1000
+        $display("rx_data: %h (expected: 7469727755667788)", rx_data);
+        $fclose(outfile);
+        $finish;
+    end
+
+    interface_udp #(64, 32'h74697277, 32'd4800000, 100000000, 48'h0252494F0001, 32'hC0A80A84, 16'd2390, 0, 0) udp1 (
+        .clk (clk),
+        .PHY_RX_CLK (rx_clk),
+        .PHY_RX_DV (rx_dv),
+        .PHY_RXD (rxd),
+        .PHY_TX_CLK_IN (tx_clk),
+        .PHY_TX_CLK_OUT (),
+        .PHY_REF_CLK (),
+        .PHY_TX_EN (tx_en),
+        .PHY_TXD (txd),
+        .PHY_MDC (),
+        .PHY_MDIO (),
+        .PHY_RESET_N (),
+        .rx_data (rx_data),
+        .tx_data (tx_data),
+        .pkg_timeout (pkg_timeout)
+    );
+
+endmodule
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+#
+# writes the ethernet frames for the testbench (testb_frames.hex)
+# and the expected answers of the fpga (testb_expected.hex)
+#
+# testb_frames.hex: one 9bit word per line, 1XX: byte, 000: end of frame, 0FF: end of file
+#
+
+import struct
+import zlib
+
+MAC = bytes.fromhex("0252494F0001")
+IP = bytes([192, 168, 10, 132])
+PORT = 2390
+HOST_MAC = bytes.fromhex("D8BBC1000002")
+HOST_IP = bytes([192, 168, 10, 1])
+HOST_PORT = 2391
+
+# BUFFER_SIZE=64 in testb.v
+RX_PAYLOAD = bytes.fromhex("7469727711223344")
+RX_PAYLOAD2 = bytes.fromhex("7469727755667788")
+RX_DROPPED = bytes.fromhex("74697277DEADBEEF")
+TX_PAYLOAD = bytes.fromhex("6174616401020304")
+
+
+def ethernet(dst, src, etype, payload, fcs=True):
+    frame = dst + src + struct.pack(">H", etype) + payload
+    frame += bytes(max(0, 60 - len(frame)))
+    crc = zlib.crc32(frame)
+    if not fcs:
+        crc ^= 1
+    return bytes([0x55] * 7 + [0xD5]) + frame + struct.pack("<I", crc)
+
+
+def arp(oper, sha, spa, tha, tpa):
+    return struct.pack(">HHBBH", 1, 0x0800, 6, 4, oper) + sha + spa + tha + tpa
+
+
+def checksum(data):
+    value = sum(struct.unpack(f">{len(data) // 2}H", data))
+    while value > 0xFFFF:
+        value = (value & 0xFFFF) + (value >> 16)
+    return ~value & 0xFFFF
+
+
+def udp(src_ip, dst_ip, src_port, dst_port, payload, flags=0x4000):
+    header = struct.pack(">BBHHHBBH", 0x45, 0, 28 + len(payload), 0, flags, 64, 17, 0) + src_ip + dst_ip
+    header = header[:10] + struct.pack(">H", checksum(header)) + header[12:]
+    return header + struct.pack(">HHHH", src_port, dst_port, 8 + len(payload), 0) + payload
+
+
+def frames():
+    requests = []
+    answers = []
+
+    # arp request -> arp reply
+    requests.append(ethernet(b"\xff" * 6, HOST_MAC, 0x0806, arp(1, HOST_MAC, HOST_IP, bytes(6), IP)))
+    answers.append(ethernet(HOST_MAC, MAC, 0x0806, arp(2, MAC, IP, HOST_MAC, HOST_IP)))
+
+    # arp request for an other ip
+    requests.append(ethernet(b"\xff" * 6, HOST_MAC, 0x0806, arp(1, HOST_MAC, HOST_IP, bytes(6), bytes([192, 168, 10, 2]))))
+
+    # udp frame -> answer with tx_data
+    requests.append(ethernet(MAC, HOST_MAC, 0x0800, udp(HOST_IP, IP, HOST_PORT, PORT, RX_PAYLOAD, flags=0)))
+    answers.append(ethernet(HOST_MAC, MAC, 0x0800, udp(IP, HOST_IP, PORT, HOST_PORT, TX_PAYLOAD)))
+
+    # wrong port, wrong crc, other mac
+    requests.append(ethernet(MAC, HOST_MAC, 0x0800, udp(HOST_IP, IP, HOST_PORT, PORT + 1, RX_DROPPED)))
+    requests.append(ethernet(MAC, HOST_MAC, 0x0800, udp(HOST_IP, IP, HOST_PORT, PORT, RX_DROPPED), fcs=False))
+    requests.append(ethernet(HOST_MAC, HOST_MAC, 0x0800, udp(HOST_IP, IP, HOST_PORT, PORT, RX_DROPPED)))
+
+    # second udp frame
+    requests.append(ethernet(MAC, HOST_MAC, 0x0800, udp(HOST_IP, IP, HOST_PORT, PORT, RX_PAYLOAD2)))
+    answers.append(ethernet(HOST_MAC, MAC, 0x0800, udp(IP, HOST_IP, PORT, HOST_PORT, TX_PAYLOAD)))
+    return requests, answers
+
+
+def main():
+    requests, answers = frames()
+    with open("testb_frames.hex", "w") as ofile:
+        for frame in requests:
+            for byte in frame:
+                ofile.write(f"{0x100 | byte:03x}\n")
+            ofile.write("000\n")
+        ofile.write("0ff\n")
+    with open("testb_expected.hex", "w") as ofile:
+        for frame in answers:
+            ofile.write(" ".join(f"{byte:02x}" for byte in frame) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,173 @@
+/* verilator lint_off WIDTHEXPAND */
+/* verilator lint_off WIDTHTRUNC */
+
+// closed loop position control of a dc motor (pwm/dir + quadrature encoder)
+//   the host sends the position (counts) and the velocity (counts/s) once per servo period,
+//   between the frames the target moves with the velocity (one step per loop cycle)
+//   loop: every LOOP_DIV clocks, fixed point pid + velocity feed forward
+//     out = (KP * e + KI * sum(e) + KD * (e - e_last) + KFF * counts per loop) >> SHIFT
+//     limited to +-PWM_PERIOD, no integration while the output is limited
+//   VEL_SCALE: LOOP_DIV * 2^32 / clk (counts/s -> counts per loop in Q16.16)
+module joint_dcservo
+    #(
+      parameter PWM_PERIOD = 270,
+      parameter LOOP_DIV = 1350,
+      parameter VEL_SCALE = 214748,
+      parameter KP = 4096,
+      parameter KI = 8,
+      parameter KD = 32768,
+      parameter KFF = 0,
+      parameter SHIFT = 8,
+      parameter ILIMIT = 1048576
+     )
+     (
+         input clk,
+         input jointEnable,
+         input signed [31:0] jointPosCmd,
+         input signed [31:0] jointVelCmd,
+         output signed [31:0] jointFeedback,
+         input quadA,
+         input quadB,
+         output DIR,
+         output PWM
+     );
+
+    // counter widths from the parameters (no wrap around for long loop or pwm periods)
+    localparam LOOP_BITS = $clog2(LOOP_DIV + 1);
+    localparam PWM_BITS = $clog2(PWM_PERIOD + 1);
+
+    // encoder (same decoder as vin_quadencoder)
+    reg [2:0] quadA_delayed = 0;
+    reg [2:0] quadB_delayed = 0;
+    always @(posedge clk) quadA_delayed <= {quadA_delayed[1:0], quadA};
+    always @(posedge clk) quadB_delayed <= {quadB_delayed[1:0], quadB};
+    wire count_enable = quadA_delayed[1] ^ quadA_delayed[2] ^ quadB_delayed[1] ^ quadB_delayed[2];
+    wire count_direction = quadA_delayed[1] ^ quadB_delayed[2];
+    reg signed [31:0] count = 0;
+    assign jointFeedback = count;
+    always @(posedge clk) begin
+        if (count_enable) begin
+            if(count_direction) begin
+                count <= count + 1;
+            end else begin
+                count <= count - 1;
+            end
+        end
+    end
+
+    // controller
+    reg signed [31:0] pos_last = 0;
+    reg signed [31:0] vel_last = 0;
+    reg new_cmd = 1;
+    reg [LOOP_BITS-1:0] loop_cnt = 0;
+    reg [2:0] phase = 0;
+    reg signed [47:0] target = 0;
+    reg signed [47:0] vel_step = 0;
+    wire signed [63:0] vel_product = vel_last * VEL_SCALE;
+    wire signed [47:0] diff = (target >>> 16) - count;
+    reg signed [23:0] err = 0;
+    reg signed [23:0] err_last = 0;
+    reg signed [31:0] isum = 0;
+    reg signed [47:0] p_term = 0;
+    reg signed [47:0] i_term = 0;
+    reg signed [47:0] d_term = 0;
+    reg signed [47:0] ff_term = 0;
+    wire signed [47:0] sum = (p_term + i_term + d_term + ff_term) >>> SHIFT;
+    reg signed [31:0] out = 0;
+    wire limited = (out == PWM_PERIOD || out == -PWM_PERIOD);
+
+    always @(posedge clk) begin
+        if (loop_cnt == LOOP_DIV - 1) begin
+            loop_cnt <= 0;
+            phase <= 1;
+        end else begin
+            loop_cnt <= loop_cnt + 1'd1;
+        end
+
+        case (phase)
+            1: begin
+                // target: the last host command, moved with the velocity
+                if (new_cmd) begin
+                    new_cmd <= 0;
+                    target <= {pos_last, 16'd0};
+                end else begin
+                    target <= target + vel_step;
+                end
+                vel_step <= vel_product >>> 16;
+                phase <= 2;
+            end
+            2: begin
+                if (diff > 48'sd8388607) begin
+                    err <= 24'sd8388607;
+                end else if (diff < -48'sd8388608) begin
+                    err <= -24'sd8388608;
+                end else begin
+                    err <= diff;
+                end
+                phase <= 3;
+            end
+            3: begin
+                p_term <= KP * err;
+                d_term <= KD * (err - err_last);
+                ff_term <= (KFF * vel_step) >>> 16;
+                err_last <= err;
+                if (!limited) begin
+                    if (isum + err > ILIMIT) begin
+                        isum <= ILIMIT;
+                    end else if (isum + err < -ILIMIT) begin
+                        isum <= -ILIMIT;
+                    end else begin
+                        isum <= isum + err;
+                    end
+                end
+                phase <= 4;
+            end
+            4: begin
+                i_term <= KI * isum;
+                phase <= 5;
+            end
+            5: begin
+                if (sum > PWM_PERIOD) begin
+                    out <= PWM_PERIOD;
+                end else if (sum < -PWM_PERIOD) begin
+                    out <= -PWM_PERIOD;
+                end else begin
+                    out <= sum;
+                end
+                phase <= 0;
+            end
+            default: begin
+            end
+        endcase
+
+        if (!jointEnable) begin
+            isum <= 0;
+            out <= 0;
+            err_last <= 0;
+            new_cmd <= 1;
+        end
+
+        // new host frame (last, the next loop cycle takes the new target)
+        if (jointPosCmd != pos_last || jointVelCmd != vel_last) begin
+            pos_last <= jointPosCmd;
+            vel_last <= jointVelCmd;
+            new_cmd <= 1;
+        end
+    end
+
+    // pwm
+    reg [PWM_BITS-1:0] pwm_cnt = 0;
+    reg [31:0] duty = 0;
+    reg pulse = 0;
+    assign PWM = pulse;
+    assign DIR = (out > 0);
+    always @(posedge clk) begin
+        if (pwm_cnt >= PWM_PERIOD - 1) begin
+            pwm_cnt <= 0;
+            duty <= (out < 0) ? -out : out;
+        end else begin
+            pwm_cnt <= pwm_cnt + 1'd1;
+        end
+        pulse <= jointEnable && (pwm_cnt < duty);
+    end
+endmodule
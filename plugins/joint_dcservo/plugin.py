@@ -0,0 +1,153 @@
+class Plugin:
+    def __init__(self, jdata):
+        self.jdata = jdata
+
+    def setup(self):
+        return [
+            {
+                "basetype": "joints",
+                "subtype": "joint_dcservo",
+                "comment": "dc-motor with encoder, position loop in the fpga (pwm/dir)",
+                "options": {
+                    "enable": {
+                        "type": "output",
+                        "name": "enable pin",
+                        "comment": "optional",
+                    },
+                    "pwm": {
+                        "type": "output",
+                        "name": "pwm pin",
+                    },
+                    "dir": {
+                        "type": "output",
+                        "name": "dir pin",
+                    },
+                    "enc_a": {
+                        "type": "input",
+                        "name": "encoder A pin",
+                    },
+                    "enc_b": {
+                        "type": "input",
+                        "name": "encoder B pin",
+                    },
+                    "frequency": {
+                        "type": "int",
+                        "name": "pwm frequency",
+                        "default": "100000",
+                    },
+                    "loop": {
+                        "type": "int",
+                        "name": "loop frequency",
+                        "default": "20000",
+                    },
+                    "kp": {
+                        "type": "int",
+                        "name": "p gain",
+                        "default": "4096",
+                    },
+                    "ki": {
+                        "type": "int",
+                        "name": "i gain",
+                        "default": "8",
+                    },
+                    "kd": {
+                        "type": "int",
+                        "name": "d gain",
+                        "default": "32768",
+                    },
+                    "vmax": {
+                        "type": "int",
+                        "name": "counts/s at 100% pwm",
+                        "comment": "velocity feed forward, 0: off",
+                        "default": "0",
+                    },
+                },
+            }
+        ]
+
+    def params(self, joint):
+        # fixed point parameters of joint_dcservo.v
+        sysclk = int(self.jdata["clock"]["speed"])
+        pwm_period = int(sysclk / int(joint.get("frequency", 100000)))
+        loop_div = int(sysclk / int(joint.get("loop", 20000)))
+        shift = 8
+        vmax = float(joint.get("vmax", 0))
+        kff = 0
+        if vmax > 0:
+            kff = round(pwm_period * (1 << shift) / (vmax * loop_div / sysclk))
+        return {
+            "PWM_PERIOD": pwm_period,
+            "LOOP_DIV": loop_div,
+            "VEL_SCALE": round(loop_div * (1 << 32) / sysclk),
+            "KP": int(joint.get("kp", 4096)),
+            "KI": int(joint.get("ki", 8)),
+            "KD": int(joint.get("kd", 32768)),
+            "KFF": kff,
+            "SHIFT": shift,
+        }
+
+    def pinlist(self):
+        pinlist_out = []
+        for num, joint in enumerate(self.jdata["plugins"]):
+            if joint["type"] == "joint_dcservo":
+                if "enable" in joint["pins"]:
+                    pinlist_out.append(
+                        (f"JOINT{num}_EN", joint["pins"]["enable"], "OUTPUT")
+                    )
+                pinlist_out.append(
+                    (f"JOINT{num}_DCSERVO_PWM", joint["pins"]["pwm"], "OUTPUT")
+                )
+                pinlist_out.append(
+                    (f"JOINT{num}_DCSERVO_DIR", joint["pins"]["dir"], "OUTPUT")
+                )
+                pullup = joint["pins"].get("pullup", False)
+                pinlist_out.append(
+                    (f"JOINT{num}_DCSERVO_ENCA", joint["pins"]["enc_a"], "INPUT", pullup)
+                )
+                pinlist_out.append(
+                    (f"JOINT{num}_DCSERVO_ENCB", joint["pins"]["enc_b"], "INPUT", pullup)
+                )
+        return pinlist_out
+
+    def jointnames(self):
+        ret = []
+        for num, data in enumerate(self.jdata["plugins"]):
+            if data.get("type") == "joint_dcservo":
+                name = data.get("name", f"JOINT.{num}")
+                nameIntern = name.replace(".", "").replace("-", "_").upper()
+                data["_name"] = name
+                data["_prefix"] = nameIntern
+                # position and velocity command (jointVelCmd in the frame)
+                data["_velocity"] = True
+                ret.append(data)
+        return ret
+
+    def funcs(self):
+        func_out = []
+        for num, joint in enumerate(self.jdata["plugins"]):
+            if joint["type"] == "joint_dcservo":
+                name = joint.get("name", f"JOINT.{num}")
+                nameIntern = name.replace(".", "").replace("-", "_").upper()
+                params = ", ".join(f".{key}({value})" for key, value in self.params(joint).items())
+                if "enable" in joint["pins"]:
+                    func_out.append(
+                        f"    assign JOINT{num}_EN = {nameIntern}Enable && ~ERROR;"
+                    )
+                func_out.append(f"    joint_dcservo #({params}) joint_dcservo{num} (")
+                func_out.append("        .clk (sysclk),")
+                func_out.append(f"        .jointEnable ({nameIntern}Enable && !ERROR),")
+                func_out.append(f"        .jointPosCmd ({nameIntern}FreqCmd),")
+                func_out.append(f"        .jointVelCmd ({nameIntern}VelCmd),")
+                func_out.append(f"        .jointFeedback ({nameIntern}Feedback),")
+                func_out.append(f"        .quadA (JOINT{num}_DCSERVO_ENCA),")
+                func_out.append(f"        .quadB (JOINT{num}_DCSERVO_ENCB),")
+                func_out.append(f"        .DIR (JOINT{num}_DCSERVO_DIR),")
+                func_out.append(f"        .PWM (JOINT{num}_DCSERVO_PWM)")
+                func_out.append("    );")
+        return func_out
+
+    def ips(self):
+        for num, joint in enumerate(self.jdata["plugins"]):
+            if joint["type"] == "joint_dcservo":
+                return ["joint_dcservo.v"]
+        return []
@@ -0,0 +1,211 @@
+`timescale 1ns/100ps
+
+// self-checking: joint_dcservo against a simulated dc motor with encoder
+//   motor: first order (tau 20ms), 100000 counts/s at 100% duty, the encoder signals from the position
+//   host: new position/velocity every 1ms (step, ramp with 10000 counts/s, stop)
+//   checks the position error after settling and while following the ramp
+//   second instance: pwm period and loop divider above 16 bit
+module testb;
+    reg clk = 0;
+    always #50 clk = !clk;
+
+    // 10MHz: 100kHz pwm, 20kHz loop
+    parameter CLK = 10000000;
+    parameter PWM_PERIOD = 100;
+    parameter LOOP_DIV = 500;
+    parameter VMAX = 100000.0;
+    parameter TAU = 0.02;
+
+    reg jointEnable = 0;
+    reg signed [31:0] jointPosCmd = 0;
+    reg signed [31:0] jointVelCmd = 0;
+    wire signed [31:0] jointFeedback;
+    reg quadA = 0;
+    reg quadB = 0;
+    wire DIR;
+    wire PWM;
+
+    // gains scaled to PWM_PERIOD 100, KFF = PWM_PERIOD * 2^SHIFT / (VMAX * LOOP_DIV / CLK)
+    joint_dcservo #(
+        .PWM_PERIOD (PWM_PERIOD),
+        .LOOP_DIV (LOOP_DIV),
+        .VEL_SCALE (214748),
+        .KP (1517),
+        .KI (3),
+        .KD (12136),
+        .KFF (5120),
+        .SHIFT (8)
+    ) joint_dcservo1 (
+        .clk (clk),
+        .jointEnable (jointEnable),
+        .jointPosCmd (jointPosCmd),
+        .jointVelCmd (jointVelCmd),
+        .jointFeedback (jointFeedback),
+        .quadA (quadA),
+        .quadB (quadB),
+        .DIR (DIR),
+        .PWM (PWM)
+    );
+
+    // long periods (counters wider than 16 bit): 50% duty from a fixed position error of 1 count
+    wire long_PWM;
+    joint_dcservo #(
+        .PWM_PERIOD (70000),
+        .LOOP_DIV (70000),
+        .VEL_SCALE (0),
+        .KP (8960000),
+        .KI (0),
+        .KD (0),
+        .KFF (0),
+        .SHIFT (8)
+    ) joint_dcservo2 (
+        .clk (clk),
+        .jointEnable (jointEnable),
+        .jointPosCmd (32'sd1),
+        .jointVelCmd (32'sd0),
+        .jointFeedback (),
+        .quadA (1'b0),
+        .quadB (1'b0),
+        .DIR (),
+        .PWM (long_PWM)
+    );
+
+    integer long_clocks = 0;
+    integer long_high = 0;
+    integer long_period = 0;
+    integer long_duty = 0;
+    reg long_last = 0;
+    always @(posedge clk) begin
+        long_clocks = long_clocks + 1;
+        if (long_PWM && !long_last) begin
+            long_period = long_clocks;
+            long_duty = long_high;
+            long_clocks = 0;
+            long_high = 0;
+        end
+        if (long_PWM) begin
+            long_high = long_high + 1;
+        end
+        long_last = long_PWM;
+    end
+
+    // motor model
+    real pos = 0.0;
+    real vel = 0.0;
+    real drive = 0.0;
+    integer count = 0;
+
+    // floor() of the motor position
+    function integer counts;
+        input real value;
+        begin
+            counts = $rtoi(value);
+            if (value < counts) begin
+                counts = counts - 1;
+            end
+        end
+    endfunction
+
+    always @(posedge clk) begin
+        if (PWM) begin
+            drive = DIR ? VMAX : -VMAX;
+        end else begin
+            drive = 0.0;
+        end
+        vel = vel + (drive - vel) / (TAU * CLK);
+        pos = pos + vel / CLK;
+        count = counts(pos);
+        quadA <= (count[1:0] == 2'd1 || count[1:0] == 2'd2);
+        quadB <= (count[1:0] == 2'd2 || count[1:0] == 2'd3);
+    end
+
+    // host
+    real ref = 0.0;
+    real ramp_start = 0.0;
+    real error;
+    real max_error = 0.0;
+    integer errors = 0;
+    integer ms;
+
+    task check;
+        input real limit;
+        input [8*8-1:0] name;
+        begin
+            if (max_error > limit) begin
+                $display("ERROR: %0s: max. position error %f (limit: %f)", name, max_error, limit);
+                errors = errors + 1;
+            end else begin
+                $display("%0s: max. position error %f", name, max_error);
+            end
+            max_error = 0.0;
+        end
+    endtask
+
+    always @(posedge clk) begin
+        error = ref + jointVelCmd * ($realtime - ramp_start) / 1000000000.0 - pos;
+        if (error < 0.0) begin
+            error = -error;
+        end
+    end
+
+    initial begin
+        $dumpfile("testb.vcd");
+        $dumpvars(0, testb);
+
+        // disabled: no pwm
+        #1000000
+        if (PWM || jointFeedback != 0) begin
+            $display("ERROR: disabled joint moves");
+            errors = errors + 1;
+        end
+        jointEnable = 1;
+
+        // step to 200 counts
+        #9000000
+        ref = 200.0;
+        jointPosCmd = 200;
+        for (ms = 0; ms < 110; ms = ms + 1) begin
+            #1000000
+            if (ms >= 90 && error > max_error) max_error = error;
+        end
+        check(2.0, "step");
+
+        // ramp: 10000 counts/s for 100ms, new position every 1ms
+        jointVelCmd = 10000;
+        for (ms = 0; ms < 100; ms = ms + 1) begin
+            ramp_start = $realtime;
+            jointPosCmd = 200 + ms * 10;
+            ref = jointPosCmd;
+            #1000000
+            if (ms >= 30 && error > max_error) max_error = error;
+        end
+        check(8.0, "ramp");
+
+        // stop
+        jointVelCmd = 0;
+        jointPosCmd = 1200;
+        ref = 1200.0;
+        for (ms = 0; ms < 80; ms = ms + 1) begin
+            #1000000
+            if (ms >= 50 && error > max_error) max_error = error;
+        end
+        check(2.0, "stop");
+
+        if (long_period != 70000 || long_duty != 35000) begin
+            $display("ERROR: long periods: pwm period %0d (70000), duty %0d (35000)", long_period, long_duty);
+            errors = errors + 1;
+        end
+
+        if (jointFeedback != count) begin
+            $display("ERROR: feedback %0d, motor position %f", jointFeedback, pos);
+            errors = errors + 1;
+        end
+
+        if (errors == 0) begin
+            $display("OK");
+        end else begin
+            $display("FAILED: %0d errors", errors);
+        end
+        $finish;
+    end
+endmodule
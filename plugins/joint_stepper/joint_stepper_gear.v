@@ -0,0 +1,92 @@
+/* verilator lint_off WIDTHEXPAND */
+/* verilator lint_off WIDTHTRUNC */
+
+// electronic gearbox: stepper that follows an encoder (rigid tapping / threading)
+//   every encoder count adds the ratio (steps per count, Q16.16) to the gear position (DDA),
+//   the frequency command of the host (same as joint_stepper) adds the phase trim,
+//   the step output follows the sum with at least PULSE clocks per step level and before a dir change
+//   encoder jumps (index reset) are ignored, the encoder has to count at most one per clock
+module joint_stepper_gear
+    #(parameter PULSE = 32)
+     (
+         input clk,
+         input jointEnable,
+         input signed [31:0] jointFreqCmd,
+         input signed [31:0] gearRatio,
+         input signed [31:0] gearPos,
+         output signed [31:0] jointFeedback,
+         output DIR,
+         output STP
+     );
+
+    // gear position (steps, Q32.16)
+    reg signed [31:0] gear_last = 0;
+    reg signed [47:0] gear_acc = 0;
+    wire signed [31:0] gear_diff = gearPos - gear_last;
+    wire signed [47:0] ratio = gearRatio;
+    always @(posedge clk) begin
+        gear_last <= gearPos;
+        if (jointEnable) begin
+            if (gear_diff == 1) begin
+                gear_acc <= gear_acc + ratio;
+            end else if (gear_diff == -1) begin
+                gear_acc <= gear_acc - ratio;
+            end
+        end
+    end
+
+    // phase trim (two periods of jointFreqCmd per step, like joint_stepper)
+    reg [31:0] trim_counter = 0;
+    reg trim_half = 0;
+    reg signed [31:0] trim_pos = 0;
+    wire [31:0] trim_period = (jointFreqCmd > 0) ? jointFreqCmd : -jointFreqCmd;
+    always @(posedge clk) begin
+        trim_counter <= trim_counter + 1;
+        if (jointFreqCmd != 0 && jointEnable) begin
+            if (trim_counter >= trim_period) begin
+                trim_counter <= 0;
+                trim_half <= ~trim_half;
+                if (trim_half) begin
+                    if (jointFreqCmd > 0) begin
+                        trim_pos <= trim_pos + 1;
+                    end else begin
+                        trim_pos <= trim_pos - 1;
+                    end
+                end
+            end
+        end
+    end
+
+    // step output
+    reg signed [31:0] pos = 0;
+    wire signed [31:0] target = gear_acc[47:16] + trim_pos;
+    wire signed [31:0] diff = target - pos;
+    reg [15:0] wait_counter = 0;
+    reg step = 0;
+    reg dir = 0;
+    assign STP = step;
+    assign DIR = dir;
+    assign jointFeedback = pos;
+    always @(posedge clk) begin
+        if (wait_counter != 0) begin
+            wait_counter <= wait_counter - 16'd1;
+        end else if (step) begin
+            step <= 0;
+            wait_counter <= PULSE;
+        end else if (diff != 0) begin
+            if (dir != (diff > 0)) begin
+                // dir setup time
+                dir <= (diff > 0);
+                wait_counter <= PULSE;
+            end else begin
+                step <= 1;
+                wait_counter <= PULSE;
+                if (dir) begin
+                    pos <= pos + 1;
+                end else begin
+                    pos <= pos - 1;
+                end
+            end
+        end
+    end
+endmodule
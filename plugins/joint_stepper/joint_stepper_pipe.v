@@ -0,0 +1,80 @@
+/* verilator lint_off WIDTHEXPAND */
+/* verilator lint_off WIDTHTRUNC */
+
+// retimed joint_stepper (same step period: jointFreqCmd + 1 clocks per step level)
+//   stage 1: the command is registered as absolute value, direction and run flag,
+//            counter > command is compared in two registered 16bit halves
+//   stage 2: down counter, reloaded at zero (no 32bit compare and increment in one clock),
+//            a lower command cuts the running period two clocks later
+//   logic between registers: the 32bit decrement (carry chain) and the zero test of the counter,
+//   the 16bit compares and the sign mux of the command, joint_stepper: 32bit increment and 32bit compare in series
+//   STP and DIR are registers, the dir pin only changes with the step pin low and DIR_SETUP clocks before the next step
+module joint_stepper_pipe
+    #(parameter DIR_SETUP = 32)
+     (
+         input clk,
+         input jointEnable,
+         input signed [31:0] jointFreqCmd,
+         output signed [31:0] jointFeedback,
+         output DIR,
+         output STP
+     );
+
+    // stage 1
+    reg [31:0] cmd_abs = 0;
+    reg cmd_dir = 0;
+    reg cmd_run = 0;
+    reg cmd_cut = 0;
+    reg cut_hi_gt = 0;
+    reg cut_hi_eq = 0;
+    reg cut_lo_gt = 0;
+    reg [31:0] counter = 0;
+    always @(posedge clk) begin
+        if (jointFreqCmd[31]) begin
+            cmd_abs <= -jointFreqCmd;
+        end else begin
+            cmd_abs <= jointFreqCmd;
+        end
+        cmd_dir <= ~jointFreqCmd[31];
+        cmd_run <= (jointFreqCmd != 0 && jointEnable == 1);
+        cut_hi_gt <= (counter[31:16] > cmd_abs[31:16]);
+        cut_hi_eq <= (counter[31:16] == cmd_abs[31:16]);
+        cut_lo_gt <= (counter[15:0] > cmd_abs[15:0]);
+        cmd_cut <= cut_hi_gt || (cut_hi_eq && cut_lo_gt);
+    end
+
+    // stage 2
+    reg [15:0] setup_counter = 0;
+    reg signed [31:0] jointFeedbackMem = 0;
+    reg step = 0;
+    reg dir = 0;
+    assign STP = step;
+    assign DIR = dir;
+    assign jointFeedback = jointFeedbackMem;
+    always @(posedge clk) begin
+        if (setup_counter != 0) begin
+            setup_counter <= setup_counter - 16'd1;
+        end else if (cmd_run) begin
+            if (!step && dir != cmd_dir) begin
+                // dir setup time
+                dir <= cmd_dir;
+                setup_counter <= DIR_SETUP;
+                counter <= cmd_abs;
+            end else if (counter == 0) begin
+                step <= ~step;
+                counter <= cmd_abs;
+                if (step) begin
+                    if (dir) begin
+                        jointFeedbackMem <= jointFeedbackMem + 1;
+                    end else begin
+                        jointFeedbackMem <= jointFeedbackMem - 1;
+                    end
+                end
+            end else if (cmd_cut) begin
+                counter <= cmd_abs;
+            end else begin
+                counter <= counter - 32'd1;
+            end
+        end
+    end
+endmodule
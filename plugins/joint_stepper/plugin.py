@@ -23,6 +23,23 @@ class Plugin:
                         "name": "axis scale",
                         "default": "800",
                     },
+                    "gear": {
+                        "type": "str",
+                        "name": "gear encoder",
+                        "comment": "name of an encoder vin, the steps follow it with the gear ratio of the host (electronic gearbox)",
+                        "default": "",
+                    },
+                    "pulse": {
+                        "type": "int",
+                        "name": "step pulse (ns)",
+                        "comment": "min. step pulse/pause and dir setup time in gear mode, dir setup time in pipelined mode",
+                        "default": "2000",
+                    },
+                    "pipelined": {
+                        "type": "bool",
+                        "name": "pipelined",
+                        "comment": "retimed step generator for higher sysclk / step rates, registered dir with setup time (pulse)",
+                    },
                     "pins": {
                         "type": "dict",
                         "name": "pin config",
@@ -117,9 +134,30 @@ class Plugin:
                 nameIntern = name.replace(".", "").replace("-", "_").upper()
                 data["_name"] = name
                 data["_prefix"] = nameIntern
+                if data.get("gear"):
+                    if data.get("cl"):
+                        print(f"ERROR: joint '{name}': gear mode is not possible with closed loop")
+                        exit(1)
+                    # gear ratio (jointGearRatio in the frame)
+                    data["_gear"] = data["gear"]
                 ret.append(data)
         return ret
 
+    def gear_encoder(self, joint):
+        # wire of the encoder vin (same naming as the vin plugins, _name of the vin, default: PV.<num>)
+        #   not data["_name"]: vin_quadencoderz overwrites it with the name of its index din/dout
+        for num, data in enumerate(self.jdata["plugins"]):
+            name = data.get("name", f"PV.{num}")
+            if data.get("type", "").startswith("vin_quadencoder") and name == joint["gear"]:
+                return name.replace(".", "").replace("-", "_").upper()
+        print(f"ERROR: joint '{joint['_name']}': gear encoder '{joint['gear']}' not found")
+        exit(1)
+
+    def dir_setup(self, joint):
+        # dir setup time in clocks (16bit counter)
+        sysclk = int(self.jdata["clock"]["speed"])
+        return min(max(int(sysclk * int(joint.get("pulse", 2000)) / 1000000000), 1), 65535)
+
     def funcs(self):
         func_out = []
         for num, joint in enumerate(self.jdata["plugins"]):
@@ -147,12 +185,39 @@ class Plugin:
                     func_out.append(f"        .quadB (JOINT{num}_STEPPER_ENCB),")
                     func_out.append(f"        .pos ({nameIntern}Feedback)")
                     func_out.append("    );")
-                    func_out.append(f"    joint_stepper_nf joint_stepper{num} (")
+                    if joint.get("pipelined"):
+                        func_out.append(f"    joint_stepper_pipe #({self.dir_setup(joint)}) joint_stepper{num} (")
+                    else:
+                        func_out.append(f"    joint_stepper_nf joint_stepper{num} (")
+                    func_out.append("        .clk (sysclk),")
+                    func_out.append(
+                        f"        .jointEnable ({nameIntern}Enable && !ERROR),"
+                    )
+                    func_out.append(f"        .jointFreqCmd ({nameIntern}FreqCmd),")
+                    if joint.get("pipelined"):
+                        func_out.append("        .jointFeedback (),")
+
+                elif joint.get("gear"):
+                    sysclk = int(self.jdata["clock"]["speed"])
+                    pulse = max(int(sysclk * int(joint.get("pulse", 2000)) / 1000000000), 1)
+                    func_out.append(f"    joint_stepper_gear #({pulse}) joint_stepper{num} (")
+                    func_out.append("        .clk (sysclk),")
+                    func_out.append(
+                        f"        .jointEnable ({nameIntern}Enable && !ERROR),"
+                    )
+                    func_out.append(f"        .jointFreqCmd ({nameIntern}FreqCmd),")
+                    func_out.append(f"        .gearRatio ({nameIntern}GearRatio),")
+                    func_out.append(f"        .gearPos ({self.gear_encoder(joint)}),")
+                    func_out.append(f"        .jointFeedback ({nameIntern}Feedback),")
+
+                elif joint.get("pipelined"):
+                    func_out.append(f"    joint_stepper_pipe #({self.dir_setup(joint)}) joint_stepper{num} (")
                     func_out.append("        .clk (sysclk),")
                     func_out.append(
                         f"        .jointEnable ({nameIntern}Enable && !ERROR),"
                     )
                     func_out.append(f"        .jointFreqCmd ({nameIntern}FreqCmd),")
+                    func_out.append(f"        .jointFeedback ({nameIntern}Feedback),")
 
                 else:
                     func_out.append(f"    joint_stepper joint_stepper{num} (")
@@ -173,7 +238,17 @@ class Plugin:
         return func_out
 
     def ips(self):
+        ips = []
         for num, joint in enumerate(self.jdata["plugins"]):
             if joint["type"] in ["joint_stepper"]:
-                return ["quad_encoder.v", "joint_stepper.v", "joint_stepper_nf.v"]
-        return []
+                ips = ["quad_encoder.v", "joint_stepper.v", "joint_stepper_nf.v"]
+                break
+        for num, joint in enumerate(self.jdata["plugins"]):
+            if joint["type"] in ["joint_stepper"] and joint.get("gear"):
+                ips.append("joint_stepper_gear.v")
+                break
+        for num, joint in enumerate(self.jdata["plugins"]):
+            if joint["type"] in ["joint_stepper"] and joint.get("pipelined") and not joint.get("gear"):
+                ips.append("joint_stepper_pipe.v")
+                break
+        return ips
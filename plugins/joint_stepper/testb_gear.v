@@ -0,0 +1,93 @@
+`timescale 1ns/100ps
+
+// joint_stepper_gear: the steps follow the encoder counts * ratio, plus the phase trim
+module testb;
+    reg clk = 0;
+    always #2 clk = !clk;
+
+    reg jointEnable = 1;
+    reg signed [31:0] jointFreqCmd = 0;
+    reg signed [31:0] gearRatio = 32'h00028000; // 2.5 steps per count
+    reg signed [31:0] gearPos = 0;
+    wire signed [31:0] jointFeedback;
+    wire DIR;
+    wire STP;
+
+    integer errors = 0;
+    integer steps = 0;
+
+    // steps counted at the rising edge of STP
+    always @(posedge STP) begin
+        if (DIR) begin
+            steps = steps + 1;
+        end else begin
+            steps = steps - 1;
+        end
+    end
+
+    task encoder(input integer counts, input integer period);
+        integer n;
+        begin
+            for (n = 0; n < (counts > 0 ? counts : -counts); n = n + 1) begin
+                repeat (period) @(posedge clk);
+                gearPos <= gearPos + (counts > 0 ? 1 : -1);
+            end
+            repeat (200) @(posedge clk);
+        end
+    endtask
+
+    task check(input integer expected);
+        begin
+            if (jointFeedback != expected || steps != expected) begin
+                $display("ERROR: feedback %0d steps %0d (expected: %0d)", jointFeedback, steps, expected);
+                errors = errors + 1;
+            end
+        end
+    endtask
+
+    initial begin
+        $dumpfile("testb_gear.vcd");
+        $dumpvars(0, testb);
+
+        encoder(100, 40);
+        check(250);
+        encoder(-40, 40);
+        check(150);
+
+        // index reset of the encoder: no movement
+        gearPos <= 0;
+        repeat (200) @(posedge clk);
+        check(150);
+
+        // 0.25 steps per count, the fraction is kept
+        gearRatio <= 32'h00004000;
+        encoder(10, 10);
+        check(152);
+
+        // phase trim: 10 steps with 2 * 50 clocks per step
+        jointFreqCmd <= 50;
+        repeat (1000) @(posedge clk);
+        jointFreqCmd <= 0;
+        repeat (200) @(posedge clk);
+        check(162);
+
+        if (errors == 0) begin
+            $display("OK");
+        end else begin
+            $display("FAILED: %0d errors", errors);
+        end
+        $finish;
+    end
+
+    joint_stepper_gear #(.PULSE(4)) joint_stepper_gear1 (
+        .clk (clk),
+        .jointEnable (jointEnable),
+        .jointFreqCmd (jointFreqCmd),
+        .gearRatio (gearRatio),
+        .gearPos (gearPos),
+        .jointFeedback (jointFeedback),
+        .DIR (DIR),
+        .STP (STP)
+    );
+
+endmodule
@@ -0,0 +1,158 @@
+`timescale 1ns/100ps
+
+// self-checking: compares joint_stepper_pipe against joint_stepper
+//   step period (clocks between rising edges) is the same for every command
+//   feedback of joint_stepper_pipe = counted step edges (exact), dir stable from DIR_SETUP clocks before the rising edge until the falling edge
+//   feedback vs. joint_stepper: the pipeline and the dir setup time shift the steps by a few edges per command change
+module testb;
+    reg clk = 0;
+    always #5 clk = !clk;
+
+    reg jointEnable = 1;
+    reg signed [31:0] jointFreqCmd = 10;
+
+    wire signed [31:0] ref_feedback;
+    wire ref_STP;
+    joint_stepper joint_stepper0 (
+        .clk (clk),
+        .jointEnable (jointEnable),
+        .jointFreqCmd (jointFreqCmd),
+        .jointFeedback (ref_feedback),
+        .DIR (),
+        .STP (ref_STP)
+    );
+
+    wire signed [31:0] feedback;
+    wire DIR;
+    wire STP;
+    joint_stepper_pipe #(8) joint_stepper_pipe0 (
+        .clk (clk),
+        .jointEnable (jointEnable),
+        .jointFreqCmd (jointFreqCmd),
+        .jointFeedback (feedback),
+        .DIR (DIR),
+        .STP (STP)
+    );
+
+    integer errors = 0;
+    integer clocks = 0;
+    integer counted = 0;
+    integer dir_age = 0;
+    integer offset = 0;
+    integer diff;
+    integer ref_rise = -1;
+    integer ref_period = 0;
+    integer rise = -1;
+    integer period = 0;
+    reg last_stp = 0;
+    reg last_dir = 0;
+    reg last_ref_stp = 0;
+
+    always @(posedge clk) begin
+        #1
+        clocks = clocks + 1;
+        if (DIR != last_dir) begin
+            if (STP) begin
+                $display("ERROR: dir change with the step pin high");
+                errors = errors + 1;
+            end
+            dir_age = 0;
+        end else begin
+            dir_age = dir_age + 1;
+        end
+        if (STP != last_stp) begin
+            if (STP) begin
+                if (dir_age < 8) begin
+                    $display("ERROR: step %0d clocks after dir change", dir_age);
+                    errors = errors + 1;
+                end
+                if (rise >= 0) begin
+                    period = clocks - rise;
+                end
+                rise = clocks;
+            end else begin
+                counted = counted + (DIR ? 1 : -1);
+            end
+        end
+        if (ref_STP && !last_ref_stp) begin
+            if (ref_rise >= 0) begin
+                ref_period = clocks - ref_rise;
+            end
+            ref_rise = clocks;
+        end
+        last_stp = STP;
+        last_dir = DIR;
+        last_ref_stp = ref_STP;
+    end
+
+    // tolerance: steps of difference to joint_stepper that this command change may add
+    task check;
+        input integer tolerance;
+        begin
+            if (feedback != counted) begin
+                $display("ERROR: feedback %0d != counted steps %0d", feedback, counted);
+                errors = errors + 1;
+            end
+            if (period != ref_period) begin
+                $display("ERROR: cmd %0d: period %0d != joint_stepper %0d", jointFreqCmd, period, ref_period);
+                errors = errors + 1;
+            end
+            diff = (feedback - ref_feedback) - offset;
+            if (diff > tolerance || diff < -tolerance) begin
+                $display("ERROR: cmd %0d: feedback %0d, joint_stepper %0d (offset %0d)", jointFreqCmd, feedback, ref_feedback, offset);
+                errors = errors + 1;
+            end
+            offset = feedback - ref_feedback;
+            $display("cmd %0d: feedback %0d (joint_stepper: %0d) period %0d (joint_stepper: %0d)", jointFreqCmd, feedback, ref_feedback, period, ref_period);
+            period = 0;
+            ref_period = 0;
+        end
+    endtask
+
+    initial begin
+        $dumpfile("testb_pipe.vcd");
+        $dumpvars(0, testb);
+
+        # 200000
+        check(1);
+        jointFreqCmd = -7;
+        # 200000
+        check(3);
+        jointFreqCmd = 100;
+        # 200000
+        check(3);
+        // a lower command cuts the running period
+        jointFreqCmd = 1000000;
+        # 100000
+        jointFreqCmd = 3;
+        # 200000
+        check(2);
+        jointFreqCmd = -3;
+        # 200000
+        check(3);
+        // dir setup (8 clocks) = 2 steps at 4 clocks per step
+        jointFreqCmd = 1;
+        # 200000
+        check(5);
+        jointFreqCmd = 0;
+        # 100000
+        period = 0;
+        ref_period = 0;
+        check(1);
+        jointFreqCmd = 55;
+        jointEnable = 0;
+        # 100000
+        check(1);
+        jointEnable = 1;
+        # 200000
+        check(2);
+
+        if (errors == 0) begin
+            $display("OK");
+        end else begin
+            $display("FAILED: %0d errors", errors);
+        end
+        $finish;
+    end
+
+endmodule
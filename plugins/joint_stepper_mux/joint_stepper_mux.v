@@ -0,0 +1,92 @@
+
+// step/dir generator for JOINTS joints with one shared counter/compare/feedback pipeline
+//   the joints are processed round robin, one joint per clock, the state lives in memories
+//   same jointFreqCmd as joint_stepper: the step pin toggles every |jointFreqCmd| + 1 clocks
+//   every joint is visited every SLOTS clocks, the counter advances by SLOTS per visit and
+//   keeps the remainder, so the average step rate is exact, the jitter is SLOTS clocks
+//   max. step frequency: clk / (2 * SLOTS)
+//   a new direction is set one visit (SLOTS clocks) before the next step edge
+module joint_stepper_mux
+    #(parameter JOINTS = 2)
+    (
+        input clk,
+        input [JOINTS-1:0] jointEnable,
+        input [JOINTS*32-1:0] jointFreqCmd,
+        output reg [JOINTS*32-1:0] jointFeedback = 0,
+        output reg [JOINTS-1:0] DIR = 0,
+        output reg [JOINTS-1:0] STP = 0
+    );
+    // at least two slots, the memory is read and written at different addresses
+    localparam SLOTS = (JOINTS < 2) ? 2 : JOINTS;
+    localparam AW = (SLOTS <= 2) ? 1 : $clog2(SLOTS);
+
+    reg [31:0] counter_mem [0:SLOTS-1];
+    // the feedback is also kept in a memory, only the write goes to the output registers
+    reg signed [31:0] feedback_mem [0:SLOTS-1];
+
+    integer i;
+    initial begin
+        for (i = 0; i < SLOTS; i = i + 1) begin
+            counter_mem[i] = 0;
+            feedback_mem[i] = 0;
+        end
+    end
+
+    // unused slots read zero
+    wire [SLOTS*32-1:0] cmds = jointFreqCmd;
+    wire [SLOTS-1:0] enables = jointEnable;
+
+    // stage 1: read
+    reg [AW-1:0] idx = 0;
+    reg [AW-1:0] idx_b = 0;
+    reg valid_b = 0;
+    reg [31:0] counter_b = 0;
+    reg signed [31:0] feedback_b = 0;
+    reg signed [31:0] cmd_b = 0;
+    reg enable_b = 0;
+
+    // stage 2: step logic
+    wire dir_b = (cmd_b > 0);
+    wire [31:0] cmd_abs = cmd_b[31] ? -cmd_b : cmd_b;
+    wire [31:0] period = cmd_abs + 1;
+    wire [31:0] counter_next = counter_b + SLOTS;
+    wire [31:0] counter_rest = counter_next - period;
+    wire active = valid_b && enable_b && cmd_b != 0;
+    wire toggle = active && counter_next >= period && DIR[idx_b] == dir_b;
+    wire signed [31:0] feedback_next = dir_b ? feedback_b + 1 : feedback_b - 1;
+
+    always @(posedge clk) begin
+        if (idx == SLOTS - 1) begin
+            idx <= 0;
+        end else begin
+            idx <= idx + 1;
+        end
+        idx_b <= idx;
+        valid_b <= (idx < JOINTS);
+        counter_b <= counter_mem[idx];
+        feedback_b <= feedback_mem[idx];
+        cmd_b <= cmds[idx*32+:32];
+        enable_b <= enables[idx];
+
+        if (valid_b) begin
+            DIR[idx_b] <= dir_b;
+            if (toggle) begin
+                STP[idx_b] <= ~STP[idx_b];
+                // faster than one edge per visit: limited to clk / (2 * SLOTS)
+                if (counter_rest > cmd_abs) begin
+                    counter_mem[idx_b] <= cmd_abs;
+                end else begin
+                    counter_mem[idx_b] <= counter_rest;
+                end
+                if (STP[idx_b]) begin
+                    feedback_mem[idx_b] <= feedback_next;
+                    jointFeedback[idx_b*32+:32] <= feedback_next;
+                end
+            end else if (active) begin
+                counter_mem[idx_b] <= counter_next;
+            end else begin
+                counter_mem[idx_b] <= 0;
+            end
+        end
+    end
+endmodule
@@ -0,0 +1,138 @@
+class Plugin:
+    def __init__(self, jdata):
+        self.jdata = jdata
+
+    def setup(self):
+        return [
+            {
+                "basetype": "joints",
+                "subtype": "joint_stepper_mux",
+                "comment": "stepper joints sharing one step engine (less LUTs, max. step frequency: sysclk / (2 * joints))",
+                "options": {
+                    "invert_dir": {
+                        "type": "bool",
+                        "name": "invert dir pin",
+                        "comment": "inverts the dir pin",
+                    },
+                    "scale": {
+                        "type": "int",
+                        "name": "axis scale",
+                        "default": "800",
+                    },
+                    "pins": {
+                        "type": "dict",
+                        "name": "pin config",
+                        "options": {
+                            "step": {
+                                "type": "output",
+                                "name": "stepper pin",
+                                "comment": "do not use expansion-pins here, we need very fast pulses",
+                            },
+                            "dir": {
+                                "type": "output",
+                                "name": "dir pin",
+                            },
+                            "enable": {
+                                "type": "output",
+                                "name": "enable pin",
+                                "comment": "this pin is optional",
+                            },
+                        },
+                    },
+                },
+            }
+        ]
+
+    def types(self):
+        return [
+            "stepper",
+        ]
+
+    def entry_info(self, joint):
+        info = ""
+        if joint.get("type") == "joint_stepper_mux":
+            info += "Stepper-Mux ("
+            for ptype, pname in joint["pins"].items():
+                if pname:
+                    info += f" {ptype}:{pname}"
+            info += ")"
+        return info
+
+    def pinlist(self):
+        pinlist_out = []
+        for num, joint in enumerate(self.jdata["plugins"]):
+            if joint["type"] == "joint_stepper_mux":
+                if "enable" in joint["pins"]:
+                    pinlist_out.append(
+                        (f"JOINT{num}_EN", joint["pins"]["enable"], "OUTPUT")
+                    )
+                pinlist_out.append(
+                    (f"JOINT{num}_STEPPER_STP", joint["pins"]["step"], "OUTPUT")
+                )
+                pinlist_out.append(
+                    (f"JOINT{num}_STEPPER_DIR", joint["pins"]["dir"], "OUTPUT")
+                )
+        return pinlist_out
+
+    def jointnames(self):
+        ret = []
+        for num, data in enumerate(self.jdata["plugins"]):
+            if data.get("type") == "joint_stepper_mux":
+                name = data.get("name", f"JOINT.{num}")
+                nameIntern = name.replace(".", "").replace("-", "_").upper()
+                data["_name"] = name
+                data["_prefix"] = nameIntern
+                ret.append(data)
+        return ret
+
+    def funcs(self):
+        func_out = []
+        enables = []
+        cmds = []
+        feedbacks = []
+        dirs = []
+        steps = []
+        for num, joint in enumerate(self.jdata["plugins"]):
+            if joint["type"] == "joint_stepper_mux":
+                name = joint.get("name", f"JOINT.{num}")
+                nameIntern = name.replace(".", "").replace("-", "_").upper()
+
+                if "enable" in joint["pins"]:
+                    func_out.append(
+                        f"    assign JOINT{num}_EN = {nameIntern}Enable && ~ERROR;"
+                    )
+                if joint.get("invert_dir", False):
+                    func_out.append(
+                        f"    wire JOINT{num}_STEPPER_DIR_INVERTED; // inverted dir wire"
+                    )
+                    func_out.append(
+                        f"    assign JOINT{num}_STEPPER_DIR = !JOINT{num}_STEPPER_DIR_INVERTED; // invert dir output"
+                    )
+                    dirs.append(f"JOINT{num}_STEPPER_DIR_INVERTED")
+                else:
+                    dirs.append(f"JOINT{num}_STEPPER_DIR")
+
+                # msb first: the last joint is the highest slot
+                enables.insert(0, f"{nameIntern}Enable && !ERROR")
+                cmds.insert(0, f"{nameIntern}FreqCmd")
+                feedbacks.insert(0, f"{nameIntern}Feedback")
+                steps.insert(0, f"JOINT{num}_STEPPER_STP")
+
+        if cmds:
+            dirs.reverse()
+            func_out.append(f"    joint_stepper_mux #({len(cmds)}) joint_stepper_mux0 (")
+            func_out.append("        .clk (sysclk),")
+            func_out.append(f"        .jointEnable ({{{', '.join(enables)}}}),")
+            func_out.append(f"        .jointFreqCmd ({{{', '.join(cmds)}}}),")
+            func_out.append(f"        .jointFeedback ({{{', '.join(feedbacks)}}}),")
+            func_out.append(f"        .DIR ({{{', '.join(dirs)}}}),")
+            func_out.append(f"        .STP ({{{', '.join(steps)}}})")
+            func_out.append("    );")
+
+        return func_out
+
+    def ips(self):
+        for num, joint in enumerate(self.jdata["plugins"]):
+            if joint["type"] in ["joint_stepper_mux"]:
+                return ["joint_stepper_mux.v"]
+        return []
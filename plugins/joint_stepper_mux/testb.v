@@ -0,0 +1,130 @@
+`timescale 1ns/100ps
+
+// self-checking: compares joint_stepper_mux against three joint_stepper instances
+//   feedback of the mux = counted step edges (exact), mux vs. joint_stepper (max. 1 step per command change)
+//   dir is stable for at least one visit (3 clocks) before a step edge
+module testb;
+    reg clk = 0;
+    always #5 clk = !clk;
+
+    reg [2:0] jointEnable = 3'b111;
+    reg signed [31:0] cmd0 = 10;
+    reg signed [31:0] cmd1 = -25;
+    reg signed [31:0] cmd2 = 0;
+
+    wire [95:0] feedback;
+    wire [2:0] DIR;
+    wire [2:0] STP;
+
+    joint_stepper_mux #(3) mux (
+        .clk (clk),
+        .jointEnable (jointEnable),
+        .jointFreqCmd ({cmd2, cmd1, cmd0}),
+        .jointFeedback (feedback),
+        .DIR (DIR),
+        .STP (STP)
+    );
+
+    wire signed [31:0] ref0;
+    wire signed [31:0] ref1;
+    wire signed [31:0] ref2;
+    joint_stepper joint_stepper0 (.clk (clk), .jointEnable (jointEnable[0]), .jointFreqCmd (cmd0), .jointFeedback (ref0), .DIR (), .STP ());
+    joint_stepper joint_stepper1 (.clk (clk), .jointEnable (jointEnable[1]), .jointFreqCmd (cmd1), .jointFeedback (ref1), .DIR (), .STP ());
+    joint_stepper joint_stepper2 (.clk (clk), .jointEnable (jointEnable[2]), .jointFreqCmd (cmd2), .jointFeedback (ref2), .DIR (), .STP ());
+
+    // step edges counted on the pins
+    integer counted [0:2];
+    integer dir_age [0:2];
+    reg [2:0] last_stp = 0;
+    reg [2:0] last_dir = 0;
+    integer errors = 0;
+    integer n;
+
+    initial begin
+        for (n = 0; n < 3; n = n + 1) begin
+            counted[n] = 0;
+            dir_age[n] = 0;
+        end
+    end
+
+    always @(posedge clk) begin
+        #1
+        for (n = 0; n < 3; n = n + 1) begin
+            if (DIR[n] != last_dir[n]) begin
+                dir_age[n] = 0;
+            end else begin
+                dir_age[n] = dir_age[n] + 1;
+            end
+            if (STP[n] != last_stp[n]) begin
+                if (dir_age[n] < 3) begin
+                    $display("ERROR: joint%0d step %0d clocks after dir change", n, dir_age[n]);
+                    errors = errors + 1;
+                end
+                if (!STP[n]) begin
+                    counted[n] = counted[n] + (DIR[n] ? 1 : -1);
+                end
+            end
+        end
+        last_stp = STP;
+        last_dir = DIR;
+    end
+
+    task check;
+        input integer tolerance;
+        input integer tolerance2;
+        integer diff;
+        begin
+            for (n = 0; n < 3; n = n + 1) begin
+                if ($signed(feedback[n*32+:32]) != counted[n]) begin
+                    $display("ERROR: joint%0d feedback %0d != counted steps %0d", n, $signed(feedback[n*32+:32]), counted[n]);
+                    errors = errors + 1;
+                end
+            end
+            diff = $signed(feedback[31:0]) - ref0;
+            if (diff > tolerance || diff < -tolerance) begin
+                $display("ERROR: joint0 %0d != joint_stepper %0d", $signed(feedback[31:0]), ref0);
+                errors = errors + 1;
+            end
+            diff = $signed(feedback[63:32]) - ref1;
+            if (diff > tolerance || diff < -tolerance) begin
+                $display("ERROR: joint1 %0d != joint_stepper %0d", $signed(feedback[63:32]), ref1);
+                errors = errors + 1;
+            end
+            diff = $signed(feedback[95:64]) - ref2;
+            if (diff > tolerance2 || diff < -tolerance2) begin
+                $display("ERROR: joint2 %0d != joint_stepper %0d", $signed(feedback[95:64]), ref2);
+                errors = errors + 1;
+            end
+            $display("feedback: %0d %0d %0d (joint_stepper: %0d %0d %0d)",
+                $signed(feedback[31:0]), $signed(feedback[63:32]), $signed(feedback[95:64]), ref0, ref1, ref2);
+        end
+    endtask
+
+    initial begin
+        $dumpfile("testb.vcd");
+        $dumpvars(0, testb);
+
+        # 200000
+        check(1, 1);
+        cmd0 = -7;
+        cmd1 = 100;
+        cmd2 = 3;
+        # 200000
+        check(2, 2);
+        // faster than the mux can step: limited to one edge per visit
+        cmd2 = 1;
+        # 100000
+        check(2, 100000);
+        jointEnable = 3'b000;
+        # 100000
+        check(3, 100000);
+
+        if (errors == 0) begin
+            $display("OK");
+        end else begin
+            $display("FAILED: %0d errors", errors);
+        end
+        $finish;
+    end
+
+endmodule
@@ -1,3 +1,36 @@
+# continuous mode: data rates (SPS) of the ads1115 (rate code = index)
+DATA_RATES = (8, 16, 32, 64, 128, 250, 475, 860)
+
+# host side conversions (rio_convert.h)
+CONVERT_ADC = [
+    "value /= 1000.0; // to Volt",
+    "value += *(data->processVariableOffset[i]);",
+    "value *= *(data->processVariableScale[i]);",
+    "*(data->processVariable[i]) = value;",
+    "*(data->processVariableS32[i]) = (int)(value * 100); // to mV",
+]
+
+CONVERT_NTC = [
+    "value /= 1000.0;",
+    "float Rt = 10.0 * value / (3.3 - value);",
+    "float tempK = 1.0 / (log(Rt / 10.0) / 3950.0 + 1.0 / (273.15 + 25.0));",
+    "value = tempK - 273.15;",
+    "value += *(data->processVariableOffset[i]);",
+    "value *= *(data->processVariableScale[i]);",
+    "*(data->processVariable[i]) = value;",
+    "*(data->processVariableS32[i]) = (int)(value);",
+]
+
+# continuous mode: the sample count (bits 16-23) to the -seq pin, the values are never negative
+CONVERT_SEQ = [
+    "int32_t raw = (int32_t)value;",
+    "if (raw > 0) {",
+    "    *(data->processVariableExtra[i][0]) = raw >> 16;",
+    "    value = raw & 0xFFFF;",
+    "}",
+]
+
+
 class Plugin:
     ptype = "vin_ads1115"
 
@@ -34,12 +67,78 @@ class Plugin:
                                 "type": "output",
                                 "name": "output pin SCL",
                             },
+                            "alert": {
+                                "type": "input",
+                                "name": "input pin ALERT/RDY (continuous mode)",
+                            },
                         },
                     },
+                    "mode": {
+                        "type": "str",
+                        "name": "conversion mode",
+                        "comment": "single or continuous (needs the ALERT/RDY pin)",
+                        "default": "single",
+                    },
+                    "rate": {
+                        "type": "int",
+                        "name": "data rate",
+                        "comment": "samples per second in continuous mode (8-860)",
+                        "default": "860",
+                    },
+                    "average": {
+                        "type": "int",
+                        "name": "average",
+                        "comment": "averaged conversions per sample in continuous mode (1, 2, 4, 8, 16)",
+                        "default": "1",
+                    },
+                    "channels": {
+                        "type": "str",
+                        "name": "channels",
+                        "comment": "scanned channels, comma separated (0-3, default: all)",
+                        "default": "",
+                    },
                 },
             }
         ]
 
+    def channels(self, data):
+        channels = data.get("channels") or range(4)
+        if isinstance(channels, str):
+            channels = channels.split(",")
+        return [int(channel) for channel in channels]
+
+    def continuous(self, data):
+        return data.get("mode", "single") == "continuous"
+
+    def errors(self):
+        errors = []
+        for num, data in enumerate(self.jdata["plugins"]):
+            if data.get("type") == self.ptype:
+                name = data.get("name", f"PV.{num}")
+                try:
+                    channels = self.channels(data)
+                except ValueError:
+                    channels = None
+                if not channels or len(set(channels)) != len(channels) or not all(0 <= channel <= 3 for channel in channels):
+                    errors.append(f"vin_ads1115 '{name}': invalid channels: {data.get('channels')} (0-3)")
+                if self.continuous(data):
+                    if "alert" not in data["pins"]:
+                        errors.append(f"vin_ads1115 '{name}': continuous mode needs the alert pin")
+                    if int(data.get("average", 1)) not in (1, 2, 4, 8, 16):
+                        errors.append(f"vin_ads1115 '{name}': average must be 1, 2, 4, 8 or 16: {data['average']}")
+        return errors
+
+    def prefixes(self, num, data):
+        name = data.get("name", f"PV.{num}")
+        nameIntern = name.replace(".", "").replace("-", "_").upper()
+        names = data.get("names", data.get("name"))
+        prefixes = {}
+        for vnum in self.channels(data):
+            prefixes[vnum] = f"{nameIntern}_{vnum}"
+            if isinstance(names, list):
+                prefixes[vnum] = (names[vnum] or f"PV.{num}.{vnum}").replace(".", "").replace("-", "_").upper()
+        return prefixes
+
     def pinlist(self):
         pinlist_out = []
         for num, data in enumerate(self.jdata["plugins"]):
@@ -51,6 +150,10 @@ class Plugin:
                 pinlist_out.append(
                     (f"VIN{num}_SCL", data["pins"]["scl"], "OUTPUT", pullup)
                 )
+                if self.continuous(data) and "alert" in data["pins"]:
+                    pinlist_out.append(
+                        (f"VIN{num}_ALERT", data["pins"]["alert"], "INPUT", True)
+                    )
         return pinlist_out
 
     def vinnames(self):
@@ -67,8 +170,13 @@ class Plugin:
                 scales = data.get("scales", data.get("scale"))
                 offsets = data.get("offsets", data.get("offset"))
 
-                for vnum in range(4):
+                continuous = self.continuous(data)
+                if continuous and data.get("fixed"):
+                    print(f"WARNING: vin_ads1115 '{name}': no gateware scaling in continuous mode (sample count), using raw values")
+                for vnum in self.channels(data):
                     data_copy = data.copy()
+                    if continuous:
+                        data_copy.pop("fixed", None)
                     data_copy["_name"] = f"{name}.{vnum}"
                     data_copy["_prefix"] = f"{nameIntern}_{vnum}"
                     if isinstance(functions, list):
@@ -90,20 +198,35 @@ class Plugin:
 
         return ret
 
+    def vin_convert(self):
+        return {
+            "adc": CONVERT_ADC,
+            "ntc": CONVERT_NTC,
+            "adc_seq": CONVERT_SEQ + CONVERT_ADC,
+            "ntc_seq": CONVERT_SEQ + CONVERT_NTC,
+        }
+
     def funcs(self):
         func_out = []
         for num, data in enumerate(self.jdata["plugins"]):
             if data.get("type") == self.ptype:
-                name = data.get("name", f"PV.{num}")
-                nameIntern = name.replace(".", "").replace("-", "_").upper()
-                func_out.append(f"    vin_ads1115 vin_ads1115{num} (")
+                prefixes = self.prefixes(num, data)
+                if self.continuous(data):
+                    mask = sum(1 << vnum for vnum in prefixes)
+                    rate = DATA_RATES.index(min(DATA_RATES, key=lambda value: abs(value - int(data.get("rate", 860)))))
+                    average = int(data.get("average", 1)).bit_length() - 1
+                    func_out.append(
+                        f"    vin_ads1115_cont #(.CHANNELS(4'b{mask:04b}), .DATA_RATE(3'd{rate}), .AVERAGE({average})) vin_ads1115{num} ("
+                    )
+                else:
+                    func_out.append(f"    vin_ads1115 vin_ads1115{num} (")
                 func_out.append("        .clk (sysclk),")
                 func_out.append(f"        .i2cSda (VIN{num}_SDA),")
                 func_out.append(f"        .i2cScl (VIN{num}_SCL),")
-                func_out.append(f"        .adc0 ({nameIntern}_0),")
-                func_out.append(f"        .adc1 ({nameIntern}_1),")
-                func_out.append(f"        .adc2 ({nameIntern}_2),")
-                func_out.append(f"        .adc3 ({nameIntern}_3)")
+                if self.continuous(data):
+                    func_out.append(f"        .alert (VIN{num}_ALERT),")
+                ports = [f".adc{vnum} ({prefixes.get(vnum, '')})" for vnum in range(4)]
+                func_out.append(f"        {f',{chr(10)}        '.join(ports)}")
                 func_out.append("    );")
         return func_out
 
@@ -96,6 +96,170 @@ endmodule
 
 
 
+// continuous conversion, the ALERT/RDY pin signals the end of each conversion (no polling)
+//   CHANNELS: bit mask of the scanned channels, DATA_RATE: rate code (0: 8SPS .. 7: 860SPS)
+//   AVERAGE: 2^AVERAGE conversions of a channel are averaged before the next channel
+//   after a channel switch, the first conversion is dropped (started with the old channel)
+//   adcN: {8'd0, sample count[7:0], 4'd0, value[11:0] (mV)}
+module vin_ads1115_cont
+    #(parameter CHANNELS=4'b1111, parameter DATA_RATE=3'd7, parameter AVERAGE=0, parameter ADDRESS=7'b1001001)
+    (
+        input clk,
+        inout i2cSda,
+        output i2cScl,
+        input alert,
+        output reg [31:0] adc0 = 0,
+        output reg [31:0] adc1 = 0,
+        output reg [31:0] adc2 = 0,
+        output reg [31:0] adc3 = 0
+    );
+
+    localparam INST_START_TX = 0;
+    localparam INST_STOP_TX = 1;
+    localparam INST_READ_BYTE = 2;
+    localparam INST_WRITE_BYTE = 3;
+
+    // steps: 0-11 thresholds (conversion ready mode), 12-21 config + pointer,
+    //        22 wait for ready, 23-27 read conversion, 28 sample, 29 next channel
+    localparam STEP_CONFIG = 5'd12;
+    localparam STEP_CONFIG_DONE = 5'd17;
+    localparam STEP_WAIT = 5'd22;
+    localparam STEP_READ_HI = 5'd25;
+    localparam STEP_READ_LO = 5'd26;
+    localparam STEP_SAMPLE = 5'd28;
+    localparam STEP_NEXT = 5'd29;
+
+    localparam SINGLE = (CHANNELS == 4'b0001 || CHANNELS == 4'b0010 || CHANNELS == 4'b0100 || CHANNELS == 4'b1000);
+    localparam FIRST = CHANNELS[0] ? 2'd0 : CHANNELS[1] ? 2'd1 : CHANNELS[2] ? 2'd2 : 2'd3;
+
+    reg [1:0] i2cInstruction = 0;
+    reg [7:0] i2cByteToSend = 0;
+    wire [7:0] i2cByteReceived;
+    wire i2cComplete;
+    reg i2cEnable = 0;
+    wire sdaIn;
+    wire sdaOut;
+    wire isSending;
+    assign i2cSda = (isSending & ~sdaOut) ? 1'b0 : 1'bz;
+    assign sdaIn = i2cSda ? 1'b1 : 1'b0;
+
+    ads1115_i2c i2c(
+        clk,
+        sdaIn,
+        sdaOut,
+        isSending,
+        i2cScl,
+        i2cInstruction,
+        i2cEnable,
+        i2cByteToSend,
+        i2cByteReceived,
+        i2cComplete
+    );
+
+    // ALERT/RDY (open drain, active low pulse)
+    reg [2:0] alertR = 3'b111;
+    always @(posedge clk) alertR <= {alertR[1:0], alert};
+    wire alert_fall = (alertR[2:1] == 2'b10);
+
+    reg [4:0] step = 0;
+    reg [1:0] channel = FIRST;
+    wire [1:0] channel_next = channel + 2'd1;
+    reg busy = 0;
+    reg started = 0;
+    reg ready = 0;
+    reg drop = 0;
+    reg [7:0] data_hi = 0;
+    reg [7:0] data_lo = 0;
+    reg [4:0] count = 0;
+    reg signed [23:0] sum = 0;
+    wire signed [23:0] sum_next = sum + $signed({data_hi, data_lo});
+    wire signed [23:0] average = sum_next >>> AVERAGE;
+    wire [11:0] value = average[15] ? 12'd0 : average[14:3];
+
+    reg [1:0] op;
+    reg [7:0] op_byte;
+    always @(*) begin
+        op = INST_WRITE_BYTE;
+        op_byte = 8'd0;
+        case (step)
+            5'd0, 5'd6, 5'd12, 5'd18, 5'd23: op = INST_START_TX;
+            5'd5, 5'd11, 5'd17, 5'd21, 5'd27: op = INST_STOP_TX;
+            5'd25, 5'd26: op = INST_READ_BYTE;
+            5'd1, 5'd7, 5'd13, 5'd19: op_byte = {ADDRESS, 1'b0};
+            5'd24: op_byte = {ADDRESS, 1'b1};
+            5'd2: op_byte = 8'h02; // Lo_thresh = 0x0000
+            5'd8: op_byte = 8'h03; // Hi_thresh = 0x8000
+            5'd9: op_byte = 8'h80;
+            5'd14: op_byte = 8'h01; // config
+            5'd15: op_byte = {1'b0, 1'b1, channel, 3'b001, 1'b0}; // single ended, +-4.096V, continuous
+            5'd16: op_byte = {DATA_RATE, 5'b00000}; // ready after each conversion, active low
+            default: op_byte = 8'h00; // Lo_thresh bytes, Hi_thresh lsb, pointer to the conversion register
+        endcase
+    end
+
+    always @(posedge clk) begin
+        if (busy) begin
+            if (~started && ~i2cComplete) begin
+                started <= 1;
+            end else if (i2cComplete && started) begin
+                started <= 0;
+                busy <= 0;
+                i2cEnable <= 0;
+                if (step == STEP_READ_HI) begin
+                    data_hi <= i2cByteReceived;
+                end else if (step == STEP_READ_LO) begin
+                    data_lo <= i2cByteReceived;
+                end else if (step == STEP_CONFIG_DONE) begin
+                    // the running conversion still uses the old channel
+                    ready <= 0;
+                    drop <= 1;
+                end
+                step <= step + 5'd1;
+            end
+        end else if (step == STEP_WAIT) begin
+            if (ready) begin
+                ready <= 0;
+                if (drop) begin
+                    drop <= 0;
+                end else begin
+                    step <= step + 5'd1;
+                end
+            end
+        end else if (step == STEP_SAMPLE) begin
+            if (count == (1 << AVERAGE) - 1) begin
+                case (channel)
+                    2'd0: adc0 <= {8'd0, adc0[23:16] + 8'd1, 4'd0, value};
+                    2'd1: adc1 <= {8'd0, adc1[23:16] + 8'd1, 4'd0, value};
+                    2'd2: adc2 <= {8'd0, adc2[23:16] + 8'd1, 4'd0, value};
+                    2'd3: adc3 <= {8'd0, adc3[23:16] + 8'd1, 4'd0, value};
+                endcase
+                sum <= 0;
+                count <= 0;
+                step <= SINGLE ? STEP_WAIT : STEP_NEXT;
+            end else begin
+                sum <= sum_next;
+                count <= count + 5'd1;
+                step <= STEP_WAIT;
+            end
+        end else if (step == STEP_NEXT) begin
+            channel <= channel_next;
+            if (CHANNELS[channel_next]) begin
+                step <= STEP_CONFIG;
+            end
+        end else begin
+            i2cInstruction <= op;
+            i2cByteToSend <= op_byte;
+            i2cEnable <= 1;
+            busy <= 1;
+        end
+        // last assignment, a ready pulse is never lost
+        if (alert_fall) begin
+            ready <= 1;
+        end
+    end
+endmodule
+
+
 module ads1115_i2c (
         input clk,
         input sdaIn,
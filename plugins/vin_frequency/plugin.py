@@ -60,6 +60,19 @@ class Plugin:
                 ret.append(data)
         return ret
 
+    def vin_convert(self):
+        return {
+            "frequency": [
+                "if (value != 0) {",
+                "    value = (float)PRU_OSC / value;",
+                "}",
+                "value += *(data->processVariableOffset[i]);",
+                "value *= *(data->processVariableScale[i]);",
+                "*(data->processVariable[i]) = value;",
+                "*(data->processVariableS32[i]) = (int)value;",
+            ],
+        }
+
     def funcs(self):
         ret = []
         for num, data in enumerate(self.jdata["plugins"]):
@@ -56,6 +56,19 @@ class Plugin:
                 ret.append(data)
         return ret
 
+    def vin_convert(self):
+        return {
+            "time": [
+                "if (value != 0) {",
+                "    value = 1000.0 / ((float)PRU_OSC / value);",
+                "}",
+                "value += *(data->processVariableOffset[i]);",
+                "value *= *(data->processVariableScale[i]);",
+                "*(data->processVariable[i]) = value;",
+                "*(data->processVariableS32[i]) = (int)value;",
+            ],
+        }
+
     def funcs(self):
         func_out = []
         for num, data in enumerate(self.jdata["plugins"]):
@@ -74,6 +74,20 @@ class Plugin:
                 ret.append(data)
         return ret
 
+    def vin_convert(self):
+        return {
+            "encoder": [
+                "value += *(data->processVariableOffset[i]);",
+                "value /= *(data->processVariableScale[i]);",
+                "*(data->processVariable[i]) = value;",
+                "*(data->processVariableS32[i]) = (int)value;",
+                "// calc RPM",
+                "float last = *(data->processVariableExtra[i][1]);",
+                "*(data->processVariableExtra[i][0]) = (value - last) * (1000000000.0 / (float)duration) * 60;",
+                "*(data->processVariableExtra[i][1]) = value;",
+            ],
+        }
+
     def funcs(self):
         func_out = []
         for num, data in enumerate(self.jdata["plugins"]):
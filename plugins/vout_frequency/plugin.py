@@ -49,6 +49,13 @@ class Plugin:
                 ret.append(data)
         return ret
 
+    def vout_convert(self):
+        return {
+            "frequency": [
+                "return value;",
+            ],
+        }
+
     def funcs(self):
         func_out = []
         for num, data in enumerate(self.jdata["plugins"]):
@@ -1,3 +1,6 @@
+import frameio
+
+
 class Plugin:
     ptype = "vout_pwm"
 
@@ -28,6 +31,12 @@ class Plugin:
                         "comment": "pwm frequency in Hz",
                         "default": "10000",
                     },
+                    "hires": {
+                        "type": "bool",
+                        "name": "high resolution",
+                        "default": False,
+                        "comment": "dithers the fractional part of the duty over the pwm periods",
+                    },
                     "invert_pwm": {
                         "type": "bool",
                         "name": "inverted pwm pin",
@@ -97,6 +106,47 @@ class Plugin:
                     )
         return func_out
 
+    def vout_convert(self):
+        return {
+            "pwm": [
+                "if (value > vout_max[i]) {",
+                "    value = vout_max[i];",
+                "}",
+                "if (value < vout_min[i]) {",
+                "    value = vout_min[i];",
+                "}",
+                "return (value - vout_min[i]) * (PRU_OSC / vout_freq[i]) / (vout_max[i] - vout_min[i]);",
+            ],
+            "pwmdir": [
+                "if (value > vout_max[i]) {",
+                "    value = vout_max[i];",
+                "}",
+                "if (value < -vout_max[i]) {",
+                "    value = -vout_max[i];",
+                "}",
+                "return (value) * (PRU_OSC / vout_freq[i]) / (vout_max[i]);",
+            ],
+            # duty in clock cycles with PWM_HIRES_FRAC fractional bits (vout_pwm_hires)
+            "pwm_hires": [
+                "if (value > vout_max[i]) {",
+                "    value = vout_max[i];",
+                "}",
+                "if (value < vout_min[i]) {",
+                "    value = vout_min[i];",
+                "}",
+                "return floor((double)(value - vout_min[i]) * ((double)PRU_OSC / vout_freq[i]) * (1 << PWM_HIRES_FRAC) / (vout_max[i] - vout_min[i]) + 0.5);",
+            ],
+            "pwmdir_hires": [
+                "if (value > vout_max[i]) {",
+                "    value = vout_max[i];",
+                "}",
+                "if (value < -vout_max[i]) {",
+                "    value = -vout_max[i];",
+                "}",
+                "return floor((double)value * ((double)PRU_OSC / vout_freq[i]) * (1 << PWM_HIRES_FRAC) / vout_max[i] + 0.5);",
+            ],
+        }
+
     def funcs(self):
         func_out = []
         for num, data in enumerate(self.jdata["plugins"]):
@@ -108,12 +158,19 @@ class Plugin:
                 else:
                     freq = int(data.get("frequency", 10000))
                 divider = int(self.jdata["clock"]["speed"]) // freq
+                module = "vout_pwm"
+                if data.get("hires"):
+                    module = "vout_pwm_hires"
+                    # the duty word (31 bits) holds the divider and the fractional bits
+                    if divider >= (1 << (31 - frameio.PWM_HIRES_FRAC)):
+                        print(f"ERROR: vout_pwm '{name}': the frequency is too low for the hires mode (min: {int(self.jdata['clock']['speed']) >> (31 - frameio.PWM_HIRES_FRAC)}Hz)")
+                        exit(1)
                 invert_pwm = data.get("invert_pwm", False)
                 if invert_pwm:
                     func_out.append(
                         f"    assign VOUT{num}_PWM_PWM = ~VOUT{num}_PWM_PWM_INVERTED; // invert pwm output"
                     )
-                func_out.append(f"    vout_pwm #({divider}) vout_pwm{num} (")
+                func_out.append(f"    {module} #({divider}) vout_pwm{num} (")
                 func_out.append("        .clk (sysclk),")
                 func_out.append(f"        .dty ({nameIntern}),")
                 func_out.append("        .disabled (ERROR),")
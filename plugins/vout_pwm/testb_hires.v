@@ -0,0 +1,73 @@
+`timescale 1ns/100ps
+
+// self-checking testbench for vout_pwm_hires: counts the high clocks over 2^FRAC pwm periods,
+// the sum must be the duty word (integer part * 2^FRAC + fractional part)
+module testb;
+    reg clk = 0;
+    always #2 clk = !clk;
+
+    parameter DIVIDER = 20;
+    parameter FRAC = 4;
+
+    reg signed [31:0] dty = 0;
+    reg disabled = 0;
+    wire DIR;
+    wire PWM;
+
+    integer high = 0;
+    integer errors = 0;
+    integer n;
+
+    task measure;
+        input signed [31:0] value;
+        input integer expected;
+        begin
+            dty = value;
+            // the new duty is taken over at the next period
+            repeat (DIVIDER * 2) @(posedge clk);
+            @(negedge clk);
+            while (vout_pwm1.counter != 0) @(negedge clk);
+            high = 0;
+            for (n = 0; n < DIVIDER * (1 << FRAC); n = n + 1) begin
+                @(negedge clk);
+                if (PWM) high = high + 1;
+            end
+            if (high != expected) begin
+                $display("ERROR: dty %0d: %0d high clocks (expected: %0d)", value, high, expected);
+                errors = errors + 1;
+            end
+        end
+    endtask
+
+    initial begin
+        $dumpfile("testb_hires.vcd");
+        $dumpvars(0, testb);
+
+        measure(32'd0, 0);
+        measure(7 * 16 + 5, 7 * 16 + 5);
+        measure(1, 1);
+        measure(DIVIDER * 16, DIVIDER * 16);
+        measure(-(3 * 16 + 15), 3 * 16 + 15);
+        if (DIR) begin
+            $display("ERROR: dir for a negative duty");
+            errors = errors + 1;
+        end
+        disabled = 1;
+        measure(7 * 16 + 5, 0);
+
+        if (errors == 0) begin
+            $display("OK");
+        end else begin
+            $display("FAILED: %0d errors", errors);
+        end
+        $finish;
+    end
+
+    vout_pwm_hires #(DIVIDER, FRAC) vout_pwm1 (
+        .clk (clk),
+        .dty (dty),
+        .disabled (disabled),
+        .dir (DIR),
+        .pwm (PWM)
+    );
+endmodule
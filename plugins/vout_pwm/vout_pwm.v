@@ -37,3 +37,44 @@ module vout_pwm
         end
     end
 endmodule
+
+// high resolution pwm: dty is the duty in clock cycles with FRAC fractional bits,
+//   the fractional part is dithered over the pwm periods (first order error feedback),
+//   the average duty of 2^FRAC periods is exact
+module vout_pwm_hires
+    #(parameter divider = 255, parameter FRAC = 16)
+     (
+         input clk,
+         input signed [31:0] dty,
+         input disabled,
+         output dir,
+         output pwm
+     );
+    reg [31:0] dtyAbs = 32'd0;
+    reg direction = 0;
+    assign dir = direction;
+    reg [31:0] counter = 0;
+    reg [FRAC-1:0] residue = 0;
+    reg [31:0] duty = 0;
+    reg pulse = 0;
+    assign pwm = pulse;
+    wire [FRAC:0] residue_next = residue + dtyAbs[FRAC-1:0];
+    always @ (posedge clk) begin
+        if (dty > 0) begin
+            dtyAbs <= dty;
+            direction <= 1;
+        end else begin
+            dtyAbs <= -dty;
+            direction <= 0;
+        end
+        if (counter >= divider - 1) begin
+            counter <= 0;
+            // the carry of the fractional part extends this period by one clock
+            residue <= residue_next[FRAC-1:0];
+            duty <= (dtyAbs >> FRAC) + residue_next[FRAC];
+        end else begin
+            counter <= counter + 1;
+        end
+        pulse <= !disabled && (counter < duty);
+    end
+endmodule
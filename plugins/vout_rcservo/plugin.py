@@ -76,6 +76,13 @@ class Plugin:
                     )
         return func_out
 
+    def vout_convert(self):
+        return {
+            "rcservo": [
+                "return (value + RCSERVO_OFFSET) * (PRU_OSC / RCSERVO_DIVIDER);",
+            ],
+        }
+
     def funcs(self):
         func_out = []
         for num, data in enumerate(self.jdata["plugins"]):
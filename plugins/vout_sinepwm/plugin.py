@@ -52,6 +52,13 @@ class Plugin:
                 ret.append(data)
         return ret
 
+    def vout_convert(self):
+        return {
+            "sine": [
+                "return PRU_OSC / value / vout_freq[i];",
+            ],
+        }
+
     def funcs(self):
         func_out = []
         for num, data in enumerate(self.jdata["plugins"]):
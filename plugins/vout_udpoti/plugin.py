@@ -76,6 +76,13 @@ class Plugin:
                 ret.append(data)
         return ret
 
+    def vout_convert(self):
+        return {
+            "udpoti": [
+                "return value;",
+            ],
+        }
+
     def funcs(self):
         func_out = []
         for num, data in enumerate(self.jdata["plugins"]):
@@ -4,6 +4,10 @@ import json
 import os
 import sys
 
+import chipdb
+import timing
+from generators.firmware import pll
+
 
 def load(configfile):
     project = {}
@@ -76,6 +80,11 @@ def load(configfile):
             ("sysclk", project["jdata"]["clock"]["pin"], "INPUT", True),
         )
 
+    # pll: the achieved sysclk replaces clock: speed (PRU_OSC)
+    project["pll"] = None
+    if project["osc_clock"] and not project["internal_clock"]:
+        project["pll"] = pll.setup(project)
+
     if "blink" in project["jdata"]:
         project["pinlists"]["blink"] = (
             ("BLINK_LED", project["jdata"]["blink"]["pin"], "OUTPUT"),
@@ -97,22 +106,15 @@ def load(configfile):
         if hasattr(project["plugins"][plugin], "expansions"):
             project["expansions"][plugin] = project["plugins"][plugin].expansions()
 
-    # check for double assigned pins
-    double_pins = False
-    uniq_pins = {}
-    for pinlist in project["pinlists"].values():
-        for pinsetup in pinlist:
-            pin_name = pinsetup[0]
-            pin_id = pinsetup[1]
-            if pin_id in uniq_pins:
-                print()
-                print(f"ERROR: pin {pin_id} allready in use")
-                print(f"  old: {uniq_pins[pin_id]}")
-                print(f"  new: {pinsetup}")
-                double_pins = True
-            else:
-                uniq_pins[pin_id] = pinsetup
-    if double_pins:
+    # check for double assigned pins, set the auto pins (chipdb.py) and the options of the plugins
+    errors = chipdb.solve(project)
+    for plugin in project["plugins"]:
+        if hasattr(project["plugins"][plugin], "errors"):
+            errors += project["plugins"][plugin].errors()
+    if errors:
+        for error in errors:
+            print()
+            print(f"ERROR: {error}")
         print("")
         exit(1)
 
@@ -134,15 +136,106 @@ def load(configfile):
 
     project["joints_en_total"] = (project["joints"] + 7) // 8 * 8
 
+    # free running fpga timestamp in the answer frame (clock sync, see rio.c: dpll)
+    project["timestamp"] = bool(project["jdata"].get("timestamp", False))
+    # joint commands are applied at a given fpga tick (needs the timestamp)
+    project["apply_time"] = bool(project["jdata"].get("apply_time", False))
+    if project["apply_time"]:
+        project["timestamp"] = True
+
+    # sequence of events (din_soe): timestamped input edges in the answer frame (needs the timestamp)
+    project["soe"] = None
+    for plugin in project["plugins"]:
+        if hasattr(project["plugins"][plugin], "soe"):
+            soe = project["plugins"][plugin].soe()
+            if soe is not None:
+                din_names = [din["_name"] for din in project["dinnames"]]
+                for name in soe["inputs"]:
+                    if name not in din_names:
+                        print("")
+                        print(f"ERROR: soe: unknown input '{name}'")
+                        print("")
+                        exit(1)
+                soe["dins"] = [din_names.index(name) for name in soe["inputs"]]
+                project["soe"] = soe
+                project["timestamp"] = True
+
+    # multi-rate: vins with a "divisor" > 1 are not part of every answer frame,
+    # they share one slot that is selected by the host (see frameio.py: slow_schedule)
+    project["vins_slow"] = []
+    for num, vin in enumerate(project["vinnames"]):
+        if int(vin.get("divisor", 1)) > 1:
+            project["vins_slow"].append(num)
+    project["vins_fast"] = project["vins"] - len(project["vins_slow"])
+    slow_load = sum(1.0 / int(project["vinnames"][num]["divisor"]) for num in project["vins_slow"])
+    if slow_load > 1.0:
+        print(f"WARNING: the slow vins need {slow_load:0.2f} slots per frame, they are updated less often than configured")
+
+    # joints with a velocity command next to the position (joint_dcservo)
+    project["joints_velocity"] = []
+    for num, joint in enumerate(project["jointnames"]):
+        if joint.get("_velocity"):
+            project["joints_velocity"].append(num)
+
+    # joints that follow an encoder vin in the gateware (joint_stepper: gear)
+    project["joints_gear"] = []
+    vin_names = [vin["_name"] for vin in project["vinnames"]]
+    for num, joint in enumerate(project["jointnames"]):
+        if joint.get("_gear"):
+            if joint["_gear"] not in vin_names:
+                print("")
+                print(f"ERROR: gear: unknown encoder '{joint['_gear']}'")
+                print("")
+                exit(1)
+            project["joints_gear"].append({"joint": num, "vin": vin_names.index(joint["_gear"])})
+
     project["tx_data_size"] = 32
+    if project["timestamp"]:
+        project["tx_data_size"] += 32
     project["tx_data_size"] += project["joints"] * 32
-    project["tx_data_size"] += project["vins"] * 32
+    project["tx_data_size"] += project["vins_fast"] * 32
+    if project["vins_slow"]:
+        project["tx_data_size"] += 64
+    if project["soe"]:
+        project["tx_data_size"] += 32 + project["soe"]["slots"] * 64
     project["tx_data_size"] += project["dins_total"]
     project["rx_data_size"] = 32
+    if project["apply_time"]:
+        project["rx_data_size"] += 32
+    if project["vins_slow"]:
+        project["rx_data_size"] += 32
+    if project["soe"]:
+        project["rx_data_size"] += 32
     project["rx_data_size"] += project["joints"] * 32
+    project["rx_data_size"] += len(project["joints_velocity"]) * 32
+    project["rx_data_size"] += len(project["joints_gear"]) * 32
     project["rx_data_size"] += project["vouts"] * 32
     project["rx_data_size"] += project["joints_en_total"]
     project["rx_data_size"] += project["douts_total"]
     project["data_size"] = max(project["tx_data_size"], project["rx_data_size"])
 
+    # frame size limits of the interfaces (counters, ethernet mtu)
+    for plugin in project["plugins"]:
+        if hasattr(project["plugins"][plugin], "frame_limit"):
+            limit = project["plugins"][plugin].frame_limit()
+            if limit is not None and project["data_size"] // 8 > limit:
+                print("")
+                print(f"ERROR: frame size ({project['data_size'] // 8} bytes) is too big for {plugin} (max: {limit} bytes)")
+                print("")
+                exit(1)
+
+    try:
+        project["timing"] = timing.model(project)
+    except timing.TimingError as err:
+        print("")
+        print(f"ERROR: {err}")
+        print("")
+        exit(1)
+    for warning in project["timing"]["warnings"]:
+        print(f"WARNING: {warning}")
+
+    # the interface plugins are only seeing the jdata
+    for interface in project["jdata"].get("interface", []):
+        interface["_timeout"] = project["timing"]["timeout"]
+
     return project
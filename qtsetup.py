@@ -32,6 +32,8 @@ from PyQt5.QtWidgets import (
     QWidget,
 )
 
+import chipdb
+
 parser = argparse.ArgumentParser()
 parser.add_argument(
     "configfile", help="json config file", type=str, default=None
@@ -85,28 +87,14 @@ outputfiles = {
     "rio.h": "/tmp/qtsetup-temp/LinuxCNC/Components/rio.h",
 }
 
-if os.path.isfile(f"chipdata/{jdata['family']}.json"):
-    chiptype_mapping = {
-        "25k": "LFE5U-25F",
-        "up5k": "5k",
-        "hx1k": "1k",
-        "hx4k": "4k",
-        "hx8k": "8k",
-    }
-    print("try to load chipdata")
-    chipdata = json.loads(open(f"chipdata/{jdata['family']}.json").read())
-    ctype = chiptype_mapping.get(jdata["type"], jdata["type"])
-    package = jdata["package"]
-    if ctype in chipdata:
-        print(" type found:", ctype)
-        if package in chipdata[ctype]:
-            print(" package found:", package)
-            for pin in chipdata[ctype][package]:
-                pinlist[pin] = "IO"
-        else:
-            print(" package not found:", package)
-    else:
-        print(" type not found:", ctype)
+print("try to load chipdata")
+chip = chipdb.load(jdata)
+if chip is not None:
+    pinlist[chipdb.AUTO] = "IO"
+    for pin in chip.pins:
+        pinlist[pin] = "IO"
+else:
+    print(" package not found:", jdata.get("type"), jdata.get("package"))
 
 
 plugins = {}
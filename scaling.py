@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+#
+# scaling benchmark: frame size and cycle time for growing channel counts
+#
+# adds vins (vin_frequency) and digital i/o (din_bit/dout_bit, half/half) to a base config
+# and prints per step:
+#   the frame size, the transfer time of each transport (timing.py model),
+#   the servo period selected for the transport of the config (-: does not fit) and the host cycle time
+#   measured against the frame level emulator (build, emulate, parse)
+#
+#   python3 scaling.py tests/data/tangnano9k_1/config.json
+#   python3 scaling.py configs/TangNano9K/config.json --steps 8:64,64:256,256:1024 --frames 200
+#
+
+import argparse
+import copy
+import json
+import os
+import tempfile
+import time
+
+import emulator
+import frameio
+import projectLoader
+import timing
+
+STEPS = ((8, 64), (32, 128), (64, 256), (128, 512), (256, 1024))
+
+
+def scaled_jdata(jdata, vins, dio):
+    jdata = copy.deepcopy(jdata)
+    # the servo period is selected here (timing_model), the loader should only check the frame limits
+    jdata["timing"] = dict(jdata.get("timing", {}), max_load=1000000.0)
+    jdata.get("timing", {}).pop("servo_period", None)
+    for num in range(vins):
+        jdata["plugins"].append({"type": "vin_frequency", "name": f"SCALE_VIN{num}", "pin": f"SCALE_VIN{num}"})
+    for num in range(dio // 2):
+        jdata["plugins"].append({"type": "din_bit", "name": f"SCALE_DIN{num}", "pin": f"SCALE_DIN{num}"})
+        jdata["plugins"].append({"type": "dout_bit", "name": f"SCALE_DOUT{num}", "pin": f"SCALE_DOUT{num}"})
+    return jdata
+
+
+def load(jdata):
+    # projectLoader reads a file and exits on errors (frame limits, timing)
+    with tempfile.TemporaryDirectory() as tmpdir:
+        configfile = os.path.join(tmpdir, "config.json")
+        with open(configfile, "w") as ofile:
+            json.dump(jdata, ofile)
+        try:
+            return projectLoader.load(configfile), None
+        except SystemExit:
+            return None, "rejected by projectLoader (frame limits)"
+
+
+def transfer_times(project):
+    times = {}
+    for name, transport, interface in (
+        ("spi", "SPI", None),
+        ("serial", "SERIAL", {"type": "uart", "baud": 1000000}),
+        ("udp", "UDP", {"type": "udp"}),
+    ):
+        jdata = dict(project["jdata"], transport=transport)
+        if interface:
+            jdata["interface"] = [interface]
+        times[name] = timing.transfer_time(dict(project, jdata=jdata))
+    return times
+
+
+def host_cycle(layout, frames):
+    frame = frameio.Frame(layout)
+    emu = emulator.Emulator(layout)
+    joints = [100.0] * len(layout["joints"])
+    vouts = [0.0] * len(layout["vouts"])
+    enables = [1] * len(layout["joints"])
+    douts = [num % 2 for num in range(len(layout["douts"]))]
+    start = time.perf_counter()
+    for num in range(frames):
+        data = frame.build(joints, vouts, enables, douts)
+        frame.parse(emu.transfer(data, now=num * 0.001))
+    return (time.perf_counter() - start) / frames
+
+
+def run(jdata, steps=STEPS, frames=100):
+    rows = []
+    for vins, dio in steps:
+        row = {"vins": vins, "dio": dio}
+        project, error = load(scaled_jdata(jdata, vins, dio))
+        if project is None:
+            row["error"] = error
+            rows.append(row)
+            continue
+        layout = frameio.layout(project)
+        row["bytes"] = layout["size"]
+        row["transfer"] = transfer_times(project)
+        try:
+            row["servo_period"] = timing.model(dict(project, jdata=dict(project["jdata"], timing=jdata.get("timing", {}))))["servo_period"]
+        except timing.TimingError:
+            row["servo_period"] = None
+        row["host"] = host_cycle(layout, frames)
+        rows.append(row)
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description="rio scaling benchmark")
+    parser.add_argument("config", help="base config.json")
+    parser.add_argument("--steps", help="VINS:DIO,... (default: 8:64,32:128,64:256,128:512,256:1024)")
+    parser.add_argument("--frames", type=int, default=100, help="emulated frames per step")
+    args = parser.parse_args()
+
+    steps = STEPS
+    if args.steps:
+        steps = [tuple(int(value) for value in step.split(":")) for step in args.steps.split(",")]
+
+    with open(args.config, "r") as ifile:
+        jdata = json.load(ifile)
+
+    rows = run(jdata, steps, args.frames)
+    print("")
+    print(f"{'vins':>5} {'dio':>5} {'bytes':>6} {'spi':>9} {'serial':>9} {'udp':>9} {'period':>7} {'host':>9}")
+    for row in rows:
+        if "error" in row:
+            print(f"{row['vins']:5d} {row['dio']:5d}  {row['error']}")
+            continue
+        transfer = row["transfer"]
+        period = f"{row['servo_period'] // 1000}us" if row["servo_period"] else "-"
+        print(
+            f"{row['vins']:5d} {row['dio']:5d} {row['bytes']:6d}"
+            f" {transfer['spi'] * 1000000:7.0f}us {transfer['serial'] * 1000000:7.0f}us {transfer['udp'] * 1000000:7.0f}us"
+            f" {period:>7} {row['host'] * 1000000:7.1f}us"
+        )
+
+
+if __name__ == "__main__":
+    main()
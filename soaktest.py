@@ -0,0 +1,356 @@
+#!/usr/bin/env python3
+#
+# headless load generator / soak-test for boards and bridges
+#
+# exchanges frames at a fixed rate, runs output patterns and checks the feedback:
+#
+#   python3 soaktest.py configs/TangNano9K/config.json --udp 192.168.10.194 --rate 1000 --duration 3600
+#   python3 soaktest.py Output/TangNano9K/LinuxCNC/Components/rio-layout.json --spi 0.1
+#   python3 soaktest.py configs/TangNano9K/config.json --emulator --loopback
+#
+
+import argparse
+import json
+import math
+import socket
+import sys
+import time
+
+import frameio
+
+LATENCY_BUCKETS = (50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000)
+
+
+class UdpTransport:
+    def __init__(self, target, timeout):
+        host, _, port = target.partition(":")
+        self.address = (host, int(port or 2390))
+        self.timeout = timeout
+        self.sock = socket.socket(family=socket.AF_INET, type=socket.SOCK_DGRAM)
+        self.sock.settimeout(timeout)
+
+    def transfer(self, data):
+        # drop late answers of the previous frames
+        self.sock.setblocking(False)
+        try:
+            while True:
+                self.sock.recv(1500)
+        except (BlockingIOError, socket.timeout):
+            pass
+        self.sock.settimeout(self.timeout)
+        self.sock.sendto(data, self.address)
+        try:
+            return self.sock.recv(1500)
+        except socket.timeout:
+            return None
+
+
+class SerialTransport:
+    def __init__(self, device, timeout, baud=2000000):
+        import serial
+
+        self.ser = serial.Serial(device, baud, timeout=timeout)
+
+    def transfer(self, data):
+        self.ser.reset_input_buffer()
+        self.ser.write(data)
+        answer = self.ser.read(len(data))
+        if len(answer) != len(data):
+            return None
+        return answer
+
+
+class SpiTransport:
+    def __init__(self, device, speed):
+        import spidev
+
+        bus, _, dev = device.partition(".")
+        self.spi = spidev.SpiDev()
+        self.spi.open(int(bus), int(dev or 0))
+        self.spi.max_speed_hz = speed
+        self.spi.mode = 0
+        self.spi.lsbfirst = False
+
+    def transfer(self, data):
+        return bytes(self.spi.xfer2(list(data)))
+
+
+class EmulatorTransport:
+    def __init__(self, layout):
+        import emulator
+
+        self.emulator = emulator.Emulator(layout)
+
+    def transfer(self, data):
+        return self.emulator.transfer(data)
+
+
+class Pattern:
+    """scripted output values: joint frequency sweeps, pwm ramps and walking dout bits"""
+
+    def __init__(self, layout, names, period, max_freq):
+        self.layout = layout
+        self.names = names
+        self.period = period
+        self.max_freq = max_freq
+
+    def joints(self, now):
+        if "sweep" not in self.names:
+            return [0.0] * len(self.layout["joints"])
+        freqs = []
+        for num, conv in enumerate(self.layout["joints"]):
+            phase = num / max(len(self.layout["joints"]), 1)
+            value = math.sin(2.0 * math.pi * (now / self.period + phase))
+            if conv["type"] == "pwmdir":
+                freqs.append(int(value * self.layout["clock"] / 10000))
+            else:
+                freqs.append(value * self.max_freq)
+        return freqs
+
+    def vouts(self, now):
+        values = []
+        for conv in self.layout["vouts"]:
+            if "ramp" not in self.names:
+                values.append(0)
+                continue
+            ramp = (now / self.period) % 1.0
+            vmin = -conv["max"] if conv["type"] in ("pwmdir", "pwmdir_hires") else conv["min"]
+            values.append(vmin + (conv["max"] - vmin) * ramp)
+        return values
+
+    def douts(self, now):
+        # like the dout_auto animation of qt-testgui.py
+        count = len(self.layout["douts"])
+        if "walk" not in self.names or count == 0:
+            return [0] * count
+        step = int(now / 0.05) % (count + 1)
+        return [int(num == step - 1) for num in range(count)]
+
+
+class Stats:
+    def __init__(self):
+        self.frames = 0
+        self.lost = 0
+        self.overruns = 0
+        self.mismatches = {}
+        self.histogram = [0] * (len(LATENCY_BUCKETS) + 1)
+        self.latency_min = None
+        self.latency_max = 0.0
+        self.latency_sum = 0.0
+
+    def latency(self, value):
+        usec = value * 1000000.0
+        for num, limit in enumerate(LATENCY_BUCKETS):
+            if usec < limit:
+                break
+        else:
+            num = len(LATENCY_BUCKETS)
+        self.histogram[num] += 1
+        self.latency_sum += usec
+        self.latency_max = max(self.latency_max, usec)
+        if self.latency_min is None or usec < self.latency_min:
+            self.latency_min = usec
+
+    def mismatch(self, name):
+        self.mismatches[name] = self.mismatches.get(name, 0) + 1
+
+    def summary(self):
+        received = self.frames - self.lost
+        return {
+            "frames": self.frames,
+            "lost": self.lost,
+            "overruns": self.overruns,
+            "mismatches": self.mismatches,
+            "latency_us": {
+                "min": round(self.latency_min or 0.0, 1),
+                "avg": round(self.latency_sum / received, 1) if received else 0.0,
+                "max": round(self.latency_max, 1),
+                "histogram": {
+                    f"<{limit}": count for limit, count in zip(LATENCY_BUCKETS, self.histogram)
+                } | {f">={LATENCY_BUCKETS[-1]}": self.histogram[-1]},
+            },
+        }
+
+    def print_histogram(self):
+        total = max(sum(self.histogram), 1)
+        lower = 0
+        for num, count in enumerate(self.histogram):
+            upper = LATENCY_BUCKETS[num] if num < len(LATENCY_BUCKETS) else None
+            label = f"{lower:>6}-{upper:<6}us" if upper else f"{lower:>6}+      us"
+            print(f"  {label} {count:>10} {'#' * int(50 * count / total)}")
+            lower = upper
+
+
+class Checker:
+    """compares the feedback with the values sent in the previous frame"""
+
+    def __init__(self, layout, loopback, tolerance):
+        self.layout = layout
+        self.osc = layout["clock"]
+        self.loopback = loopback
+        self.tolerance = tolerance
+        self.last = None
+
+    def check(self, stats, sent, parsed, now, latency):
+        if parsed["header"] != frameio.PRU_DATA:
+            stats.mismatch("header")
+            self.last = None
+            return
+
+        if self.last is not None:
+            last_sent, last_parsed, last_now = self.last
+            dt = now - last_now
+            for num, conv in enumerate(self.layout["joints"]):
+                if conv["type"] in ("pwmdir", "dcservo"):
+                    continue
+                freq = frameio.cmd_to_joint(conv, last_sent["jointFreqCmd"][num], self.osc)
+                expected = freq * dt
+                delta = (parsed["jointFeedback"][num] - last_parsed["jointFeedback"][num] + 0x80000000) % 0x100000000 - 0x80000000
+                # the sample point in the fpga moves with the transfer latency
+                slack = abs(expected) * self.tolerance + abs(freq) * latency * 2 + 2
+                if abs(delta - expected) > slack:
+                    stats.mismatch(f"joint{num}")
+
+            if self.loopback:
+                for num in range(min(len(self.layout["vouts"]), len(self.layout["vins"]))):
+                    # slow vins are only checked in the frame they are updated
+                    if parsed["vinsAge"][num] != 0:
+                        continue
+                    if parsed["vinsRaw"][num] != last_sent["setPoint"][num]:
+                        stats.mismatch(f"vin{num}")
+                for num in range(min(len(self.layout["douts"]), len(self.layout["dins"]))):
+                    if parsed["dins"][num] != last_sent["douts"][num]:
+                        stats.mismatch(f"din{num}")
+
+        self.last = (sent, parsed, now)
+
+
+def load_layout(filename):
+    jdata = json.loads(open(filename, "r").read())
+    if "tx" in jdata and "rx" in jdata:
+        return jdata
+    import projectLoader
+
+    return frameio.layout(projectLoader.load(filename))
+
+
+def run(layout, transport, rate=1000, duration=10.0, patterns=("sweep", "ramp", "walk"), period=2.0, max_freq=1000.0, loopback=False, tolerance=0.2, verbose=False):
+    frame = frameio.Frame(layout)
+    pattern = Pattern(layout, patterns, period, max_freq)
+    checker = Checker(layout, loopback, tolerance)
+    stats = Stats()
+    interval = 1.0 / rate
+
+    start = time.monotonic()
+    next_status = start + 1.0
+    deadline = start
+    while True:
+        now = time.monotonic()
+        if now - start >= duration:
+            break
+        if now < deadline:
+            if deadline - now > 0.001:
+                time.sleep(deadline - now - 0.0005)
+            while time.monotonic() < deadline:
+                pass
+        elif now - deadline > interval:
+            stats.overruns += 1
+            deadline = now
+        deadline += interval
+
+        now = time.monotonic() - start
+        joints = pattern.joints(now)
+        vouts = pattern.vouts(now)
+        douts = pattern.douts(now)
+        data = frame.build(joints, vouts, [1] * len(layout["joints"]), douts)
+        sent = {
+            "jointFreqCmd": [frameio.joint_to_cmd(conv, freq, frame.osc) for conv, freq in zip(layout["joints"], joints)],
+            "setPoint": [frameio.vout_to_setpoint(conv, value, frame.osc) for conv, value in zip(layout["vouts"], vouts)],
+            "douts": douts,
+        }
+
+        stats.frames += 1
+        t1 = time.monotonic()
+        answer = transport.transfer(data)
+        t2 = time.monotonic()
+        if answer is None or len(answer) < frame.size:
+            stats.lost += 1
+            checker.last = None
+            continue
+        stats.latency(t2 - t1)
+        checker.check(stats, sent, frame.parse(answer), t1 - start, t2 - t1)
+
+        if verbose and t2 >= next_status:
+            next_status += 1.0
+            print(f"{t2 - start:8.1f}s frames: {stats.frames} lost: {stats.lost} overruns: {stats.overruns} mismatches: {sum(stats.mismatches.values())}")
+
+    return stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description="rio soak-test")
+    parser.add_argument("layout", help="config.json or generated rio-layout.json")
+    transport = parser.add_mutually_exclusive_group(required=True)
+    transport.add_argument("--udp", help="IP[:PORT] of the board/bridge")
+    transport.add_argument("--serial", help="serial device (/dev/ttyUSB0)")
+    transport.add_argument("--spi", help="spidev BUS.DEVICE (0.1)")
+    transport.add_argument("--emulator", action="store_true", help="use the software emulator")
+    parser.add_argument("--baud", type=int, default=2000000, help="serial baudrate")
+    parser.add_argument("--speed", type=int, default=2000000, help="spi clock")
+    parser.add_argument("--rate", type=float, default=1000, help="frame rate in Hz (max 10000)")
+    parser.add_argument("--duration", type=float, default=10.0, help="duration in seconds")
+    parser.add_argument("--timeout", type=float, default=0.01, help="answer timeout in seconds")
+    parser.add_argument("--patterns", default="sweep,ramp,walk", help="comma separated list of sweep,ramp,walk")
+    parser.add_argument("--period", type=float, default=2.0, help="period of the sweep and ramp patterns")
+    parser.add_argument("--max-freq", type=float, default=1000.0, help="maximum joint frequency of the sweep")
+    parser.add_argument("--loopback", action="store_true", help="check vins/dins against the looped back vouts/douts")
+    parser.add_argument("--tolerance", type=float, default=0.2, help="relative tolerance of the joint feedback")
+    parser.add_argument("--max-loss", type=float, default=0.0, help="allowed ratio of lost frames")
+    parser.add_argument("--json", help="write the summary to this file")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print a status line every second")
+    args = parser.parse_args()
+
+    if args.rate <= 0 or args.rate > 10000:
+        print("ERROR: rate must be between 0 and 10000Hz")
+        sys.exit(1)
+
+    layout = load_layout(args.layout)
+    if args.udp:
+        link = UdpTransport(args.udp, args.timeout)
+    elif args.serial:
+        link = SerialTransport(args.serial, args.timeout, args.baud)
+    elif args.spi:
+        link = SpiTransport(args.spi, args.speed)
+    else:
+        link = EmulatorTransport(layout)
+
+    stats = run(
+        layout,
+        link,
+        rate=args.rate,
+        duration=args.duration,
+        patterns=args.patterns.split(","),
+        period=args.period,
+        max_freq=args.max_freq,
+        loopback=args.loopback,
+        tolerance=args.tolerance,
+        verbose=args.verbose,
+    )
+    summary = stats.summary()
+
+    print(f"frames:     {summary['frames']}")
+    print(f"lost:       {summary['lost']}")
+    print(f"overruns:   {summary['overruns']}")
+    print(f"mismatches: {summary['mismatches'] or 0}")
+    print(f"latency:    min {summary['latency_us']['min']}us avg {summary['latency_us']['avg']}us max {summary['latency_us']['max']}us")
+    stats.print_histogram()
+
+    if args.json:
+        open(args.json, "w").write(json.dumps(summary, indent=4))
+
+    if stats.mismatches or stats.lost > args.max_loss * stats.frames:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,21 @@
+import json
+
+import pytest
+
+import projectLoader
+
+CONFIG = "tests/data/tangnano9k_1/config.json"
+
+
+@pytest.fixture
+def load_project(tmp_path):
+    # loads the test config after mutate(jdata) changed it (written to tmp_path)
+    def load(mutate):
+        with open(CONFIG) as ifile:
+            jdata = json.load(ifile)
+        mutate(jdata)
+        config = tmp_path / "config.json"
+        config.write_text(json.dumps(jdata))
+        return projectLoader.load(str(config))
+
+    return load
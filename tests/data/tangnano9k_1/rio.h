@@ -19,11 +19,15 @@
 #define PRU_READ            0x72656164
 #define PRU_WRITE           0x77726974
 #define PRU_ESTOP           0x65737470
+#define RIO_LAYOUT_HASH     0x5c69d217
 #define STEPBIT             22
 #define STEP_MASK           (1L<<STEPBIT)
 #define STEP_OFFSET         (1L<<(STEPBIT-1))
 #define PRU_BASEFREQ        100000000
 #define PRU_OSC             27000000
+#define RCSERVO_OFFSET      300
+#define RCSERVO_DIVIDER     200000
+#define PWM_HIRES_FRAC      16
 
 #define TYPE_VOUT_RAW  0
 #define TYPE_VOUT_PWM  1
@@ -32,6 +36,8 @@
 #define TYPE_VOUT_SINE 4
 #define TYPE_VOUT_FREQ 5
 #define TYPE_VOUT_UDPOTI 6
+#define TYPE_VOUT_PWM_HIRES 7
+#define TYPE_VOUT_PWMDIR_HIRES 8
 #define TYPE_VIN_RAW  0
 #define TYPE_VIN_FREQ 1
 #define TYPE_VIN_TIME 2
@@ -39,15 +45,19 @@
 #define TYPE_VIN_ADC 4
 #define TYPE_VIN_ENCODER 5
 #define TYPE_VIN_NTC 6
+#define TYPE_VIN_FIXED 7
+#define TYPE_VIN_ADC_SEQ 8
+#define TYPE_VIN_NTC_SEQ 9
 #define JOINT_FB_REL 0
 #define JOINT_FB_ABS 1
 #define JOINT_STEPPER 0
 #define JOINT_RCSERVO 1
 #define JOINT_PWMDIR  2
+#define JOINT_DCSERVO 3
 #define DTYPE_IO 0
 #define DTYPE_INDEX 1
 float vout_min[VARIABLE_OUTPUTS] = {0};
-float vout_max[VARIABLE_OUTPUTS] = {10.0};
+float vout_max[VARIABLE_OUTPUTS] = {100.0};
 float vout_freq[VARIABLE_OUTPUTS] = {10000};
 uint8_t vout_type[VARIABLE_OUTPUTS] = {TYPE_VOUT_PWM};
 uint8_t vin_type[VARIABLE_INPUTS] = {TYPE_VIN_RAW};
@@ -82,6 +92,17 @@ typedef union
     };
 } rxData_t;
 
+// frame layout offsets (checked against the unions in rio.c)
+#define TX_OFFSET_HEADER               0
+#define TX_OFFSET_JOINTFREQCMD         4
+#define TX_OFFSET_SETPOINT             24
+#define TX_OFFSET_JOINTENABLE          28
+#define TX_OFFSET_OUTPUTS              29
+#define RX_OFFSET_HEADER               0
+#define RX_OFFSET_JOINTFEEDBACK        4
+#define RX_OFFSET_PROCESSVARIABLE      24
+#define RX_OFFSET_INPUTS               28
+
 #endif
 
 const char vin_names[][32] = {
@@ -0,0 +1,30 @@
+// generated: host side conversions of the used vin/vout types
+#ifndef RIO_CONVERT_H
+#define RIO_CONVERT_H
+
+static inline void vin_convert_raw(int i, float value, long duration) {
+    value += *(data->processVariableOffset[i]);
+    value *= *(data->processVariableScale[i]);
+    *(data->processVariable[i]) = value;
+    *(data->processVariableS32[i]) = (int)value;
+}
+
+static inline int32_t vout_convert_pwm(int i, float value) {
+    if (value > vout_max[i]) {
+        value = vout_max[i];
+    }
+    if (value < vout_min[i]) {
+        value = vout_min[i];
+    }
+    return (value - vout_min[i]) * (PRU_OSC / vout_freq[i]) / (vout_max[i] - vout_min[i]);
+}
+
+static inline void rio_convert_vins(const rxData_t *rx, long duration) {
+    vin_convert_raw(0, rx->processVariable[0], duration);
+}
+
+static inline void rio_convert_vouts(txData_t *tx) {
+    tx->setPoint[0] = vout_convert_pwm(0, *(data->setPoint[0]) * *(data->setPointScale[0]) + *(data->setPointOffset[0]));
+}
+
+#endif
@@ -0,0 +1,78 @@
+// generated: frame fields and packing of the values (rio-layout.json, frameio.py)
+#ifndef RIO_FRAME_H
+#define RIO_FRAME_H
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the frames are little endian, the unions of rio.h need a little endian host"
+#endif
+
+#define RIO_TX_FIELDS(X) \
+    X(header, TX_OFFSET_HEADER, 4, 1) \
+    X(jointFreqCmd, TX_OFFSET_JOINTFREQCMD, 4, 5) \
+    X(setPoint, TX_OFFSET_SETPOINT, 4, 1) \
+    X(jointEnable, TX_OFFSET_JOINTENABLE, 1, 1) \
+    X(outputs, TX_OFFSET_OUTPUTS, 1, 2)
+
+#define RIO_RX_FIELDS(X) \
+    X(header, RX_OFFSET_HEADER, 4, 1) \
+    X(jointFeedback, RX_OFFSET_JOINTFEEDBACK, 4, 5) \
+    X(processVariable, RX_OFFSET_PROCESSVARIABLE, 4, 1) \
+    X(inputs, RX_OFFSET_INPUTS, 1, 3)
+
+// the unions of rio.h against the layout
+#define RIO_FRAME_CHECK(type, name, offset, size, count) \
+    _Static_assert(offsetof(type, name) == (offset) && sizeof(((type *)0)->name) == (size) * (count), #type "." #name);
+#define RIO_FRAME_CHECK_TX(name, offset, size, count) RIO_FRAME_CHECK(txData_t, name, offset, size, count)
+#define RIO_FRAME_CHECK_RX(name, offset, size, count) RIO_FRAME_CHECK(rxData_t, name, offset, size, count)
+RIO_TX_FIELDS(RIO_FRAME_CHECK_TX)
+RIO_RX_FIELDS(RIO_FRAME_CHECK_RX)
+
+// frameio._int32()
+static inline int32_t rio_frame_int32(double value) {
+    if (value > 2147483647.0) {
+        return 2147483647;
+    } else if (value < -2147483647.0) {
+        return -2147483647;
+    }
+    return (int32_t)value;
+}
+
+// frameio.joint_to_cmd(): frequency -> period in clock cycles, position (pwmdir/dcservo) as it is
+static inline int32_t rio_frame_joint_cmd(int i, double value) {
+    switch (i) {
+    case 0: // stepper
+        return value == 0.0 ? 0 : rio_frame_int32(PRU_OSC / value / 2);
+    case 1: // stepper
+        return value == 0.0 ? 0 : rio_frame_int32(PRU_OSC / value / 2);
+    case 2: // stepper
+        return value == 0.0 ? 0 : rio_frame_int32(PRU_OSC / value / 2);
+    case 3: // stepper
+        return value == 0.0 ? 0 : rio_frame_int32(PRU_OSC / value / 2);
+    case 4: // stepper
+        return value == 0.0 ? 0 : rio_frame_int32(PRU_OSC / value / 2);
+    }
+    return 0;
+}
+
+// frameio.Frame.pack_bits(): douts/dins msb first, joint enables lsb first
+static inline void rio_frame_set_output(txData_t *tx, int num, int value) {
+    if (value) {
+        tx->outputs[num / 8] |= (1 << (7 - num % 8));
+    } else {
+        tx->outputs[num / 8] &= ~(1 << (7 - num % 8));
+    }
+}
+
+static inline void rio_frame_set_enable(txData_t *tx, int num, int value) {
+    if (value) {
+        tx->jointEnable[num / 8] |= (1 << (num % 8));
+    } else {
+        tx->jointEnable[num / 8] &= ~(1 << (num % 8));
+    }
+}
+
+static inline int rio_frame_get_input(const rxData_t *rx, int num) {
+    return (rx->inputs[num / 8] >> (7 - num % 8)) & 1;
+}
+
+#endif
@@ -0,0 +1,222 @@
+// libftdi1 mock for tests/rio_mpsse_test.c
+//   the written bytes are logged and interpreted like the MPSSE engine: SET_BITS_LOW sets the pins,
+//   a full duplex transfer answers with mock_answer (the fpga frame) while the chip select is low
+//   the answer is read back in chunks of mock_chunk bytes
+//   write only transfers (configuration) are logged in mock_mosi, GET_BITS_LOW answers the pins and mock_inputs
+
+#ifndef FTDI_MOCK_H
+#define FTDI_MOCK_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MPSSE_WRITE_NEG		0x01
+#define MPSSE_BITMODE		0x02
+#define MPSSE_READ_NEG		0x04
+#define MPSSE_LSB			0x08
+#define MPSSE_DO_WRITE		0x10
+#define MPSSE_DO_READ		0x20
+#define SET_BITS_LOW		0x80
+#define GET_BITS_LOW		0x81
+#define LOOPBACK_END		0x85
+#define TCK_DIVISOR			0x86
+#define SEND_IMMEDIATE		0x87
+#define DIS_DIV_5			0x8a
+#define DIS_3_PHASE			0x8d
+#define DIS_ADAPTIVE		0x97
+
+enum ftdi_interface { INTERFACE_ANY = 0, INTERFACE_A = 1, INTERFACE_B = 2, INTERFACE_C = 3, INTERFACE_D = 4 };
+enum ftdi_mpsse_mode { BITMODE_RESET = 0x00, BITMODE_BITBANG = 0x01, BITMODE_MPSSE = 0x02 };
+
+struct ftdi_context {
+    int		interface;
+    int		vid;
+    int		pid;
+    int		latency;
+    int		bitmode;
+    int		open;
+};
+
+struct ftdi_transfer_control {
+    int		read;
+    uint8_t	*buf;
+    int		size;
+    int		result;
+};
+
+static int mock_fail_open = 0;
+static int mock_chunk = 64;
+static uint8_t mock_answer[4096];
+static uint8_t mock_log[65536];
+static int mock_log_len = 0;
+static uint8_t mock_pins = 0;
+static uint8_t mock_mosi[65536];			// bytes clocked in while the chip select was low
+static int mock_mosi_len = 0;
+static int mock_cs = 3;
+static uint8_t mock_queue[65536];
+static int mock_queue_len = 0;
+static int mock_queue_pos = 0;
+static int mock_reads = 0;
+static uint8_t mock_inputs = 0x40;		// ADBUS levels of the inputs (CDONE on ADBUS6)
+static int mock_reset = 7;
+static int mock_slave = 0;				// creset was low with the chip select low
+
+static const char *ftdi_get_error_string(struct ftdi_context *ftdi)
+{
+    return "mock";
+}
+
+static struct ftdi_context *ftdi_new(void)
+{
+    return calloc(1, sizeof(struct ftdi_context));
+}
+
+static void ftdi_free(struct ftdi_context *ftdi)
+{
+    free(ftdi);
+}
+
+static int ftdi_set_interface(struct ftdi_context *ftdi, enum ftdi_interface interface)
+{
+    ftdi->interface = interface;
+    return 0;
+}
+
+static int ftdi_usb_open(struct ftdi_context *ftdi, int vendor, int product)
+{
+    if (mock_fail_open) {
+        return -3;
+    }
+    ftdi->vid = vendor;
+    ftdi->pid = product;
+    ftdi->open = 1;
+    return 0;
+}
+
+static int ftdi_usb_close(struct ftdi_context *ftdi)
+{
+    ftdi->open = 0;
+    return 0;
+}
+
+static int ftdi_usb_reset(struct ftdi_context *ftdi)
+{
+    return 0;
+}
+
+static int ftdi_usb_purge_buffers(struct ftdi_context *ftdi)
+{
+    mock_queue_len = 0;
+    mock_queue_pos = 0;
+    return 0;
+}
+
+static int ftdi_set_latency_timer(struct ftdi_context *ftdi, unsigned char latency)
+{
+    ftdi->latency = latency;
+    return 0;
+}
+
+static int ftdi_set_bitmode(struct ftdi_context *ftdi, unsigned char bitmask, unsigned char mode)
+{
+    ftdi->bitmode = mode;
+    return 0;
+}
+
+// the MPSSE engine
+static int ftdi_write_data(struct ftdi_context *ftdi, const unsigned char *buf, int size)
+{
+    int pos = 0;
+    memcpy(mock_log + mock_log_len, buf, size);
+    mock_log_len += size;
+    while (pos < size) {
+        uint8_t cmd = buf[pos];
+        if (cmd == SET_BITS_LOW) {
+            mock_pins = buf[pos + 1];
+            if ((mock_pins & ((1 << mock_cs) | (1 << mock_reset))) == 0) {
+                mock_slave = 1;
+            }
+            pos += 3;
+        } else if (cmd == GET_BITS_LOW) {
+            mock_queue[mock_queue_len++] = mock_pins | mock_inputs;
+            pos += 1;
+        } else if (cmd == (MPSSE_DO_WRITE | MPSSE_WRITE_NEG)) {
+            int len = buf[pos + 1] + (buf[pos + 2] << 8) + 1;
+            int n;
+            pos += 3;
+            for (n = 0; n < len; n++) {
+                if ((mock_pins & (1 << mock_cs)) == 0) {
+                    mock_mosi[mock_mosi_len++] = buf[pos + n];
+                }
+            }
+            pos += len;
+        } else if (cmd == TCK_DIVISOR) {
+            pos += 3;
+        } else if (cmd == (MPSSE_DO_WRITE | MPSSE_DO_READ | MPSSE_WRITE_NEG)) {
+            int len = buf[pos + 1] + (buf[pos + 2] << 8) + 1;
+            int n;
+            pos += 3;
+            for (n = 0; n < len; n++) {
+                if ((mock_pins & (1 << mock_cs)) == 0) {
+                    mock_mosi[mock_mosi_len++] = buf[pos + n];
+                    mock_queue[mock_queue_len++] = mock_answer[n];
+                } else {
+                    mock_queue[mock_queue_len++] = 0xff;
+                }
+            }
+            pos += len;
+        } else {
+            pos += 1;
+        }
+    }
+    return size;
+}
+
+static int ftdi_read_data(struct ftdi_context *ftdi, unsigned char *buf, int size)
+{
+    int len = mock_queue_len - mock_queue_pos;
+    if (len > size) {
+        len = size;
+    }
+    if (len > mock_chunk) {
+        len = mock_chunk;
+    }
+    memcpy(buf, mock_queue + mock_queue_pos, len);
+    mock_queue_pos += len;
+    mock_reads++;
+    return len;
+}
+
+static struct ftdi_transfer_control *ftdi_write_data_submit(struct ftdi_context *ftdi, unsigned char *buf, int size)
+{
+    struct ftdi_transfer_control *tc = calloc(1, sizeof(struct ftdi_transfer_control));
+    tc->result = ftdi_write_data(ftdi, buf, size);
+    return tc;
+}
+
+static struct ftdi_transfer_control *ftdi_read_data_submit(struct ftdi_context *ftdi, unsigned char *buf, int size)
+{
+    struct ftdi_transfer_control *tc = calloc(1, sizeof(struct ftdi_transfer_control));
+    tc->read = 1;
+    tc->buf = buf;
+    tc->size = size;
+    return tc;
+}
+
+// like libftdi: the read completes in chunks, an empty read ends it
+static int ftdi_transfer_data_done(struct ftdi_transfer_control *tc)
+{
+    int result = tc->result;
+    if (tc->read) {
+        int len;
+        result = 0;
+        while (result < tc->size && (len = ftdi_read_data(NULL, tc->buf + result, tc->size - result)) > 0) {
+            result += len;
+        }
+    }
+    free(tc);
+    return result;
+}
+
+#endif
@@ -0,0 +1,162 @@
+// LinuxCNC HAL mock for building rio.c on the host (autotune.py --component)
+//   pins and parameters are kept with their names in mock_hal_objects, mock_hal_find() returns the value,
+//   the exported functions are called by name with mock_hal_call()
+
+#ifndef HAL_MOCK_H
+#define HAL_MOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HAL_NAME_LEN 47
+
+typedef volatile bool hal_bit_t;
+typedef volatile double hal_float_t;
+typedef volatile int32_t hal_s32_t;
+typedef volatile uint32_t hal_u32_t;
+
+typedef enum { HAL_IN = 16, HAL_OUT = 32, HAL_IO = 48 } hal_pin_dir_t;
+typedef enum { HAL_RO = 64, HAL_RW = 192 } hal_param_dir_t;
+
+typedef struct {
+    int		depth;
+} hal_stream_t;
+
+union hal_stream_data {
+    double		f;
+    bool		b;
+    int32_t		s;
+    uint32_t	u;
+};
+
+typedef struct {
+    char		name[HAL_NAME_LEN + 1];
+    void		*value;
+} mock_hal_object_t;
+
+typedef struct {
+    char		name[HAL_NAME_LEN + 1];
+    void		(*funct)(void *, long);
+    void		*arg;
+} mock_hal_funct_t;
+
+static mock_hal_object_t mock_hal_objects[4096];
+static int mock_hal_object_count = 0;
+static mock_hal_funct_t mock_hal_functs[16];
+static int mock_hal_funct_count = 0;
+
+static void *mock_hal_add(void *value, const char *fmt, va_list args)
+{
+    if (mock_hal_object_count >= (int)(sizeof(mock_hal_objects) / sizeof(mock_hal_objects[0]))) {
+        return NULL;
+    }
+    vsnprintf(mock_hal_objects[mock_hal_object_count].name, HAL_NAME_LEN + 1, fmt, args);
+    mock_hal_objects[mock_hal_object_count].value = value;
+    mock_hal_object_count++;
+    return value;
+}
+
+// the value of a pin or parameter (NULL: not found)
+static void *mock_hal_find(const char *name)
+{
+    int n;
+    for (n = 0; n < mock_hal_object_count; n++) {
+        if (strcmp(mock_hal_objects[n].name, name) == 0) {
+            return mock_hal_objects[n].value;
+        }
+    }
+    return NULL;
+}
+
+static int mock_hal_call(const char *name, long period)
+{
+    int n;
+    for (n = 0; n < mock_hal_funct_count; n++) {
+        if (strcmp(mock_hal_functs[n].name, name) == 0) {
+            mock_hal_functs[n].funct(mock_hal_functs[n].arg, period);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int hal_init(const char *name)
+{
+    mock_hal_object_count = 0;
+    mock_hal_funct_count = 0;
+    return 1;
+}
+
+static int hal_exit(int comp_id)
+{
+    return 0;
+}
+
+static int hal_ready(int comp_id)
+{
+    return 0;
+}
+
+static void *hal_malloc(long size)
+{
+    return calloc(1, size);
+}
+
+static int hal_export_funct(const char *name, void (*funct)(void *, long), void *arg, int uses_fp, int reentrant, int comp_id)
+{
+    if (mock_hal_funct_count >= (int)(sizeof(mock_hal_functs) / sizeof(mock_hal_functs[0]))) {
+        return -1;
+    }
+    snprintf(mock_hal_functs[mock_hal_funct_count].name, HAL_NAME_LEN + 1, "%s", name);
+    mock_hal_functs[mock_hal_funct_count].funct = funct;
+    mock_hal_functs[mock_hal_funct_count].arg = arg;
+    mock_hal_funct_count++;
+    return 0;
+}
+
+#define MOCK_HAL_PIN_NEWF(func, type) \
+    static int func(hal_pin_dir_t dir, type **pin, int comp_id, const char *fmt, ...) __attribute__((format(printf, 4, 5))); \
+    static int func(hal_pin_dir_t dir, type **pin, int comp_id, const char *fmt, ...) { \
+        va_list args; \
+        va_start(args, fmt); \
+        *pin = mock_hal_add(calloc(1, sizeof(type)), fmt, args); \
+        va_end(args); \
+        return *pin == NULL ? -1 : 0; \
+    }
+
+MOCK_HAL_PIN_NEWF(hal_pin_bit_newf, hal_bit_t)
+MOCK_HAL_PIN_NEWF(hal_pin_float_newf, hal_float_t)
+MOCK_HAL_PIN_NEWF(hal_pin_s32_newf, hal_s32_t)
+MOCK_HAL_PIN_NEWF(hal_pin_u32_newf, hal_u32_t)
+
+static int hal_param_float_newf(hal_param_dir_t dir, hal_float_t *param, int comp_id, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+static int hal_param_float_newf(hal_param_dir_t dir, hal_float_t *param, int comp_id, const char *fmt, ...)
+{
+    va_list args;
+    void *value;
+    va_start(args, fmt);
+    value = mock_hal_add((void *)param, fmt, args);
+    va_end(args);
+    return value == NULL ? -1 : 0;
+}
+
+static int hal_stream_create(hal_stream_t *stream, int comp_id, int key, int depth, const char *typestring)
+{
+    stream->depth = depth;
+    return 0;
+}
+
+static void hal_stream_destroy(hal_stream_t *stream)
+{
+}
+
+static int hal_stream_write(hal_stream_t *stream, union hal_stream_data *data)
+{
+    return 0;
+}
+
+#endif
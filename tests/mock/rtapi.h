@@ -0,0 +1,63 @@
+// LinuxCNC RTAPI mock for building rio.c on the host (autotune.py --component)
+//   the messages go to stderr (mock_rtapi_quiet: only errors), the time is mock_rtapi_time (ns)
+
+#ifndef RTAPI_MOCK_H
+#define RTAPI_MOCK_H
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <fcntl.h>
+
+#define RTAPI_MSG_ERR	1
+#define RTAPI_MSG_INFO	3
+
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_LICENSE(x)
+#define RTAPI_MP_INT(var, description)
+#define RTAPI_MP_STRING(var, description)
+#define RTAPI_MP_ARRAY_STRING(var, num, description)
+
+static int mock_rtapi_quiet = 1;
+static long long mock_rtapi_time = 0;
+
+static void rtapi_print(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static void rtapi_print(const char *fmt, ...)
+{
+    va_list args;
+    if (!mock_rtapi_quiet) {
+        va_start(args, fmt);
+        vfprintf(stderr, fmt, args);
+        va_end(args);
+    }
+}
+
+static void rtapi_print_msg(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void rtapi_print_msg(int level, const char *fmt, ...)
+{
+    va_list args;
+    if (!mock_rtapi_quiet || level == RTAPI_MSG_ERR) {
+        va_start(args, fmt);
+        vfprintf(stderr, fmt, args);
+        va_end(args);
+    }
+}
+
+#define rtapi_snprintf snprintf
+
+static long long rtapi_get_time(void)
+{
+    return mock_rtapi_time;
+}
+
+static void rtapi_delay(long ns)
+{
+    mock_rtapi_time += ns;
+}
+
+static int rtapi_open_as_root(const char *filename, int mode)
+{
+    return open(filename, mode);
+}
+
+#endif
@@ -0,0 +1 @@
+// LinuxCNC RTAPI mock (see rtapi.h)
@@ -0,0 +1,64 @@
+// accuracy check and benchmark of the compensation tables (generators/linuxcnc_component/rio_comp.h)
+//
+//   rio_comp_bench TABLE                 reads "position reverse" lines from stdin, prints the errors
+//   rio_comp_bench TABLE LOOKUPS JOINTS  times LOOKUPS servo cycles with JOINTS tables (command + feedback)
+//
+// gcc -O2 -I generators/linuxcnc_component -o rio_comp_bench tests/rio_comp_bench.c -lm
+
+#include <time.h>
+
+#include "rio_comp.h"
+
+int main(int argc, char **argv)
+{
+    comp_table_t table;
+    int points;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s TABLE [LOOKUPS JOINTS]\n", argv[0]);
+        return 1;
+    }
+    points = comp_load(&table, argv[1]);
+    if (points < 0) {
+        printf("error %i\n", points);
+        return 1;
+    }
+    printf("points %i\n", points);
+
+    if (argc < 4) {
+        double position, reverse;
+        while (scanf("%lf %lf", &position, &reverse) == 2) {
+            printf("%.9f\n", comp_error(&table, position, reverse));
+        }
+    } else {
+        long lookups = atol(argv[2]);
+        int joints = atoi(argv[3]);
+        double range = table.last / table.recip;
+        double reverse[64] = {0.0};
+        double last[64] = {0.0};
+        double sum = 0.0;
+        struct timespec t0, t1;
+        long n;
+        int j;
+
+        if (joints > 64) {
+            joints = 64;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (n = 0; n < lookups; n++) {
+            for (j = 0; j < joints; j++) {
+                // back and forth over the table, like update_freq() and rio_readwrite()
+                double position = table.start + range * (0.5 + 0.5 * sin(n * 0.001 + j));
+                reverse[j] = comp_direction(reverse[j], position - last[j]);
+                last[j] = position;
+                sum += position - comp_error(&table, position, reverse[j]);
+                sum += position + comp_error(&table, position - 0.001, reverse[j]);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        printf("cycle_ns %.1f\n", ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / lookups);
+        printf("sum %f\n", sum);
+    }
+    comp_free(&table);
+    return 0;
+}
@@ -0,0 +1,59 @@
+// check of the generated frame codec (rio_frame.h) against frameio.Frame
+//
+//   stdin:  JOINTS frequencies, JOINTS enables, DIGITAL_OUTPUTS outputs, SPIBUFSIZE answer bytes (hex)
+//   stdout: the packed frame (hex) and the DIGITAL_INPUTS of the answer
+//
+// gcc -O2 -I OUTPUT/LinuxCNC/Components -o rio_frame_test tests/rio_frame_test.c
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "rio.h"
+#include "rio_frame.h"
+
+int main(void)
+{
+    txData_t tx = {0};
+    rxData_t rx = {0};
+    double freq;
+    int value, n;
+    unsigned int byte;
+
+    tx.header = PRU_WRITE;
+    for (n = 0; n < JOINTS; n++) {
+        if (scanf("%lf", &freq) != 1) {
+            return 1;
+        }
+        tx.jointFreqCmd[n] = rio_frame_joint_cmd(n, freq);
+    }
+    for (n = 0; n < JOINTS; n++) {
+        if (scanf("%d", &value) != 1) {
+            return 1;
+        }
+        rio_frame_set_enable(&tx, n, value);
+    }
+    for (n = 0; n < DIGITAL_OUTPUTS; n++) {
+        if (scanf("%d", &value) != 1) {
+            return 1;
+        }
+        rio_frame_set_output(&tx, n, value);
+    }
+    for (n = 0; n < SPIBUFSIZE; n++) {
+        if (scanf("%x", &byte) != 1) {
+            return 1;
+        }
+        rx.rxBuffer[n] = byte;
+    }
+
+    printf("tx");
+    for (n = 0; n < SPIBUFSIZE; n++) {
+        printf(" %02x", tx.txBuffer[n]);
+    }
+    printf("\nin");
+    for (n = 0; n < DIGITAL_INPUTS; n++) {
+        printf(" %d", rio_frame_get_input(&rx, n));
+    }
+    printf("\n");
+    return 0;
+}
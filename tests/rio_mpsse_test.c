@@ -0,0 +1,87 @@
+// transport check of rio_mpsse.h against the libftdi mock (tests/mock/ftdi.h)
+//
+//   rio_mpsse_test SIZE            prints the setup, one synchronous and two pipelined frames
+//   rio_mpsse_test SIZE CONFIG     configuration with a bitstream of CONFIG bytes (cdone high/low)
+//
+// gcc -O2 -I tests/mock -I generators/linuxcnc_component -o rio_mpsse_test tests/rio_mpsse_test.c
+
+#include <stdio.h>
+
+#define FPGA_CDONE 6
+
+#include "rio_mpsse.h"
+
+static void dump(const char *name, const uint8_t *buf, int len)
+{
+    int n;
+    printf("%s", name);
+    for (n = 0; n < len; n++) {
+        printf(" %02x", buf[n]);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    mpsse_t m;
+    uint8_t tx[4096];
+    uint8_t rx[4096];
+    int size = argc > 1 ? atoi(argv[1]) : 16;
+    int ret, n;
+    long config = argc > 2 ? atol(argv[2]) : 0;
+
+    mock_fail_open = 1;
+    printf("open %i\n", mpsse_open(&m, 0x0403, 0x6010, INTERFACE_A, 2, mock_cs, 7));
+    mock_fail_open = 0;
+    ret = mpsse_open(&m, 0x0403, 0x6010, INTERFACE_A, 2, mock_cs, 7);
+    printf("open %i\n", ret);
+    printf("latency %i bitmode %i\n", m.ftdi->latency, m.ftdi->bitmode);
+    dump("setup", mock_log, mock_log_len);
+
+    if (config > 0) {
+        uint8_t *bitstream = malloc(config);
+        for (n = 0; n < config; n++) {
+            bitstream[n] = n * 7;
+        }
+        mock_mosi_len = 0;
+        ret = mpsse_configure(&m, bitstream, config, FPGA_CDONE);
+        printf("configure %i slave %i\n", ret, mock_slave);
+        // the bitstream with the chip select low, the dummy bytes with the chip select high
+        printf("config %i match %i\n", mock_mosi_len, mock_mosi_len == config && memcmp(mock_mosi, bitstream, config) == 0);
+        mock_inputs = 0;
+        printf("configure %i\n", mpsse_configure(&m, bitstream, config, FPGA_CDONE));
+        free(bitstream);
+        mpsse_close(&m);
+        return 0;
+    }
+
+    for (n = 0; n < size; n++) {
+        tx[n] = n;
+        mock_answer[n] = 0xa0 ^ n;
+    }
+
+    // synchronous
+    mock_log_len = 0;
+    ret = mpsse_transfer(&m, tx, rx, size);
+    printf("transfer %i reads %i\n", ret, mock_reads);
+    dump("cmd", mock_log, mock_log_len);
+    dump("mosi", mock_mosi, mock_mosi_len);
+    dump("rx", rx, size);
+
+    // pipelined: the answer of the first frame is collected before the second one is submitted
+    mock_mosi_len = 0;
+    ret = mpsse_submit(&m, tx, rx, size);
+    printf("submit %i pending %i\n", ret, mpsse_pending(&m));
+    ret = mpsse_wait(&m, size);
+    printf("wait %i pending %i\n", ret, mpsse_pending(&m));
+    mock_answer[0] = 0x55;
+    ret = mpsse_submit(&m, tx, rx, size);
+    ret = mpsse_wait(&m, size);
+    printf("wait %i first %02x\n", ret, rx[0]);
+    printf("mosi %i\n", mock_mosi_len);
+    printf("wait %i\n", mpsse_wait(&m, size));
+    printf("oversize %i\n", mpsse_submit(&m, tx, rx, MPSSE_MAX_FRAME + 1));
+
+    mpsse_close(&m);
+    return 0;
+}
@@ -0,0 +1,68 @@
+
+import shutil
+
+import pytest
+
+import autotune
+import projectLoader
+
+
+@pytest.fixture(scope="module")
+def setup(tmp_path_factory):
+    # rio_loop.h is plain C, the loop is built with the host compiler
+    if shutil.which("gcc") is None:
+        pytest.skip("no gcc")
+    lib = autotune.build_loop(str(tmp_path_factory.mktemp("loop") / "rio_loop.so"))
+    project = projectLoader.load("configs/TangNano9K/config.json")
+    return lib, project
+
+
+@pytest.fixture(scope="module")
+def component(tmp_path_factory):
+    # the generated rio.c against the HAL, RTAPI and libftdi mocks (tests/mock)
+    if shutil.which("gcc") is None:
+        pytest.skip("no gcc")
+    return autotune.build_component("configs/TangNano9K/config.json", 0, str(tmp_path_factory.mktemp("component") / "rio_component.so"))
+
+
+def run(setup, plant, vmax=20.0):
+    lib, project = setup
+    model = project["timing"]
+    period = model["servo_period"] / 1000000000.0
+    joint = {"scale": 800.0, "maxvel": vmax, "maxaccel": 4000.0, "clock": int(project["jdata"]["clock"]["speed"])}
+    positions = autotune.trajectory(10.0, vmax, 70.0, 700.0, period)
+    result = autotune.tune(lib, joint, period, model["transfer_time"], plant, positions)
+    # defaults of the component and the generated config: pgain 1.0, ff1gain 1.0, deadband 10 steps
+    default = autotune.simulate(lib, joint, (1.0, 1.0, 10.0 / 800.0), positions, period, model["transfer_time"], plant)
+    return joint, model, result, default
+
+
+def test_autotune_stepper(setup):
+    joint, model, result, default = run(setup, {"type": "stepper"})
+    assert result["ferror"] < default[0] * 0.5
+    assert result["end_error"] <= result["deadband"]
+    assert 0.0 < result["pgain"] < 4.0 / model["latency"]
+    snippet = autotune.hal_snippet(0, result, joint, model, {"type": "stepper"})
+    assert "setp rio.joint.0.pgain" in snippet
+    assert "setp rio.joint.0.ff1gain" in snippet
+    assert "setp rio.joint.0.deadband" in snippet
+
+
+def test_autotune_pwmdir(setup):
+    plant = {"type": "pwmdir", "kv": 1.0, "tau": 0.02, "umax": 100000.0}
+    joint, model, result, default = run(setup, plant)
+    assert result["ferror"] < default[0] * 0.5
+    assert result["ff1gain"] > 0.0
+
+
+def test_autotune_component(setup, component):
+    # rio_loop.h with the types and limits of rio.c gives the same result as the component
+    lib, project = setup
+    model = project["timing"]
+    period = model["servo_period"] / 1000000000.0
+    joint = {"scale": 800.0, "maxvel": 20.0, "maxaccel": 4000.0, "clock": int(project["jdata"]["clock"]["speed"])}
+    positions = autotune.trajectory(10.0, 20.0, 70.0, 700.0, period)
+    for plant in ({"type": "stepper"}, {"type": "pwmdir", "kv": 1.0, "tau": 0.02, "umax": 100000.0}):
+        for gains in ((1.0, 1.0, 10.0 / 800.0), (80.0, 0.95, 1.0 / 800.0), (500.0, 1.1, 0.5 / 800.0)):
+            expected = autotune.simulate(lib, joint, gains, positions, period, model["transfer_time"], plant)
+            assert autotune.simulate(component, joint, gains, positions, period, model["transfer_time"], plant) == expected
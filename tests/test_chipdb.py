@@ -0,0 +1,121 @@
+
+import json
+import time
+
+import chipdb
+import projectLoader
+
+
+def test_chipdb_index():
+    # plain pin lists (no banks), hx4k: 8k die with ':4k' packages
+    db = chipdb.load({"family": "ice40", "type": "hx4k", "package": "tq144"})
+    assert len(db.pins) == 107
+    assert list(db.banks) == [None]
+    assert chipdb.load({"family": "ice40", "type": "up5k", "package": "sg48"}) is chipdb.load({"family": "ice40", "type": "up5k", "package": "sg48"})
+    assert chipdb.load({"family": "GW1N-9C", "type": "GW1NR-LV9QN88PC6/I5", "package": ""}) is None
+    assert chipdb.pin_key("A10") > chipdb.pin_key("A9")
+
+
+def make_project(signals, package="ct256", pins=None):
+    pinlists = {"main": (("sysclk", "J3", "INPUT", True),)}
+    pinlists["interface_spislave"] = [(f"INTERFACE_SPI_{name}", "auto", "INPUT") for name in ("MOSI", "SCK", "SSEL")]
+    pinlists["dout_bit"] = [(f"DOUT{num}", "auto", "OUTPUT") for num in range(signals)]
+    for name, pin in (pins or {}).items():
+        pinlists["dout_bit"].append((name, pin, "OUTPUT"))
+    return {"jdata": {"family": "ice40", "type": "hx8k", "package": package}, "pinlists": pinlists}
+
+
+def test_chipdb_solve():
+    project = make_project(200)
+    start = time.time()
+    assert chipdb.solve(project) == []
+    assert time.time() - start < 1.0
+    assigned = [pinsetup[1] for pinlist in project["pinlists"].values() for pinsetup in pinlist]
+    assert len(assigned) == 204
+    assert len(set(assigned)) == 204
+    assert "auto" not in assigned
+    db = chipdb.load(project["jdata"])
+    assert all(pin in db.pins for pin in assigned)
+    # too many signals, conflicts and unknown pins are reported at once
+    assert chipdb.solve(make_project(210)) == ["no free pin for DOUT202", "no free pin for DOUT203", "no free pin for DOUT204", "no free pin for DOUT205", "no free pin for DOUT206", "no free pin for DOUT207", "no free pin for DOUT208", "no free pin for DOUT209"]
+    errors = chipdb.solve(make_project(5, pins={"A": "B1", "B": "B1", "C": "ZZ9", "D": "J3"}))
+    assert len(errors) == 3
+    assert errors[0].startswith("pin B1 allready in use")
+    assert errors[1] == "pin ZZ9 (C) is not in package ct256"
+    assert errors[2].startswith("pin J3 allready in use")
+
+
+def test_chipdb_banks(monkeypatch):
+    # chipdata with banks: clock on a gbin pin, the interface in the clock bank, a plugin in one bank
+    pins = {f"P{num}": {"bank": num // 10} for num in range(40)}
+    pins["P25"]["gbin"] = 0
+    monkeypatch.setattr(chipdb, "_chipdata", lambda family: {"test": {"pkg": pins}})
+    chipdb._load.cache_clear()
+    project = {
+        "jdata": {"family": "ice40", "type": "test", "package": "pkg"},
+        "pinlists": {
+            "main": (("sysclk", "auto", "INPUT", True),),
+            "dout_bit": [(f"DOUT{num}", "auto", "OUTPUT") for num in range(8)],
+            "interface_spislave": [(f"SPI{num}", "auto", "INPUT") for num in range(4)],
+        },
+    }
+    assert chipdb.solve(project) == []
+    chipdb._load.cache_clear()
+    assert project["pinlists"]["main"][0][:2] == ("sysclk", "P25")
+    assert [pinsetup[1] for pinsetup in project["pinlists"]["interface_spislave"]] == ["P20", "P21", "P22", "P23"]
+    assert len({pins[pinsetup[1]]["bank"] for pinsetup in project["pinlists"]["dout_bit"]}) == 1
+    # keeps the pullup flag
+    assert project["pinlists"]["main"][0][3] is True
+
+    # the clock only on a global clock input: no gbin data, gbin pin in use
+    del pins["P25"]["gbin"]
+    project["pinlists"]["main"] = (("sysclk", "auto", "INPUT", True),)
+    assert chipdb.solve(project) == ["no global clock input data for package pkg, sysclk can not be 'auto'"]
+    chipdb._load.cache_clear()
+    pins["P25"]["gbin"] = 0
+    project["pinlists"]["main"] = (("sysclk", "auto", "INPUT", True),)
+    project["pinlists"]["dout_bit"] = [("DOUT0", "P25", "OUTPUT")]
+    assert chipdb.solve(project) == ["no free global clock input for sysclk"]
+    chipdb._load.cache_clear()
+
+
+def test_chipdb_config(tmp_path):
+    jdata = json.loads(open("configs/ICEBreakerV1.0e/config.json").read())
+    for plugin in jdata["plugins"]:
+        if plugin["type"] == "dout_bit":
+            plugin["pin"] = "auto"
+    config = tmp_path / "config.json"
+    config.write_text(json.dumps(jdata))
+    project = projectLoader.load(str(config))
+    assigned = [pinsetup[1] for pinlist in project["pinlists"].values() for pinsetup in pinlist if not pinsetup[1].startswith("EXPANSION")]
+    assert "auto" not in assigned
+    assert len(assigned) == len(set(assigned))
+
+
+def test_chipdata_scripts():
+    # the chipdata scripts on excerpts of the icebox and trellis databases (the full ones are in oss-cad-suite)
+    from chipdata import icebox_chipdb2chipdata_pinlist, trellis_iodb2chipdata_pinlist
+
+    source = "\n".join([".device 1k", "", ".pins tq144", "1 0 14 1", "2 0 14 0", "21 7 0 0", "49 13 8 1", "112 6 17 0", "", ".gbufpin", "0 14 1 6", "7 0 0 1", ""])
+    pins = icebox_chipdb2chipdata_pinlist.convert(source)["tq144"]
+    assert pins == {
+        "1": {"bank": 3, "gbin": 6, "pair": "2"},
+        "2": {"bank": 3, "pair": "1"},
+        "21": {"bank": 2, "gbin": 1},
+        "49": {"bank": 1},
+        "112": {"bank": 0},
+    }
+    db = chipdb.ChipDB(pins)
+    assert db.gbin == ["1", "21"] and db.bank("49") == 1 and db.pair("2") == "1"
+
+    source = {
+        "packages": {"CABGA256": {"A2": {"col": 0, "row": 2, "pio": "A"}, "B2": {"col": 0, "row": 2, "pio": "B"}, "C8": {"col": 20, "row": 0, "pio": "A"}}},
+        "pio_metadata": [
+            {"col": 0, "row": 2, "pio": "A", "bank": 7, "function": "PL2A"},
+            {"col": 0, "row": 2, "pio": "B", "bank": 7, "function": "PL2B"},
+            {"col": 20, "row": 0, "pio": "A", "bank": 1, "function": "PCLKT1_0"},
+        ],
+    }
+    pins = trellis_iodb2chipdata_pinlist.convert(source)["CABGA256"]
+    assert pins == {"A2": {"bank": 7, "pair": "B2"}, "B2": {"bank": 7, "pair": "A2"}, "C8": {"bank": 1, "gbin": "PCLKT1_0"}}
+    assert chipdb.ChipDB(pins).gbin == ["C8"]
@@ -0,0 +1,87 @@
+
+import math
+import random
+import shutil
+import struct
+import subprocess
+
+import pytest
+
+
+def f32(value):
+    return struct.unpack("f", struct.pack("f", value))[0]
+
+
+@pytest.fixture(scope="module")
+def bench(tmp_path_factory):
+    # rio_comp.h is plain C, the test harness is built with the host compiler
+    if shutil.which("gcc") is None:
+        pytest.skip("no gcc")
+    binary = tmp_path_factory.mktemp("comp") / "rio_comp_bench"
+    subprocess.run(
+        ["gcc", "-O2", "-Wall", "-I", "generators/linuxcnc_component", "-o", str(binary), "tests/rio_comp_bench.c", "-lm"],
+        check=True,
+    )
+    return str(binary)
+
+
+def write_table(path, points, start=-10.0, step=0.05):
+    # leadscrew error (sine) and 0.02 backlash
+    table = []
+    with open(path, "w") as ofile:
+        ofile.write("# nominal forward reverse\n")
+        for num in range(points):
+            nominal = start + num * step
+            forward = nominal + 0.01 * math.sin(nominal / 7.0)
+            reverse = forward + 0.02
+            table.append((nominal, forward - nominal, reverse - nominal))
+            ofile.write(f"{nominal:.6f} {forward:.9f} {reverse:.9f}\n")
+    return table
+
+
+def reference(table, position, reverse):
+    start, step = table[0][0], table[1][0] - table[0][0]
+    x = min(max((position - start) / step, 0.0), len(table) - 1)
+    index = min(int(x), len(table) - 2)
+    frac = x - index
+    fwd = [f32(table[index][1]), f32(table[index + 1][1])]
+    rev = [f32(table[index][2]), f32(table[index + 1][2])]
+    fwd = fwd[0] + frac * (fwd[1] - fwd[0])
+    rev = rev[0] + frac * (rev[1] - rev[0])
+    return fwd + reverse * (rev - fwd)
+
+
+def test_comp_accuracy(bench, tmp_path):
+    table = write_table(tmp_path / "comp.txt", 10001)
+    rnd = random.Random(1)
+    queries = [(rnd.uniform(-20.0, 520.0), rnd.choice((0.0, 1.0))) for num in range(2000)]
+    queries += [(-10.0, 0.0), (490.0, 1.0), (-100.0, 1.0), (1000.0, 0.0)]
+    stdin = "".join(f"{position:.9f} {reverse}\n" for position, reverse in queries)
+    result = subprocess.run([bench, str(tmp_path / "comp.txt")], input=stdin, capture_output=True, text=True, check=True)
+    lines = result.stdout.split("\n")
+    assert lines[0] == "points 10001"
+    for (position, reverse), line in zip(queries, lines[1:]):
+        assert abs(float(line) - reference(table, position, reverse)) < 1e-7
+    # against the exact error between the grid points: the table resolution
+    for (position, reverse), line in zip(queries[:200], lines[1:]):
+        position = min(max(position, -10.0), 490.0)
+        exact = 0.01 * math.sin(position / 7.0) + 0.02 * reverse
+        assert abs(float(line) - exact) < 1e-6
+
+
+def test_comp_errors(bench, tmp_path):
+    (tmp_path / "grid.txt").write_text("0 0 0\n1 1 1\n2.5 2.5 2.5\n")
+    (tmp_path / "format.txt").write_text("0 0\n")
+    assert subprocess.run([bench, str(tmp_path / "grid.txt")], capture_output=True, text=True).stdout == "error -3\n"
+    assert subprocess.run([bench, str(tmp_path / "format.txt")], capture_output=True, text=True).stdout == "error -2\n"
+    assert subprocess.run([bench, str(tmp_path / "missing.txt")], capture_output=True, text=True).stdout == "error -1\n"
+
+
+def test_comp_benchmark(bench, tmp_path):
+    # 9 joints with 10k points, command and feedback per servo cycle
+    write_table(tmp_path / "comp.txt", 10001)
+    result = subprocess.run([bench, str(tmp_path / "comp.txt"), "200000", "9"], capture_output=True, text=True, check=True)
+    cycle_ns = float(result.stdout.split("\n")[1].split()[1])
+    print(f"compensation: {cycle_ns:0.1f}ns per servo cycle (9 joints)")
+    # far below 1% of a 1ms servo period
+    assert cycle_ns < 10000
@@ -0,0 +1,369 @@
+import shutil
+import struct
+import subprocess
+
+import pytest
+
+import emulator
+import frameio
+import projectLoader
+
+
+def load_layout():
+    project = projectLoader.load("tests/data/tangnano9k_1/config.json")
+    return project, frameio.layout(project)
+
+
+def test_layout_offsets():
+    project, layout = load_layout()
+    tx = frameio.field_offsets(layout["tx"])
+    rx = frameio.field_offsets(layout["rx"])
+
+    assert layout["size"] == project["data_size"] // 8
+    assert tx == {"header": 0, "jointFreqCmd": 4, "setPoint": 24, "jointEnable": 28, "outputs": 29}
+    assert rx == {"header": 0, "jointFeedback": 4, "processVariable": 24, "inputs": 28}
+
+
+def test_layout_hash(load_project):
+    project, layout = load_layout()
+    assert layout["hash"] == frameio.layout_hash(layout)
+    assert 0 <= layout["hash"] < 0x80000000
+    assert layout["hash"] not in (frameio.PRU_DATA, frameio.PRU_ESTOP)
+
+    # a changed layout has an other hash
+    changed = load_project(lambda jdata: jdata.update(timestamp=True))
+    assert frameio.layout(changed)["hash"] != layout["hash"]
+
+    # the answer to a read request carries the hash (spi: latched, one frame later)
+    frame = frameio.Frame(layout)
+    emu = emulator.Emulator(layout)
+    assert frame.unpack(emu.transfer(frame.pack({"header": frameio.PRU_READ}), now=0.0))["header"] == frameio.PRU_DATA
+    assert frame.unpack(emu.transfer(frame.build(), now=0.001))["header"] == layout["hash"]
+    assert frame.unpack(emu.transfer(frame.build(), now=0.002))["header"] == frameio.PRU_DATA
+    assert emu.errors == 0
+
+    # like the interfaces: read requests are latched (data applied), other headers are dropped
+    emu.transfer(frame.pack({"header": frameio.PRU_READ, "setPoint": [1234]}), now=0.003)
+    assert emu.setpoints == [1234]
+    assert frame.unpack(emu.transfer(frame.pack({"header": 0x12345678, "setPoint": [99]}), now=0.004))["header"] == layout["hash"]
+    assert emu.setpoints == [1234] and emu.header_rx == frameio.PRU_READ
+    assert frame.unpack(emu.transfer(frame.build(), now=0.005))["header"] == layout["hash"]
+    assert frame.unpack(emu.transfer(frame.build(), now=0.006))["header"] == frameio.PRU_DATA
+    assert emu.errors == 1
+
+    # the generated interfaces latch the read requests (the header_tx above depends on it),
+    # the header is compared as received: first byte in the msb
+    msgid = struct.unpack(">I", struct.pack("<I", frameio.PRU_WRITE))[0]
+    readid = struct.unpack(">I", struct.pack("<I", frameio.PRU_READ))[0]
+    for interface in ("interface_spislave", "interface_spislave_ram", "interface_uart", "interface_uart_ram", "interface_udp"):
+        source = open(f"plugins/{interface.rsplit('_ram', 1)[0]}/{interface}.v").read()
+        assert f"MSGID=32'h{msgid:08x}" in source
+        assert f"READID=32'h{readid:08x}" in source
+        assert "== READID" in source
+
+
+def test_layout_timestamp(load_project):
+    project = load_project(lambda jdata: jdata.update(timestamp=True))
+    layout = frameio.layout(project)
+    rx = frameio.field_offsets(layout["rx"])
+    assert rx == {"header": 0, "timestamp": 4, "jointFeedback": 8, "processVariable": 28, "inputs": 32}
+
+    frame = frameio.Frame(layout)
+    reply = frame.pack_answer({"header": frameio.PRU_DATA, "timestamp": 0xFFFFFFF0, "jointFeedback": [1, 2], "inputs": [0x80]})
+    parsed = frame.parse(reply)
+    assert parsed["timestamp"] == 0xFFFFFFF0
+    assert parsed["jointFeedback"] == [1, 2, 0, 0, 0]
+    assert parsed["dins"][0] == 1
+
+
+def test_layout_multirate(load_project):
+    def slow_vins(jdata):
+        for num, divisor in enumerate((10, 20, 5)):
+            jdata["plugins"].append({"type": "vin_frequency", "name": f"slow{num}", "pin": f"SLOW{num}", "divisor": divisor})
+
+    project = load_project(slow_vins)
+    layout = frameio.layout(project)
+    tx = frameio.field_offsets(layout["tx"])
+    rx = frameio.field_offsets(layout["rx"])
+    assert tx["slowSelect"] == 4
+    assert rx == {"header": 0, "jointFeedback": 4, "processVariable": 24, "slowIndex": 28, "slowValue": 32, "inputs": 36}
+    assert frameio.vin_slots(layout) == ([3], [0, 1, 2])
+
+    # earliest deadline first, every slow vin at least every divisor frames
+    due = [0, 1, 2]
+    last = [0, 0, 0]
+    gaps = [0, 0, 0]
+    for cycle in range(1, 101):
+        select = frameio.slow_schedule(due, [10, 20, 5], cycle)
+        gaps[select] = max(gaps[select], cycle - last[select])
+        last[select] = cycle
+    assert gaps[0] <= 10 and gaps[1] <= 20 and gaps[2] <= 5
+
+    # the answer carries the vin selected by the previous frame
+    frame = frameio.Frame(layout)
+    emu = emulator.Emulator(layout)
+    parsed = frame.parse(emu.transfer(frame.build([], [5.0]), now=0.0))
+    assert parsed["vinsAge"][1] is None
+    for num in range(20):
+        parsed = frame.parse(emu.transfer(frame.build([], [5.0]), now=num * 0.001))
+    assert parsed["vinsRaw"][0] == 135
+    assert parsed["vinsAge"][0] < 10
+
+
+def test_layout_dcservo(load_project):
+    dcservo = {"type": "joint_dcservo", "name": "dc0", "vmax": 100000, "pins": {"pwm": "DC_PWM", "dir": "DC_DIR", "enc_a": "DC_A", "enc_b": "DC_B"}}
+    project = load_project(lambda jdata: jdata["plugins"].append(dcservo))
+    layout = frameio.layout(project)
+    tx = frameio.field_offsets(layout["tx"])
+    assert project["joints_velocity"] == [0]
+    assert tx["jointFreqCmd"] == 4 and tx["jointVelCmd"] == 28 and tx["setPoint"] == 32
+    assert layout["joints"][0] == {"name": "dc0", "type": "dcservo", "feedback": "abs"}
+
+    # 100kHz pwm, 20kHz loop, feed forward from vmax
+    params = project["plugins"]["joint_dcservo"].params(dcservo)
+    assert params["PWM_PERIOD"] == 270 and params["LOOP_DIV"] == 1350 and params["KFF"] == 13824
+
+    # position in counts, the emulated servo follows at once
+    frame = frameio.Frame(layout)
+    emu = emulator.Emulator(layout)
+    data = frame.build([1234, 100, 100, 100, 100, 100], [0.0], [1] * 6, joint_velocities=[5000])
+    assert struct.unpack_from("<i", data, tx["jointFreqCmd"])[0] == 1234
+    assert struct.unpack_from("<i", data, tx["jointVelCmd"])[0] == 5000
+    emu.transfer(data, now=0.0)
+    parsed = frame.parse(emu.transfer(data, now=0.001))
+    assert parsed["jointFeedback"][0] == 1234
+
+
+def test_layout_gear(load_project):
+    def gear(name):
+        # JOINT2 follows an encoder, named or with the default name of the loader (PV.<num>)
+        def mutate(jdata):
+            encoder = {"type": "vin_quadencoderz", "pins": {"a": "SP_A", "b": "SP_B", "z": "SP_Z"}}
+            if name:
+                encoder["name"] = name
+            jdata["plugins"].append(encoder)
+            for plugin in jdata["plugins"]:
+                if plugin.get("name") == "JOINT2":
+                    plugin["gear"] = name or f"PV.{len(jdata['plugins']) - 1}"
+
+        return mutate
+
+    project = load_project(gear("spindle"))
+    layout = frameio.layout(project)
+    tx = frameio.field_offsets(layout["tx"])
+    assert project["joints_gear"] == [{"joint": 2, "vin": 0}]
+    assert tx["jointGearRatio"] == 24 and tx["setPoint"] == 28
+    assert layout["joints"][2]["gear"] == 0
+    assert "        .gearPos (SPINDLE)," in project["plugins"]["joint_stepper"].funcs()
+
+    # encoder without a name
+    unnamed = load_project(gear(None))
+    encoder = len(unnamed["jdata"]["plugins"]) - 1
+    assert unnamed["joints_gear"] == [{"joint": 2, "vin": 0}]
+    assert f"        .gearPos (PV{encoder})," in unnamed["plugins"]["joint_stepper"].funcs()
+
+    # steps per encoder count in Q16.16
+    assert frameio.gear_to_cmd(2.5) == 0x28000
+    assert frameio.gear_to_cmd(-0.25) == -0x4000
+    frame = frameio.Frame(layout)
+    data = frame.build([0] * 5, [0.0], [1] * 5, joint_gears=[1.5])
+    assert struct.unpack_from("<i", data, tx["jointGearRatio"])[0] == 0x18000
+
+
+def test_layout_soe(load_project):
+    project = load_project(lambda jdata: jdata["plugins"].append({"type": "din_soe", "inputs": ["DIN0", "DIN3"], "slots": 2}))
+    layout = frameio.layout(project)
+    tx = frameio.field_offsets(layout["tx"])
+    rx = frameio.field_offsets(layout["rx"])
+    assert project["timestamp"]
+    assert tx["soeAck"] == 4 and tx["jointFreqCmd"] == 8
+    assert rx["soeStatus"] == 32 and rx["soeEvents"] == 36 and rx["inputs"] == 52
+    assert layout["soe"] == {"slots": 2, "inputs": ["DIN0", "DIN3"], "dins": [0, 3]}
+
+    # slots out of order or already acknowledged are skipped
+    words = [100, (1 << 31) | (1 << 30) | (1 << 16) | 6, 90, (1 << 31) | 5]
+    events, expected = frameio.soe_decode(words, 5)
+    assert [event["seq"] for event in events] == [5] and expected == 6
+    events, expected = frameio.soe_decode(words, 6)
+    assert events == [{"seq": 6, "tick": 100, "input": 1, "level": 1}]
+
+    # four edges, two slots per frame: the later ones come with the next frames
+    frame = frameio.Frame(layout)
+    emu = emulator.Emulator(layout)
+    sequence = [[0, 0, 0, 0], [1, 0, 0, 1], [0, 0, 0, 1], [0] * 4, [0] * 4]
+    received = []
+    for num, douts in enumerate(sequence):
+        parsed = frame.parse(emu.transfer(frame.build([], [], [], douts), now=num * 0.001))
+        received += parsed["soe"]
+    assert [(event["input"], event["level"]) for event in received] == [(0, 1), (1, 1), (0, 0), (1, 0)]
+    assert received[2]["tick"] == 2 * 27000
+    assert parsed["soeLost"] == 0
+
+
+def test_layout_sonar_rcservo(load_project, tmp_path):
+    # vin_sonar and vout_rcservo are converted (they were sent raw before)
+    def plugins(jdata):
+        jdata["plugins"].append({"type": "vin_sonar", "name": "dist", "pins": {"trigger": "SO_T", "echo": "SO_E"}})
+        jdata["plugins"].append({"type": "vout_rcservo", "name": "servo", "frequency": "50", "pin": "SERVO"})
+
+    project = load_project(plugins)
+    layout = frameio.layout(project)
+    osc = layout["clock"]
+    sonar = [vin for vin in layout["vins"] if vin["name"] == "dist"][0]
+    servo = [vout for vout in layout["vouts"] if vout["name"] == "servo"][0]
+    assert sonar == {"name": "dist", "type": "sonar"}
+    assert servo == {"name": "servo", "min": -100, "max": 100.0, "freq": 50, "type": "rcservo"}
+
+    # echo of 1ms (27000 clocks)
+    assert round(frameio.vin_from_raw(sonar, 27000, osc), 6) == 17.16
+    # 0 -> 300 * osc / 200000, 1.5ms pulse
+    assert frameio.vout_to_setpoint(servo, 0.0, osc) == 300 * 135
+    assert frameio.vout_to_setpoint(servo, 100.0, osc) == 400 * 135
+
+    # rio.c uses the conversions of the plugins
+    project["LINUXCNC_PATH"] = str(tmp_path)
+    (tmp_path / "Components").mkdir()
+    project["generators"]["linuxcnc_component"].generate_convert(project, layout)
+    convert = (tmp_path / "Components" / "rio_convert.h").read_text()
+    assert f"    vin_convert_sonar({layout['vins'].index(sonar)}, " in convert
+    assert f"    tx->setPoint[{layout['vouts'].index(servo)}] = vout_convert_rcservo(" in convert
+
+
+def test_layout_ads1115_seq(load_project, tmp_path):
+    # the sample count (-seq pin) only in continuous mode
+    def plugins(jdata):
+        jdata["plugins"].append({"type": "vin_ads1115", "name": "adc", "pins": {"sda": "AD_SDA", "scl": "AD_SCL"}})
+        jdata["plugins"].append({"type": "vin_ads1115", "name": "cont", "mode": "continuous", "pins": {"sda": "AC_SDA", "scl": "AC_SCL", "alert": "AC_ALERT"}})
+
+    project = load_project(plugins)
+    layout = frameio.layout(project)
+    types = {vin["name"].split(".")[0]: vin["type"] for vin in layout["vins"] if vin["name"].startswith(("adc.", "cont."))}
+    assert types == {"adc": "adc", "cont": "adc_seq"}
+
+    project["LINUXCNC_PATH"] = str(tmp_path)
+    (tmp_path / "Components").mkdir()
+    project["generators"]["linuxcnc_component"].generate_convert(project, layout)
+    convert = (tmp_path / "Components" / "rio_convert.h").read_text()
+    single = convert.split("static inline void vin_convert_adc(")[1].split("}\n")[0]
+    assert "processVariableExtra" not in single
+    assert "*(data->processVariableExtra[i][0]) = raw >> 16;" in convert.split("static inline void vin_convert_adc_seq(")[1]
+
+
+def test_conversions():
+    _project, layout = load_layout()
+    osc = layout["clock"]
+
+    assert frameio.joint_to_cmd(layout["joints"][0], 1000, osc) == 13500
+    assert frameio.joint_to_cmd({"type": "rcservo"}, 1000, osc) == 27000
+    assert frameio.joint_to_cmd({"type": "pwmdir"}, -1234, osc) == -1234
+    assert frameio.joint_to_cmd(layout["joints"][0], 0, osc) == 0
+
+    # vout_pwm: duty in % (max 100), vout_sine: 30 steps per period
+    assert layout["vouts"][0]["max"] == 100.0
+    assert frameio.vout_to_setpoint(layout["vouts"][0], 5.0, osc) == 135
+    assert frameio.vout_conversion({"type": "vout_pwm", "dir": True, "min": -50}) == {"min": 0, "max": 100.0, "freq": 10000, "type": "pwmdir"}
+    assert frameio.vout_conversion({"type": "vout_sine"}) == {"min": -100, "max": 100.0, "freq": 30, "type": "sine"}
+    assert frameio.vout_to_setpoint(frameio.vout_conversion({"type": "vout_sine"}), 10.0, osc) == 90000
+    assert frameio.vout_to_setpoint({"type": "rcservo"}, 0, osc) == 300 * 135
+    assert frameio.vout_conversion({"type": "vout_rcservo"}) == {"min": -100, "max": 100.0, "freq": 100, "type": "rcservo"}
+    assert frameio.vin_conversion({"type": "vin_sonar"}) == {"type": "sonar"}
+    assert frameio.vin_from_raw({"type": "sonar"}, 1000, osc) == 1000.0 / osc / 20.0 * 1000 * 343.2
+    assert frameio.vout_to_setpoint({"type": "frequency"}, 1000, osc) == 27000
+    # hires pwm: duty in clock cycles with 16 fractional bits (not truncated)
+    assert frameio.vout_conversion({"type": "vout_pwm", "hires": True})["type"] == "pwm_hires"
+    assert frameio.vout_to_setpoint({"type": "pwm_hires", "min": 0, "max": 100.0, "freq": 100000}, 33.3, osc) == round(89.91 * 65536)
+    assert frameio.vout_to_setpoint({"type": "pwmdir_hires", "max": 100.0, "freq": 100000}, -50.0, osc) == -135 * 65536
+
+    assert frameio.vin_from_raw({"type": "frequency"}, 27000, osc) == 1000.0
+    assert frameio.vin_from_raw({"type": "adc"}, 3300, osc) == 3.3
+    # vin_ads1115 continuous mode: sample count in bits 16-23
+    assert frameio.vin_conversion({"type": "vin_ads1115"}) == {"type": "adc"}
+    assert frameio.vin_conversion({"type": "vin_ads1115", "mode": "continuous"}) == {"type": "adc_seq"}
+    assert frameio.vin_conversion({"type": "vin_ads1115", "mode": "continuous", "sensor": "NTC"}) == {"type": "ntc_seq"}
+    assert frameio.vin_from_raw({"type": "adc_seq"}, (17 << 16) | 3300, osc) == 3.3
+    assert round(frameio.vin_from_raw({"type": "ntc"}, 1650, osc), 2) == 25.0
+
+
+def test_frame_roundtrip():
+    _project, layout = load_layout()
+    frame = frameio.Frame(layout)
+
+    data = frame.build([1000, 0, -1000, 0, 0], [5.0], [1, 0, 1, 0, 1], [1, 0, 0, 1])
+    assert len(data) == layout["size"]
+    assert data[0:4] == bytes([0x74, 0x69, 0x72, 0x77])
+    assert data[28] == 0b00010101
+    assert data[29] == 0b10010000
+
+    # answer frame as sent by the fpga
+    reply = frame.rx_struct.pack(frameio.PRU_DATA, 1, 2, 3, 4, -5, 27000, 0b10000000, 0, 0)
+    parsed = frame.parse(reply)
+    assert parsed["header"] == frameio.PRU_DATA
+    assert parsed["jointFeedback"] == [1, 2, 3, 4, -5]
+    assert parsed["processVariable"] == [27000]
+    assert parsed["dins"][0] == 1
+    assert parsed["dins"][1] == 0
+
+
+def vin_scale(params, raw):
+    # integer model of generators/firmware/vin_scale.v
+    sign = (raw < 0) != bool(params["MUL_NEG"])
+    if params["RECIPROCAL"]:
+        value = params["NUMERATOR"] // abs(raw) if raw else 0
+    else:
+        value = (abs(raw) * params["MUL"]) >> params["SHIFT"]
+    value = min(value, 0x7FFFFFFF)
+    return -value if sign else value
+
+
+def test_vin_fixed():
+    osc = 27000000
+    assert frameio.vin_conversion({"type": "vin_frequency", "fixed": True}) == {"type": "fixed", "source": "frequency", "scale": 1.0}
+    assert frameio.vin_conversion({"type": "vin_quadencoder", "fixed": True}) == {"type": "encoder"}
+
+    for source, raw in (("frequency", 27000), ("frequency", -2700), ("time", 13500), ("adc", 1234), ("adc", -3300)):
+        for scale in (1.0, -2.5, 0.001):
+            conv = {"type": "fixed", "source": source, "scale": scale}
+            params = frameio.vin_fixed_params(conv, osc)
+            assert params["MUL"] < (1 << 31)
+            expected = frameio.vin_from_raw({"type": source}, raw, osc) * scale
+            value = frameio.vin_from_raw(conv, vin_scale(params, raw), osc)
+            assert abs(value - expected) <= max(abs(expected) * 1e-6, 2.0 / frameio.FIXED_ONE)
+    assert frameio.vin_fixed_params({"type": "fixed", "source": "frequency", "scale": 1.0}, osc)["NUMERATOR"] == osc * 65536
+
+
+def test_frame_codec(load_project, tmp_path):
+    # the generated rio_frame.h packs like frameio.Frame.build() and unpacks like Frame.unpack()
+    if shutil.which("gcc") is None:
+        pytest.skip("no gcc")
+
+    def joints(jdata):
+        for plugin in jdata["plugins"]:
+            if plugin["name"] == "JOINT3":
+                plugin.update(type="joint_rcservo", pins={"pwm": "40", "dir": "34"})
+            elif plugin["name"] == "JOINT4":
+                plugin.update(type="joint_pwmdir", pins={"pwm": "57", "dir": "56"})
+
+    project = load_project(joints)
+    layout = frameio.layout(project)
+    assert sorted(joint["type"] for joint in layout["joints"]) == ["pwmdir", "rcservo", "stepper", "stepper", "stepper"]
+    project["LINUXCNC_PATH"] = str(tmp_path)
+    (tmp_path / "Components").mkdir()
+    project["generators"]["linuxcnc_component"].generate(project)
+    binary = tmp_path / "rio_frame_test"
+    subprocess.run(
+        ["gcc", "-O2", "-Wall", "-I", str(tmp_path / "Components"), "-o", str(binary), "tests/rio_frame_test.c"],
+        check=True,
+    )
+
+    frame = frameio.Frame(layout)
+    freqs = [1000.0, -2500.5, 0.0, 0.1, -1234.0]
+    enables = [1, 0, 1, 1, 0]
+    douts = [1, 0, 0, 1, 1, 0, 1, 0, 0, 1, 1, 1]
+    dins = [1, 1, 0, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 1]
+    answer = frame.pack_answer({"header": frameio.PRU_DATA, "inputs": frame.pack_bits(dins, 3)})
+    stdin = " ".join(str(value) for value in freqs + enables + douts) + "\n" + answer.hex(" ") + "\n"
+    result = subprocess.run([str(binary)], input=stdin, capture_output=True, text=True, check=True)
+    output = {line.split()[0]: line.split()[1:] for line in result.stdout.strip().split("\n")}
+
+    assert bytes.fromhex("".join(output["tx"])) == frame.build(joint_freqs=freqs, joint_enables=enables, douts=douts)
+    assert [int(bit) for bit in output["in"]] == frame.unpack_bits(frame.unpack(answer)["inputs"], len(dins)) == dins
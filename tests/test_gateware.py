@@ -0,0 +1,114 @@
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+import pytest
+
+# the self-checking testbenches of the plugins (they print OK or FAILED), sources like the Makefiles
+TESTBENCHES = {
+    "din_soe": ("plugins/din_soe/testb.v", "plugins/din_soe/din_soe.v"),
+    "interface_spislave_ram": ("plugins/interface_spislave/testb_ram.v", "plugins/interface_spislave/interface_spislave_ram.v", "generators/firmware/frame_ram.v"),
+    "joint_dcservo": ("plugins/joint_dcservo/testb.v", "plugins/joint_dcservo/joint_dcservo.v"),
+    "joint_stepper_gear": ("plugins/joint_stepper/testb_gear.v", "plugins/joint_stepper/joint_stepper_gear.v"),
+    "joint_stepper_mux": ("plugins/joint_stepper_mux/testb.v", "plugins/joint_stepper_mux/joint_stepper_mux.v", "plugins/joint_stepper/joint_stepper.v"),
+    "joint_stepper_pipe": ("plugins/joint_stepper/testb_pipe.v", "plugins/joint_stepper/joint_stepper_pipe.v", "plugins/joint_stepper/joint_stepper.v"),
+    "vout_pwm_hires": ("plugins/vout_pwm/testb_hires.v", "plugins/vout_pwm/vout_pwm.v"),
+}
+
+# the modules of the plugins, synthesized for ice40 (top, sources)
+MODULES = {
+    "din_soe": ("plugins/din_soe/din_soe.v",),
+    "interface_spislave_ram": ("plugins/interface_spislave/interface_spislave_ram.v", "generators/firmware/frame_ram.v"),
+    "interface_uart_ram": ("plugins/interface_uart/interface_uart_ram.v", "generators/firmware/frame_ram.v", "generators/firmware/uart_rx.v", "generators/firmware/uart_tx.v"),
+    "interface_udp": ("plugins/interface_udp/interface_udp.v", "plugins/interface_udp/interface_udp_mdio.v"),
+    "joint_dcservo": ("plugins/joint_dcservo/joint_dcservo.v",),
+    "joint_stepper_gear": ("plugins/joint_stepper/joint_stepper_gear.v",),
+    "joint_stepper_mux": ("plugins/joint_stepper_mux/joint_stepper_mux.v", "plugins/joint_stepper/joint_stepper.v"),
+    "joint_stepper_pipe": ("plugins/joint_stepper/joint_stepper_pipe.v",),
+    "vin_ads1115": ("plugins/vin_ads1115/vin_ads1115.v",),
+    "vin_ads1115_cont": ("plugins/vin_ads1115/vin_ads1115.v",),
+    "vout_pwm_hires": ("plugins/vout_pwm/vout_pwm.v",),
+}
+
+
+def run_testbench(sources, workdir):
+    binary = str(workdir / "testb.out")
+    subprocess.run(["iverilog", "-Wall", "-o", binary] + [os.path.abspath(source) for source in sources], check=True)
+    return subprocess.run(["vvp", binary], cwd=workdir, capture_output=True, text=True, check=True).stdout
+
+
+def synth(top, sources, params=""):
+    # yosys stat of the module on ice40
+    result = subprocess.run(
+        ["yosys", "-q", "-p", f"{params}synth_ice40 -top {top}; tee -o /dev/stdout stat"] + list(sources),
+        capture_output=True,
+        text=True,
+        check=True,
+    )
+    print(result.stdout)
+    return result.stdout
+
+
+def cells(stat, cell):
+    match = re.search(rf"^\s*{cell}\s+(\d+)\s*$", stat, re.MULTILINE)
+    return int(match.group(1)) if match else 0
+
+
+@pytest.mark.parametrize("name", sorted(TESTBENCHES))
+def test_testbench(name, tmp_path):
+    if shutil.which("iverilog") is None:
+        pytest.skip("no iverilog")
+    output = run_testbench(TESTBENCHES[name], tmp_path)
+    assert "FAILED" not in output and "ERROR" not in output
+    assert "OK" in output.split("\n")
+
+
+def test_testbench_udp(tmp_path):
+    # the frames of testb_frames.py through interface_udp, the answers against the expected ones
+    if shutil.which("iverilog") is None:
+        pytest.skip("no iverilog")
+    subprocess.run([sys.executable, os.path.abspath("plugins/interface_udp/testb_frames.py")], cwd=tmp_path, check=True)
+    run_testbench(("plugins/interface_udp/testb.v", "plugins/interface_udp/interface_udp.v", "plugins/interface_udp/interface_udp_mdio.v"), tmp_path)
+    assert (tmp_path / "testb_out.hex").read_text() == (tmp_path / "testb_expected.hex").read_text()
+
+
+@pytest.mark.parametrize("top", sorted(MODULES))
+def test_synth(top):
+    if shutil.which("yosys") is None:
+        pytest.skip("no yosys")
+    assert "Number of cells" in synth(top, MODULES[top])
+
+
+def test_synth_stepper_mux():
+    # the README table of joint_stepper_mux: 5 joints need less logic than 5 joint_stepper
+    if shutil.which("yosys") is None:
+        pytest.skip("no yosys")
+    single = synth("joint_stepper", ("plugins/joint_stepper/joint_stepper.v",))
+    mux = synth("joint_stepper_mux", MODULES["joint_stepper_mux"], "chparam -set JOINTS 5 joint_stepper_mux; ")
+    assert 0 < cells(mux, "SB_LUT4") < 5 * cells(single, "SB_LUT4")
+
+
+def fmax(top, sources, workdir):
+    # nextpnr Fmax on an ice40 hx8k (like `make timing` in plugins/joint_stepper)
+    netlist = str(workdir / f"{top}.json")
+    subprocess.run(["yosys", "-q", "-p", f"synth_ice40 -top {top} -json {netlist}"] + list(sources), check=True)
+    result = subprocess.run(
+        ["nextpnr-ice40", "--hx8k", "--package", "ct256", "--json", netlist, "--pcf-allow-unconstrained", "--freq", "200"],
+        capture_output=True,
+        text=True,
+        check=True,
+    )
+    found = re.findall(r"Max frequency for clock '[^']*': ([0-9.]+) MHz", result.stderr + result.stdout)
+    print(f"{top}: {found[-1]} MHz")
+    return float(found[-1])
+
+
+def test_timing_stepper_pipe(tmp_path):
+    # the pipelined joint_stepper has to be at least as fast as joint_stepper
+    if shutil.which("yosys") is None or shutil.which("nextpnr-ice40") is None:
+        pytest.skip("no yosys/nextpnr-ice40")
+    single = fmax("joint_stepper", ("plugins/joint_stepper/joint_stepper.v",), tmp_path)
+    pipe = fmax("joint_stepper_pipe", MODULES["joint_stepper_pipe"], tmp_path)
+    assert pipe >= single
@@ -8,7 +8,7 @@ def test_generator():
 
     configfile = f"tests/data/{name}/config.json"
     #testfiles = ("Firmware/rio.v", "LinuxCNC/Components/rio.h", "LinuxCNC/ConfigSamples/rio/rio.hal", "LinuxCNC/ConfigSamples/rio/rio.ini")
-    testfiles = ("LinuxCNC/Components/rio.h", "LinuxCNC/ConfigSamples/rio/rio.hal", "LinuxCNC/ConfigSamples/rio/rio.ini")
+    testfiles = ("LinuxCNC/Components/rio.h", "LinuxCNC/Components/rio_convert.h", "LinuxCNC/Components/rio_frame.h", "LinuxCNC/ConfigSamples/rio/rio.hal", "LinuxCNC/ConfigSamples/rio/rio.ini")
     outputdir = f"tests/Output/{name}"
     osscadsuitePath = "/opt/oss-cad-suite/bin"
 
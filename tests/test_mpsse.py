@@ -0,0 +1,73 @@
+
+import shutil
+import subprocess
+
+import pytest
+
+import timing
+
+
+@pytest.fixture(scope="module")
+def bench(tmp_path_factory):
+    # rio_mpsse.h is plain C, built with the host compiler against the libftdi mock
+    if shutil.which("gcc") is None:
+        pytest.skip("no gcc")
+    binary = tmp_path_factory.mktemp("mpsse") / "rio_mpsse_test"
+    subprocess.run(
+        ["gcc", "-O2", "-Wall", "-I", "tests/mock", "-I", "generators/linuxcnc_component", "-o", str(binary), "tests/rio_mpsse_test.c"],
+        check=True,
+    )
+    return str(binary)
+
+
+def run(bench, *args):
+    result = subprocess.run([bench] + [str(arg) for arg in args], capture_output=True, text=True, check=True)
+    return {line.split()[0]: line.split()[1:] for line in result.stdout.strip().split("\n")}, result.stdout
+
+
+def test_mpsse_frame(bench):
+    lines, stdout = run(bench, 16)
+    assert stdout.startswith("open -2\nopen 0\nlatency 1 bitmode 2\n")
+    # no divide by 5, no adaptive/3-phase clocking, divisor 2 (10MHz), cs (ADBUS3) and reset (ADBUS7) high
+    assert lines["setup"] == "8a 97 8d 85 86 02 00 80 88 8b".split()
+    # one usb write per frame: cs low, 16 bytes full duplex, cs high, send immediate
+    data = [f"{n:02x}" for n in range(16)]
+    assert lines["cmd"] == ["80", "80", "8b", "31", "0f", "00"] + data + ["80", "88", "8b", "87"]
+    assert lines["rx"] == [f"{0xa0 ^ n:02x}" for n in range(16)]
+    assert lines["transfer"] == ["16", "reads", "1"]
+
+
+def test_mpsse_pipelined(bench):
+    lines, stdout = run(bench, 300)
+    # the answer is read in 64 byte chunks
+    assert lines["transfer"] == ["300", "reads", "5"]
+    assert "submit 0 pending 1\nwait 300 pending 0\nwait 300 first 55\nmosi 600\n" in stdout
+    # nothing pending, frame too big
+    assert lines["wait"] == ["-1"]
+    assert lines["oversize"] == ["-4"]
+
+
+def test_mpsse_configure(bench):
+    # ice40 spi slave configuration, larger than one usb write
+    lines, stdout = run(bench, 16, 20000)
+    assert "configure 0 slave 1\nconfig 20000 match 1\n" in stdout
+    # cdone stays low
+    assert lines["configure"] == ["-5"]
+
+
+def test_mpsse_timing():
+    project = {
+        "data_size": 64 * 8,
+        "jdata": {"transport": "MPSSE", "clock": {"speed": "50250000"}, "interface": [{"type": "spi"}], "timing": {}},
+    }
+    # the spi slave samples SCK with the fpga clock (3 flip-flops): 6.28MHz max -> 6MHz (divisor 4)
+    assert timing.mpsse_divisor(project) == 4
+    result = timing.model(project)
+    assert result["mpsse_divisor"] == 4
+    assert round(result["transfer_time"] * 1000000) == round(64 * 8 / 6.0 + timing.OVERHEAD["MPSSE"])
+    project["jdata"]["clock"]["speed"] = "200000000"
+    assert timing.mpsse_divisor(project) == 1
+    project["jdata"]["clock"]["speed"] = "240000000"
+    assert timing.mpsse_divisor(project) == 0
+    project["jdata"]["timing"] = {"mpsse_clock": 6000000}
+    assert timing.mpsse_divisor(project) == 4
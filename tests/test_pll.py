@@ -0,0 +1,73 @@
+
+import json
+
+import clocktune
+import projectLoader
+from generators.firmware import pll
+
+
+def test_pll_ice40():
+    # icepll -i 12 -o 50.25
+    setup = pll.settings("ice40", "hx8k", 12, 50.25)
+    assert (setup["DIVR"], setup["DIVF"], setup["DIVQ"], setup["FILTER_RANGE"]) == (0, 66, 4, 1)
+    assert "SB_PLL40_CORE" in pll.verilog(setup)
+    assert ".PACKAGEPIN(clock_in)" in pll.verilog(pll.settings("ice40", "up5k", 12, 50.25))
+
+
+def test_pll_ecp5_gowin():
+    setup = pll.settings("ecp5", "25k", 25, 100)
+    assert setup["freq"] == 100
+    assert 400 <= setup["VCO"] <= 800
+    assert setup["CLKOP_DIV"] * 100 == setup["VCO"]
+    setup = pll.settings("GW1N-9C", "GW1NR-LV9QN88PC6/I5", 27, 108)
+    assert (setup["IDIV_SEL"], setup["FBDIV_SEL"], setup["freq"]) == (0, 3, 108)
+    assert "rPLL" in pll.verilog(setup)
+    assert pll.settings("xc7", "xc7a35ticsg324-1l", 100, 100) is None
+
+
+def test_pll_frequencies():
+    for family, ftype, fin in (("ice40", "hx8k", 12), ("ecp5", "25k", 25), ("GW1N-9C", "", 27)):
+        freqs = pll.frequencies(family, ftype, fin, 40, 150)
+        assert freqs == sorted(set(freqs))
+        assert 40 <= freqs[0] and freqs[-1] <= 150
+        # every listed frequency is reachable
+        for freq in freqs[::10]:
+            assert abs(pll.settings(family, ftype, fin, freq)["freq"] - freq) < 0.000001
+
+
+def test_pll_speed(tmp_path):
+    # the achieved sysclk replaces clock: speed (PRU_OSC)
+    jdata = json.loads(open("configs/ICEBreakerV1.0e/config.json").read())
+    jdata["clock"]["speed"] = "50000000"
+    config = tmp_path / "config.json"
+    config.write_text(json.dumps(jdata))
+    project = projectLoader.load(str(config))
+    assert project["jdata"]["clock"]["speed"] == "50250000"
+    assert project["pll"]["freq"] == 50.25
+
+
+def test_clocktune_sweep():
+    log = (
+        "Info: Max frequency for clock 'sysclk_in$SB_IO_IN': 201.00 MHz (PASS at 12.00 MHz)\n"
+        "Info: Max frequency for clock 'sysclk': 71.20 MHz (PASS at 60.00 MHz)\n"
+        "Info: Max frequency for clock 'sysclk': 68.03 MHz (FAIL at 70.00 MHz)\n"
+    )
+    assert clocktune.parse_fmax(log) == (68.03, False)
+    assert clocktune.parse_fmax("") is None
+
+    jdata = {"family": "ice40", "type": "up5k", "clock": {"osc": "12000000", "speed": "50250000"}}
+    speeds = clocktune.candidates(jdata, 50000000, 100000000, 2000000)
+    assert speeds[0] >= 50000000 and speeds[-1] <= 100000000
+    assert all(b - a >= 2000000 for a, b in zip(speeds, speeds[1:]))
+
+    # timing closes up to 72MHz: the highest passing frequency, no build after the first failure
+    built = []
+
+    def fake_build(speed):
+        built.append(speed)
+        return (72.5, speed <= 72000000)
+
+    best = clocktune.sweep(speeds, fake_build)
+    assert best == max(speed for speed in speeds if speed <= 72000000)
+    assert built[-1] > 72000000
+    assert len(built) == len([speed for speed in speeds if speed <= 72000000]) + 1
@@ -0,0 +1,57 @@
+import emulator as emulator_module
+import frameio
+import projectLoader
+import soaktest
+
+
+def load_layout():
+    project = projectLoader.load("tests/data/tangnano9k_1/config.json")
+    return frameio.layout(project)
+
+
+def test_soaktest_emulator():
+    layout = load_layout()
+    transport = soaktest.EmulatorTransport(layout)
+
+    stats = soaktest.run(layout, transport, rate=2000, duration=0.5, period=0.2, loopback=True)
+    assert stats.frames > 100
+    assert stats.lost == 0
+    assert stats.mismatches == {}
+    assert sum(stats.histogram) == stats.frames
+
+
+def test_soaktest_detects_errors():
+    layout = load_layout()
+
+    class BrokenTransport(soaktest.EmulatorTransport):
+        def transfer(self, data):
+            answer = bytearray(super().transfer(data))
+            if self.emulator.frames % 10 == 0:
+                return None
+            # stuck digital input
+            answer[layout["rx"][-1]["offset"]] |= 0x80
+            return bytes(answer)
+
+    stats = soaktest.run(layout, BrokenTransport(layout), rate=2000, duration=0.2, period=0.2, loopback=True)
+    assert stats.lost > 0
+    assert stats.mismatches.get("din0", 0) > 0
+
+
+def test_emulator_apply_time(load_project):
+    layout = frameio.layout(load_project(lambda jdata: jdata.update(apply_time=True)))
+    frame = frameio.Frame(layout)
+    osc = layout["clock"]
+
+    def request(freq, apply_time):
+        data = frame.build([freq, 0, 0, 0, 0], [], [1, 0, 0, 0, 0])
+        return data[:4] + apply_time.to_bytes(4, "little") + data[8:]
+
+    emulator = emulator_module.Emulator(layout)
+    emulator.transfer(request(1000, 0), now=1.0)
+    # new command is applied 0.5ms after the arrival of the frame
+    emulator.transfer(request(0, int(1.0015 * osc)), now=1.001)
+    assert emulator.joint_cmd[0] != 0
+    emulator.transfer(request(0, 0), now=1.003)
+    assert emulator.joint_cmd[0] == 0
+    steps = frameio.cmd_to_joint(layout["joints"][0], frameio.joint_to_cmd(layout["joints"][0], 1000, osc), osc)
+    assert abs(emulator.position[0] - steps * 0.0015) < steps * 0.00001
@@ -0,0 +1,80 @@
+
+import json
+
+import pytest
+
+import scaling
+import timing
+
+
+def make_project(transport="SPI", data_size=31 * 8, baud=1000000, options=None):
+    return {
+        "data_size": data_size,
+        "jdata": {
+            "transport": transport,
+            "clock": {"speed": "27000000"},
+            "interface": [{"type": "uart", "baud": baud}],
+            "timing": options or {},
+        },
+    }
+
+
+def test_timing_spi():
+    result = timing.model(make_project())
+    assert result["servo_period"] == 1000000
+    assert result["warnings"] == []
+    assert round(result["transfer_time"] * 1000000) == 300
+    assert result["timeout"] == 2700000
+
+
+def test_timing_serial_period():
+    # 2 * 200 bytes * 10 bits at 1Mbaud do not fit into 1ms
+    result = timing.model(make_project("SERIAL", data_size=200 * 8))
+    assert result["servo_period"] == 10000000
+    assert len(result["warnings"]) == 1
+
+    result = timing.model(make_project("SERIAL", data_size=30 * 8))
+    assert result["servo_period"] == 2000000
+
+
+def test_timing_fixed_period():
+    with pytest.raises(timing.TimingError):
+        timing.model(make_project("SERIAL", data_size=200 * 8, options={"servo_period": 1000000}))
+
+    result = timing.model(make_project("UDP", options={"servo_period": 2000000}))
+    assert result["servo_period"] == 2000000
+    assert result["pid_p"] < timing.model(make_project("UDP"))["pid_p"]
+
+
+def test_timing_aux_period():
+    assert timing.model(make_project())["aux_period"] is None
+    assert timing.model(make_project(options={"aux_period": 10000000}))["aux_period"] == 10000000
+    with pytest.raises(timing.TimingError):
+        timing.model(make_project(options={"aux_period": 1500000}))
+
+
+def test_timing_spi_clock():
+    with pytest.raises(timing.TimingError):
+        timing.model(make_project(options={"spi_divider": 8}))
+
+
+def test_timing_native_udp():
+    bridge = timing.transfer_time(make_project("UDP"))
+    project = make_project("UDP")
+    project["jdata"]["interface"] = [{"type": "udp"}]
+    native = timing.transfer_time(project)
+    assert native < bridge
+    assert round(native * 1000000) == 116
+
+
+def test_scaling():
+    with open("tests/data/tangnano9k_1/config.json", "r") as ifile:
+        jdata = json.load(ifile)
+    rows = scaling.run(jdata, steps=((8, 64), (256, 1024)), frames=2)
+    assert rows[0]["bytes"] < rows[1]["bytes"]
+    assert rows[0]["servo_period"] is not None
+    assert rows[1]["transfer"]["udp"] < rows[1]["transfer"]["spi"]
+
+    # 65535 spi bits
+    rows = scaling.run(jdata, steps=((2048, 8),), frames=2)
+    assert "error" in rows[0]
@@ -0,0 +1,163 @@
+#
+# timing model of the host <-> fpga transfer
+#
+# estimates the duration of one frame exchange for the configured transport
+# and selects the servo period, the interface timeout and the pid defaults
+#
+# optional config section:
+#   "timing": {
+#       "servo_period": 1000000,    (ns, fixed servo period, fails if the transfer does not fit)
+#       "max_load": 0.5,            (part of the servo period that can be used for the transfer)
+#       "overhead": 300,            (us, fixed overhead per transfer, default depends on the transport)
+#       "spi_divider": 256,         (bcm2835 spi clock divider)
+#       "mpsse_clock": 30000000,    (Hz, max spi clock of the ftdi MPSSE transport)
+#       "bridge_clock": 2000000,    (spi clock of the udp2spi bridge, not used with interface_udp)
+#       "timeout": 100,             (interface timeout in servo periods)
+#       "aux_period": 10000000      (ns, vins, vouts and digital i/o in rio.aux, in a slower thread)
+#   }
+#
+
+import math
+
+BCM2835_CORE_CLOCK = 250000000
+BCM2835_DIVIDERS = (2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536)
+
+# fixed overhead per transfer in us
+OVERHEAD = {
+    # bcm2835_spi_transfer() per byte
+    "SPI": 1.5,
+    # usb-serial latency (low_latency mode)
+    "SERIAL": 250.0,
+    # network round trip and bridge processing
+    "UDP": 300.0,
+    # network round trip, the fpga answers in hardware (interface_udp)
+    "UDP_NATIVE": 100.0,
+    # usb high speed round trip, one bulk write and read (latency timer 1ms, send immediate)
+    "MPSSE": 150.0,
+}
+
+# ft2232h/ft232h: 60MHz / ((1 + divisor) * 2)
+MPSSE_CLOCK = 30000000
+
+# ethernet (interface_udp): 100MBit, preamble, headers, fcs and inter frame gap per frame
+ETH_SPEED = 100000000
+ETH_FRAME_OVERHEAD = 8 + 14 + 20 + 8 + 4 + 12
+
+SERVO_PERIODS = (1000000, 2000000, 4000000, 5000000, 10000000)
+
+# remaining loop gain at the total latency (used for the default P of closed loop joints)
+PID_LOOP_GAIN = 0.2
+
+
+class TimingError(Exception):
+    pass
+
+
+def native_udp(project):
+    """udp directly to the fpga (interface_udp) instead of the udp2spi bridge"""
+    return any(interface.get("type") == "udp" for interface in project["jdata"].get("interface", []))
+
+
+def mpsse_divisor(project, options=None):
+    """clock divisor of the MPSSE engine, the spi slave samples SCK with the fpga clock"""
+    if options is None:
+        options = project["jdata"].get("timing", {})
+    clock = int(project["jdata"]["clock"]["speed"])
+    # interface_spislave: SCK through 3 flip-flops, each SCK level has to be stable for more than 3 fpga clocks
+    max_clock = min(float(options.get("mpsse_clock", MPSSE_CLOCK)), clock / 8.0)
+    divisor = max(int(math.ceil(MPSSE_CLOCK / max_clock)) - 1, 0)
+    if divisor > 0xFFFF:
+        raise TimingError(f"mpsse clock ({max_clock / 1000000:.2f}MHz) is too slow")
+    return divisor
+
+
+def transfer_time(project, options=None):
+    """expected duration of one frame exchange in seconds"""
+    if options is None:
+        options = project["jdata"].get("timing", {})
+    transport = project["jdata"].get("transport", "SPI")
+    size = project["data_size"] // 8
+    overhead = float(options.get("overhead", OVERHEAD.get(transport, 0.0))) / 1000000.0
+
+    if transport == "SPI":
+        divider = int(options.get("spi_divider", 256))
+        clock = BCM2835_CORE_CLOCK / divider
+        # full duplex, byte by byte
+        return size * (8.0 / clock + overhead)
+    elif transport == "MPSSE":
+        clock = MPSSE_CLOCK / (mpsse_divisor(project, options) + 1)
+        # full duplex, one usb transfer per frame
+        return size * 8.0 / clock + overhead
+    elif transport == "SERIAL":
+        baud = int(project["jdata"]["interface"][0].get("baud", 1000000))
+        # 8N1, the fpga answers after the complete frame is received
+        return 2.0 * size * 10.0 / baud + overhead
+    elif transport == "UDP":
+        if native_udp(project):
+            overhead = float(options.get("overhead", OVERHEAD["UDP_NATIVE"])) / 1000000.0
+            # request and answer
+            return 2.0 * (max(size, 18) + ETH_FRAME_OVERHEAD) * 8.0 / ETH_SPEED + overhead
+        clock = int(options.get("bridge_clock", 2000000))
+        return size * 8.0 / clock + overhead
+    raise TimingError(f"unknown transport: {transport}")
+
+
+def model(project):
+    options = project["jdata"].get("timing", {})
+    transport = project["jdata"].get("transport", "SPI")
+    clock = int(project["jdata"]["clock"]["speed"])
+    max_load = float(options.get("max_load", 0.5))
+    transfer = transfer_time(project, options)
+    warnings = []
+
+    if transport == "SPI":
+        divider = int(options.get("spi_divider", 256))
+        if divider not in BCM2835_DIVIDERS:
+            raise TimingError(f"invalid spi_divider: {divider}")
+        spi_clock = BCM2835_CORE_CLOCK / divider
+        # the spi slave samples SCK with the system clock
+        if spi_clock * 4 > clock:
+            raise TimingError(f"spi clock ({spi_clock / 1000000:.2f}MHz) is too fast for the fpga clock ({clock / 1000000:.2f}MHz)")
+
+    if "servo_period" in options:
+        servo_period = int(options["servo_period"])
+        if transfer > servo_period / 1000000000.0 * max_load:
+            raise TimingError(
+                f"transfer time ({transfer * 1000000:.0f}us) does not fit into the servo period ({servo_period // 1000}us, max_load: {max_load})"
+            )
+    else:
+        for servo_period in SERVO_PERIODS:
+            if transfer <= servo_period / 1000000000.0 * max_load:
+                break
+        else:
+            raise TimingError(f"transfer time ({transfer * 1000000:.0f}us) is too long for all servo periods")
+        if servo_period != SERVO_PERIODS[0]:
+            warnings.append(
+                f"transfer time ({transfer * 1000000:.0f}us) does not fit into {SERVO_PERIODS[0] // 1000}us, using a servo period of {servo_period // 1000}us"
+            )
+
+    # rio.aux runs in its own thread, a multiple of the servo period
+    aux_period = options.get("aux_period")
+    if aux_period is not None:
+        aux_period = int(aux_period)
+        if aux_period < servo_period or aux_period % servo_period != 0:
+            raise TimingError(f"aux_period ({aux_period // 1000}us) must be a multiple of the servo period ({servo_period // 1000}us)")
+
+    # the feedback is one servo period plus the transfer old
+    latency = servo_period / 1000000000.0 + transfer
+    timeout_periods = int(options.get("timeout", 100))
+
+    return {
+        "transport": transport,
+        "transfer_time": transfer,
+        "servo_period": servo_period,
+        "aux_period": aux_period,
+        "load": transfer / (servo_period / 1000000000.0),
+        "latency": latency,
+        "timeout": int(clock * servo_period / 1000000000 * timeout_periods),
+        "spi_divider": int(options.get("spi_divider", 256)),
+        "mpsse_divisor": mpsse_divisor(project, options),
+        "pid_p": round(PID_LOOP_GAIN / latency, 1),
+        "pid_p_max": 0.5 / latency,
+        "warnings": warnings,
+    }